@@ -0,0 +1,287 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Microbenchmark of the sample conversion kernels.
+ *
+ * usage: FFmpegVidDecConvertBench [width height]
+ *
+ * Converts one picture of the given size (default 3840x2160) per iteration with every kernel of every instruction
+ * set the CPU supports, checks the result against the scalar kernel and reports the throughput in GB/s
+ * (bytes read plus bytes written per second).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "ffmpeg_vid_dec_convert.h"
+
+#define MIN_SECONDS 0.25
+
+typedef enum
+{
+	KERNEL_DEINTERLEAVE_U8 = 0,
+	KERNEL_DEINTERLEAVE_U16,
+	KERNEL_SHIFT_U16,
+	KERNEL_AVG2_U8,
+	KERNEL_AVG2_U16,
+	KERNEL_AVG4_U8,
+	KERNEL_AVG4_U16,
+	KERNEL_COUNT
+} kernel_t;
+
+static const char* kernel_names[ KERNEL_COUNT ] =
+{
+	"deinterleave_u8",
+	"deinterleave_u16",
+	"shift_u16",
+	"avg2_u8",
+	"avg2_u16",
+	"avg4_u8",
+	"avg4_u16"
+};
+
+typedef struct
+{
+	int32_t width;                      // output samples per row
+	int32_t height;                     // output rows
+	uint8_t *src;
+	uint8_t *dst[ 2 ];
+	size_t src_row;                     // bytes per source row
+	size_t dst_row;                     // bytes per destination row
+} bench_buffers_t;
+
+static double now( void )
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return ( double )counter.QuadPart / ( double )frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double )ts.tv_sec + ( double )ts.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+ * runs the kernel over a whole plane and returns the number of bytes read and written.
+ */
+static double run_kernel( const convert_kernels_t* kernels, kernel_t kernel, bench_buffers_t* buffers )
+{
+	int32_t n = buffers->width;
+	int32_t src_rows_per_row = ( kernel == KERNEL_AVG2_U8 || kernel == KERNEL_AVG2_U16 || kernel == KERNEL_AVG4_U8 || kernel == KERNEL_AVG4_U16 ) ? 2 : 1;
+	int32_t dst_planes = ( kernel == KERNEL_DEINTERLEAVE_U8 || kernel == KERNEL_DEINTERLEAVE_U16 ) ? 2 : 1;
+
+	for( int32_t y = 0; y < buffers->height; y++ )
+	{
+		const uint8_t* src0 = buffers->src + ( size_t )y * src_rows_per_row * buffers->src_row;
+		const uint8_t* src1 = src0 + buffers->src_row;
+		uint8_t* dst0 = buffers->dst[ 0 ] + ( size_t )y * buffers->dst_row;
+		uint8_t* dst1 = buffers->dst[ 1 ] + ( size_t )y * buffers->dst_row;
+
+		switch( kernel )
+		{
+		case KERNEL_DEINTERLEAVE_U8:
+			kernels->deinterleave_u8( src0, dst0, dst1, n );
+			break;
+		case KERNEL_DEINTERLEAVE_U16:
+			kernels->deinterleave_u16( ( const uint16_t* )src0, ( uint16_t* )dst0, ( uint16_t* )dst1, n, 6 );
+			break;
+		case KERNEL_SHIFT_U16:
+			kernels->shift_u16( ( const uint16_t* )src0, ( uint16_t* )dst0, n, 6 );
+			break;
+		case KERNEL_AVG2_U8:
+			kernels->avg2_u8( src0, src1, dst0, n );
+			break;
+		case KERNEL_AVG2_U16:
+			kernels->avg2_u16( ( const uint16_t* )src0, ( const uint16_t* )src1, ( uint16_t* )dst0, n );
+			break;
+		case KERNEL_AVG4_U8:
+			kernels->avg4_u8( src0, src1, dst0, n );
+			break;
+		case KERNEL_AVG4_U16:
+			kernels->avg4_u16( ( const uint16_t* )src0, ( const uint16_t* )src1, ( uint16_t* )dst0, n );
+			break;
+		default:
+			break;
+		}
+	}
+
+	return ( double )buffers->height * ( ( double )src_rows_per_row * buffers->src_row + ( double )dst_planes * buffers->dst_row );
+}
+
+static bool setup_buffers( bench_buffers_t* buffers, kernel_t kernel, int32_t width, int32_t height )
+{
+	size_t sample_size = ( kernel == KERNEL_DEINTERLEAVE_U8 || kernel == KERNEL_AVG2_U8 || kernel == KERNEL_AVG4_U8 ) ? 1 : 2;
+	size_t src_samples = ( kernel == KERNEL_SHIFT_U16 || kernel == KERNEL_AVG2_U8 || kernel == KERNEL_AVG2_U16 ) ? 1 : 2;
+	size_t src_size;
+
+	// chroma planes of a 4:2:0 picture of the given size
+	buffers->width = ( width + 1 ) / 2;
+	buffers->height = ( height + 1 ) / 2;
+	buffers->src_row = buffers->width * src_samples * sample_size;
+	buffers->dst_row = buffers->width * sample_size;
+
+	src_size = buffers->src_row * buffers->height * 2;
+	buffers->src = ( uint8_t* )malloc( src_size );
+	buffers->dst[ 0 ] = ( uint8_t* )malloc( buffers->dst_row * buffers->height );
+	buffers->dst[ 1 ] = ( uint8_t* )malloc( buffers->dst_row * buffers->height );
+	if( buffers->src == NULL || buffers->dst[ 0 ] == NULL || buffers->dst[ 1 ] == NULL )
+	{
+		return false;
+	}
+
+	// 12 bit samples for the 16 bit kernels
+	srand( 1 );
+	for( size_t i = 0; i < src_size; i++ )
+	{
+		buffers->src[ i ] = ( uint8_t )rand( );
+		if( sample_size == 2 && ( i & 1 ) != 0 )
+		{
+			buffers->src[ i ] &= 0x0F;
+		}
+	}
+
+	return true;
+}
+
+static void free_buffers( bench_buffers_t* buffers )
+{
+	free( buffers->src );
+	free( buffers->dst[ 0 ] );
+	free( buffers->dst[ 1 ] );
+}
+
+int main( int argc, char* argv[] )
+{
+	int32_t width = 3840;
+	int32_t height = 2160;
+	convert_isa_t best = convert_detect_isa( );
+	int result = 0;
+
+	if( argc == 3 )
+	{
+		width = atoi( argv[ 1 ] );
+		height = atoi( argv[ 2 ] );
+	}
+
+	if( width < 2 || height < 2 )
+	{
+		fprintf( stderr, "usage: %s [width height]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	printf( "picture %dx%d, best instruction set: %s\n\n", width, height, convert_isa_name( best ) );
+	printf( "%-18s %-8s %10s %10s\n", "kernel", "isa", "GB/s", "speedup" );
+
+	for( int32_t kernel = 0; kernel < KERNEL_COUNT; kernel++ )
+	{
+		bench_buffers_t buffers;
+		uint8_t* reference[ 2 ] = { NULL, NULL };
+		double c_rate = 0.0;
+
+		memset( &buffers, 0, sizeof( buffers ) );
+		if( setup_buffers( &buffers, ( kernel_t )kernel, width, height ) == false )
+		{
+			fprintf( stderr, "out of memory\n" );
+			free_buffers( &buffers );
+			return 1;
+		}
+
+		for( int32_t isa = CONVERT_ISA_C; isa <= ( int32_t )best; isa++ )
+		{
+			const convert_kernels_t* kernels = convert_get_kernels( ( convert_isa_t )isa );
+			double bytes = 0.0;
+			double start, elapsed;
+			int32_t iterations = 0;
+			size_t plane_size = buffers.dst_row * buffers.height;
+
+			memset( buffers.dst[ 0 ], 0, plane_size );
+			memset( buffers.dst[ 1 ], 0, plane_size );
+			run_kernel( kernels, ( kernel_t )kernel, &buffers );
+
+			if( isa == CONVERT_ISA_C )
+			{
+				reference[ 0 ] = ( uint8_t* )malloc( plane_size );
+				reference[ 1 ] = ( uint8_t* )malloc( plane_size );
+				if( reference[ 0 ] == NULL || reference[ 1 ] == NULL )
+				{
+					fprintf( stderr, "out of memory\n" );
+					return 1;
+				}
+				memcpy( reference[ 0 ], buffers.dst[ 0 ], plane_size );
+				memcpy( reference[ 1 ], buffers.dst[ 1 ], plane_size );
+			}
+			else if( memcmp( reference[ 0 ], buffers.dst[ 0 ], plane_size ) != 0 || memcmp( reference[ 1 ], buffers.dst[ 1 ], plane_size ) != 0 )
+			{
+				printf( "%-18s %-8s MISMATCH\n", kernel_names[ kernel ], convert_isa_name( ( convert_isa_t )isa ) );
+				result = 1;
+				continue;
+			}
+
+			start = now( );
+			do
+			{
+				bytes += run_kernel( kernels, ( kernel_t )kernel, &buffers );
+				iterations++;
+				elapsed = now( ) - start;
+			} while( elapsed < MIN_SECONDS || iterations < 3 );
+
+			if( isa == CONVERT_ISA_C )
+			{
+				c_rate = bytes / elapsed;
+			}
+
+			printf( "%-18s %-8s %10.2f %9.2fx\n", kernel_names[ kernel ], convert_isa_name( ( convert_isa_t )isa ),
+				bytes / elapsed * 1e-9, bytes / elapsed / c_rate );
+		}
+
+		free( reference[ 0 ] );
+		free( reference[ 1 ] );
+		free_buffers( &buffers );
+	}
+
+	return result;
+}
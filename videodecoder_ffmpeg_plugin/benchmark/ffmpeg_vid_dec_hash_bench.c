@@ -0,0 +1,218 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Microbenchmark of the picture hash.
+ *
+ * usage: FFmpegVidDecHashBench [width height [bit_depth]]
+ *
+ * Hashes the three planes of a 4:2:0 picture of the given size (default 3840x2160, 10 bits) with padded strides, as
+ * the plugin does for FFMPEG_VID_DEC_OPT_HASH, with every instruction set the CPU supports. Checks the hashes against
+ * the scalar code and reports the throughput in GB/s of visible samples and in pictures per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "ffmpeg_vid_dec_hash.h"
+
+#define MIN_SECONDS 0.5
+#define STRIDE_PADDING 64
+
+typedef struct
+{
+	uint8_t *data;
+	size_t row_size;                    // visible bytes per row
+	ptrdiff_t stride;
+	int32_t rows;
+} bench_plane_t;
+
+static double now( void )
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return ( double )counter.QuadPart / ( double )frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double )ts.tv_sec + ( double )ts.tv_nsec * 1e-9;
+#endif
+}
+
+static bool setup_plane( bench_plane_t* plane, int32_t width, int32_t height, int32_t sample_size, int32_t bit_depth )
+{
+	size_t size;
+
+	plane->row_size = ( size_t )width * sample_size;
+	plane->stride = ( ptrdiff_t )( ( plane->row_size + 63 ) / 64 * 64 + STRIDE_PADDING );
+	plane->rows = height;
+
+	size = ( size_t )plane->stride * height;
+	plane->data = ( uint8_t* )malloc( size );
+	if( plane->data == NULL )
+	{
+		return false;
+	}
+
+	// samples of the given bit depth, padding of the stride differs from the samples
+	for( size_t i = 0; i < size; i++ )
+	{
+		plane->data[ i ] = ( uint8_t )rand( );
+		if( sample_size == 2 && ( i & 1 ) != 0 )
+		{
+			plane->data[ i ] &= ( uint8_t )( ( 1 << ( bit_depth - 8 ) ) - 1 );
+		}
+	}
+
+	return true;
+}
+
+int main( int argc, char* argv[] )
+{
+	int32_t width = 3840;
+	int32_t height = 2160;
+	int32_t bit_depth = 10;
+	int32_t sample_size;
+	convert_isa_t best = convert_detect_isa( );
+	bench_plane_t planes[ 3 ];
+	uint64_t reference[ 3 ] = { 0 };
+	double picture_bytes = 0.0;
+	double c_rate = 0.0;
+	int result = 0;
+
+	if( argc >= 3 )
+	{
+		width = atoi( argv[ 1 ] );
+		height = atoi( argv[ 2 ] );
+	}
+	if( argc >= 4 )
+	{
+		bit_depth = atoi( argv[ 3 ] );
+	}
+
+	if( width < 2 || height < 2 || bit_depth < 8 || bit_depth > 16 )
+	{
+		fprintf( stderr, "usage: %s [width height [bit_depth]]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	sample_size = bit_depth > 8 ? 2 : 1;
+
+	memset( planes, 0, sizeof( planes ) );
+	srand( 1 );
+	for( int32_t i = 0; i < 3; i++ )
+	{
+		int32_t plane_width = i == 0 ? width : ( width + 1 ) / 2;
+		int32_t plane_height = i == 0 ? height : ( height + 1 ) / 2;
+
+		if( setup_plane( &planes[ i ], plane_width, plane_height, sample_size, bit_depth ) == false )
+		{
+			fprintf( stderr, "out of memory\n" );
+			return 1;
+		}
+		picture_bytes += ( double )planes[ i ].row_size * planes[ i ].rows;
+	}
+
+	printf( "picture %dx%d, %d bits, best instruction set: %s\n\n", width, height, bit_depth, convert_isa_name( best ) );
+	printf( "%-8s %10s %12s %10s\n", "isa", "GB/s", "pictures/s", "speedup" );
+
+	for( int32_t isa = CONVERT_ISA_C; isa <= ( int32_t )best; isa++ )
+	{
+		const hash_kernels_t* kernels = hash_get_kernels( ( convert_isa_t )isa );
+		int32_t iterations = 0;
+		double start, elapsed, rate;
+		bool match = true;
+
+		for( int32_t i = 0; i < 3; i++ )
+		{
+			uint64_t hash = hash_plane( kernels, planes[ i ].data, planes[ i ].stride, planes[ i ].row_size, planes[ i ].rows );
+
+			if( isa == CONVERT_ISA_C )
+			{
+				reference[ i ] = hash;
+			}
+			else if( hash != reference[ i ] )
+			{
+				match = false;
+			}
+		}
+
+		if( match == false )
+		{
+			printf( "%-8s MISMATCH\n", convert_isa_name( ( convert_isa_t )isa ) );
+			result = 1;
+			continue;
+		}
+
+		start = now( );
+		do
+		{
+			for( int32_t i = 0; i < 3; i++ )
+			{
+				hash_plane( kernels, planes[ i ].data, planes[ i ].stride, planes[ i ].row_size, planes[ i ].rows );
+			}
+			iterations++;
+			elapsed = now( ) - start;
+		} while( elapsed < MIN_SECONDS || iterations < 3 );
+
+		rate = picture_bytes * iterations / elapsed;
+		if( isa == CONVERT_ISA_C )
+		{
+			c_rate = rate;
+		}
+
+		printf( "%-8s %10.2f %12.1f %9.2fx\n", convert_isa_name( ( convert_isa_t )isa ), rate * 1e-9, iterations / elapsed, rate / c_rate );
+	}
+
+	printf( "\nhashes %016llx %016llx %016llx\n", ( unsigned long long )reference[ 0 ], ( unsigned long long )reference[ 1 ],
+		( unsigned long long )reference[ 2 ] );
+
+	for( int32_t i = 0; i < 3; i++ )
+	{
+		free( planes[ i ].data );
+	}
+
+	return result;
+}
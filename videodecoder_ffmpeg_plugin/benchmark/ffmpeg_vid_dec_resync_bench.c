@@ -0,0 +1,465 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Benchmark of the recovery from bitstream corruption with and without the resync policy.
+ *
+ * usage: FFmpegVidDecResyncBench stream [trials [bytes]]
+ *
+ * Splits the HEVC Annex-B stream into access units and decodes it once as reference. Every trial (default 20)
+ * overwrites bytes (default 16) in the slice data of an access unit that is no key picture and decodes the corrupted
+ * stream with the resync policies "off" and "key". The stream is recovered at the first access unit in decoding order
+ * from which on every picture is output and equal to the reference. Reports per policy the access units and the time
+ * from passing the corrupted access unit to the first recovered picture, and the pictures that were output corrupted
+ * or not output before.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_au_splitter.h"
+#include "ffmpeg_vid_dec_nal.h"
+
+typedef struct
+{
+	uint8_t *data;
+	uint32_t size;
+	nal_picture_kind_t kind;
+} bench_au_t;
+
+typedef struct
+{
+	bench_au_t *aus;
+	int32_t count;
+	int32_t capacity;
+} bench_stream_t;
+
+typedef struct
+{
+	uint64_t *hashes;                   // per access unit in decoding order (the pts passed), 0 while not output
+	double *times;                      // output time per access unit
+	int32_t count;
+} bench_output_t;
+
+typedef struct
+{
+	int32_t trials;
+	int64_t units;
+	double seconds;
+	int32_t max_units;
+	double max_seconds;
+	int64_t corrupted;
+	int64_t missing;
+	int32_t unrecovered;
+} bench_result_t;
+
+static double now( void )
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return ( double )counter.QuadPart / ( double )frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double )ts.tv_sec + ( double )ts.tv_nsec * 1e-9;
+#endif
+}
+
+static uint32_t random_state = 2463534242u;
+
+static uint32_t next_random( void )
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+
+	return random_state;
+}
+
+static void add_access_unit( void* opaque, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	bench_stream_t* stream = ( bench_stream_t* )opaque;
+	bench_au_t* au;
+
+	( void )pts;
+	( void )dts;
+
+	if( stream->count == stream->capacity )
+	{
+		int32_t capacity = stream->capacity ? stream->capacity * 2 : 1024;
+		bench_au_t* aus = ( bench_au_t* )realloc( stream->aus, sizeof( bench_au_t ) * capacity );
+
+		if( aus == NULL )
+		{
+			return;
+		}
+		stream->aus = aus;
+		stream->capacity = capacity;
+	}
+
+	au = &stream->aus[ stream->count ];
+	au->data = ( uint8_t* )malloc( size );
+	if( au->data == NULL )
+	{
+		return;
+	}
+	memcpy( au->data, data, size );
+	au->size = size;
+	au->kind = nal_classify_picture( NAL_CODEC_HEVC, data, size );
+	stream->count++;
+}
+
+static bool read_stream( const char* path, bench_stream_t* stream )
+{
+	au_splitter_t* splitter = au_splitter_create( NAL_CODEC_HEVC );
+	FILE* file = fopen( path, "rb" );
+	uint8_t chunk[ 65536 ];
+	size_t size;
+
+	memset( stream, 0, sizeof( bench_stream_t ) );
+
+	if( splitter == NULL || file == NULL )
+	{
+		au_splitter_release( &splitter );
+		if( file != NULL )
+		{
+			fclose( file );
+		}
+		return false;
+	}
+
+	while( ( size = fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+	{
+		au_splitter_push( splitter, chunk, ( uint32_t )size, AU_SPLITTER_NO_TIMESTAMP, AU_SPLITTER_NO_TIMESTAMP, add_access_unit, stream );
+	}
+	au_splitter_flush( splitter, add_access_unit, stream );
+
+	au_splitter_release( &splitter );
+	fclose( file );
+
+	return stream->count > 0;
+}
+
+static uint64_t hash_plane( uint64_t hash, const uint8_t* data, int32_t stride, int32_t width, int32_t height )
+{
+	for( int32_t y = 0; y < height; y++ )
+	{
+		for( int32_t x = 0; x < width; x++ )
+		{
+			hash = ( hash ^ data[ x ] ) * 0x100000001b3ULL;
+		}
+		data += stride;
+	}
+
+	return hash;
+}
+
+static void on_picture( dvpd_input_dec_picture_t* picture, void* app_data, int32_t layer )
+{
+	bench_output_t* output = ( bench_output_t* )app_data;
+	int32_t bytes = picture->bit_depth > 8 ? 2 : 1;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int64_t index = picture->pts;
+
+	( void )layer;
+
+	if( index < 0 || index >= output->count )
+	{
+		return;
+	}
+
+	// planar 4:2:0
+	hash = hash_plane( hash, picture->data[ 0 ], picture->stride[ 0 ], picture->width * bytes, picture->height );
+	hash = hash_plane( hash, picture->data[ 1 ], picture->stride[ 1 ], picture->width / 2 * bytes, picture->height / 2 );
+	hash = hash_plane( hash, picture->data[ 2 ], picture->stride[ 2 ], picture->width / 2 * bytes, picture->height / 2 );
+
+	output->hashes[ index ] = hash | 1;
+	output->times[ index ] = now( );
+}
+
+static bool decode_stream( dv_dec_video_dec_plugin_t* plugin, const bench_stream_t* stream, const char* resync,
+	bench_output_t* output, double* feed_times )
+{
+	dvpd_input_dec_if_t* dec_if = &plugin->vid_dec_if;
+	dvpd_input_dec_handle_t h_dec = dec_if->create( );
+
+	if( h_dec == NULL )
+	{
+		return false;
+	}
+
+	memset( output->hashes, 0, sizeof( uint64_t ) * output->count );
+	memset( output->times, 0, sizeof( double ) * output->count );
+
+	if( dec_if->set_option( h_dec, "resync", resync ) == false || dec_if->init( h_dec, on_picture, output, 0 ) == false )
+	{
+		dec_if->destroy( &h_dec );
+		return false;
+	}
+
+	for( int32_t i = 0; i < stream->count; i++ )
+	{
+		feed_times[ i ] = now( );
+		dec_if->decode( h_dec, stream->aus[ i ].data, stream->aus[ i ].size, ( uint64_t )i, ( uint64_t )i );
+	}
+	dec_if->flush( h_dec, false );
+
+	dec_if->deinit( h_dec );
+	dec_if->destroy( &h_dec );
+
+	return true;
+}
+
+/*
+ * finds the first access unit from which on all pictures equal the reference and accounts the damage before.
+ */
+static void evaluate( const bench_output_t* reference, const bench_output_t* output, const double* feed_times, int32_t corrupted,
+	bench_result_t* result )
+{
+	int32_t recovered = reference->count;
+	double first = 0;
+	int32_t units;
+	double seconds;
+
+	for( int32_t i = reference->count - 1; i >= corrupted; i-- )
+	{
+		if( output->hashes[ i ] != reference->hashes[ i ] )
+		{
+			break;
+		}
+		recovered = i;
+	}
+
+	if( recovered == reference->count )
+	{
+		result->unrecovered++;
+		return;
+	}
+
+	// the pictures are output in presentation order, the recovered picture output first ends the damage
+	for( int32_t i = recovered; i < reference->count; i++ )
+	{
+		if( reference->hashes[ i ] != 0 && ( first == 0 || output->times[ i ] < first ) )
+		{
+			first = output->times[ i ];
+		}
+	}
+
+	for( int32_t i = corrupted; i < recovered; i++ )
+	{
+		if( reference->hashes[ i ] == 0 )
+		{
+			continue;
+		}
+
+		if( output->hashes[ i ] == 0 )
+		{
+			result->missing++;
+		}
+		else if( output->hashes[ i ] != reference->hashes[ i ] )
+		{
+			result->corrupted++;
+		}
+	}
+
+	units = recovered - corrupted;
+	seconds = first > feed_times[ corrupted ] ? first - feed_times[ corrupted ] : 0;
+
+	result->trials++;
+	result->units += units;
+	result->seconds += seconds;
+	if( units > result->max_units )
+	{
+		result->max_units = units;
+	}
+	if( seconds > result->max_seconds )
+	{
+		result->max_seconds = seconds;
+	}
+}
+
+static void print_result( const char* resync, const bench_result_t* result )
+{
+	int32_t trials = result->trials > 0 ? result->trials : 1;
+
+	printf( "%-8s %8d %12.1f %10d %12.2f %12.2f %10.1f %10.1f %12d\n", resync, result->trials, ( double )result->units / trials,
+		result->max_units, result->seconds * 1000 / trials, result->max_seconds * 1000, ( double )result->corrupted / trials,
+		( double )result->missing / trials, result->unrecovered );
+}
+
+int main( int argc, char* argv[] )
+{
+	static const char* policies[] = { "off", "key" };
+	dv_dec_video_dec_plugin_t plugin;
+	bench_result_t results[ 2 ];
+	bench_stream_t stream;
+	bench_output_t reference;
+	bench_output_t output;
+	double* feed_times;
+	int32_t trials = argc > 2 ? atoi( argv[ 2 ] ) : 20;
+	int32_t bytes = argc > 3 ? atoi( argv[ 3 ] ) : 16;
+	int32_t last_key = 0;
+	bool candidates = false;
+
+	if( argc < 2 || trials < 1 || bytes < 1 )
+	{
+		fprintf( stderr, "usage: %s stream [trials [bytes]]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	if( read_stream( argv[ 1 ], &stream ) == false )
+	{
+		fprintf( stderr, "could not read access units from %s\n", argv[ 1 ] );
+		return 1;
+	}
+
+	memset( &plugin, 0, sizeof( plugin ) );
+	plugin.dv_plugin_api_version = DV_PLUGIN_API_VERSION;
+	dv_dec_vid_dec_plugin_describe_version( &plugin, DV_PLUGIN_API_VERSION );
+
+	reference.count = output.count = stream.count;
+	reference.hashes = ( uint64_t* )malloc( sizeof( uint64_t ) * stream.count );
+	reference.times = ( double* )malloc( sizeof( double ) * stream.count );
+	output.hashes = ( uint64_t* )malloc( sizeof( uint64_t ) * stream.count );
+	output.times = ( double* )malloc( sizeof( double ) * stream.count );
+	feed_times = ( double* )malloc( sizeof( double ) * stream.count );
+	if( reference.hashes == NULL || reference.times == NULL || output.hashes == NULL || output.times == NULL || feed_times == NULL )
+	{
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	if( decode_stream( &plugin, &stream, "off", &reference, feed_times ) == false )
+	{
+		fprintf( stderr, "could not decode %s\n", argv[ 1 ] );
+		return 1;
+	}
+
+	// corrupts pictures that are followed by a key picture
+	for( int32_t i = 0; i < stream.count; i++ )
+	{
+		if( stream.aus[ i ].kind == NAL_PICTURE_KEY )
+		{
+			last_key = i;
+		}
+	}
+
+	for( int32_t i = 1; i < last_key; i++ )
+	{
+		if( stream.aus[ i ].kind == NAL_PICTURE_REFERENCE || stream.aus[ i ].kind == NAL_PICTURE_NON_REFERENCE )
+		{
+			candidates = true;
+		}
+	}
+
+	if( candidates == false )
+	{
+		fprintf( stderr, "the stream needs pictures followed by a key picture\n" );
+		return 1;
+	}
+
+	memset( results, 0, sizeof( results ) );
+
+	for( int32_t t = 0; t < trials; t++ )
+	{
+		int32_t corrupted;
+		bench_au_t* au;
+		uint8_t* original;
+
+		do
+		{
+			corrupted = 1 + ( int32_t )( next_random( ) % ( uint32_t )( last_key - 1 ) );
+		}
+		while( stream.aus[ corrupted ].kind == NAL_PICTURE_KEY || stream.aus[ corrupted ].kind == NAL_PICTURE_NONE );
+
+		au = &stream.aus[ corrupted ];
+		original = ( uint8_t* )malloc( au->size );
+		if( original == NULL )
+		{
+			return 1;
+		}
+		memcpy( original, au->data, au->size );
+
+		// the second half of the access unit is slice data
+		for( int32_t i = 0; i < bytes; i++ )
+		{
+			au->data[ au->size / 2 + next_random( ) % ( au->size - au->size / 2 ) ] = ( uint8_t )next_random( );
+		}
+
+		for( int32_t p = 0; p < 2; p++ )
+		{
+			if( decode_stream( &plugin, &stream, policies[ p ], &output, feed_times ) == true )
+			{
+				evaluate( &reference, &output, feed_times, corrupted, &results[ p ] );
+			}
+		}
+
+		memcpy( au->data, original, au->size );
+		free( original );
+	}
+
+	printf( "%d access units, %d trials, %d bytes corrupted per trial\n\n", stream.count, trials, bytes );
+	printf( "%-8s %8s %12s %10s %12s %12s %10s %10s %12s\n", "resync", "trials", "units", "max units", "ms", "max ms",
+		"corrupted", "missing", "unrecovered" );
+	for( int32_t p = 0; p < 2; p++ )
+	{
+		print_result( policies[ p ], &results[ p ] );
+	}
+
+	for( int32_t i = 0; i < stream.count; i++ )
+	{
+		free( stream.aus[ i ].data );
+	}
+	free( stream.aus );
+	free( reference.hashes );
+	free( reference.times );
+	free( output.hashes );
+	free( output.times );
+	free( feed_times );
+
+	return 0;
+}
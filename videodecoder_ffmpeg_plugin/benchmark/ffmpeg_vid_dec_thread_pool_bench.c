@@ -0,0 +1,267 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of the shared thread pool against a thread pool per instance.
+ *
+ * usage: FFmpegVidDecThreadPoolBench [instances [pictures [jobs [work]]]]
+ *
+ * Runs the given number of instances (default 10) on their own threads. Every instance decodes pictures (default 200)
+ * consisting of a batch of jobs (default 34, the wavefront rows of a 2160p HEVC picture) of synthetic work (default
+ * 20000 iterations per job), the way slice threading of libavcodec does. With "instance" pools, every instance runs
+ * its batches on a pool of its own with a thread per CPU core (at most 16), like the slice threads libavcodec starts
+ * per decoder. With the "shared" pool, all instances run their batches on one pool with a thread per CPU core.
+ * Reports the aggregate throughput, the slowest and fastest instance and the number of threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "ffmpeg_vid_dec_thread.h"
+#include "ffmpeg_vid_dec_thread_pool.h"
+
+#define MAX_INSTANCES 256
+
+typedef struct
+{
+	thread_pool_t *pool;
+	int32_t slots;
+	int32_t pictures;
+	int32_t jobs;
+	int32_t work;
+	int *results;
+	vid_dec_thread_t thread;
+	double seconds;
+} bench_instance_t;
+
+static double now( void )
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return ( double )counter.QuadPart / ( double )frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double )ts.tv_sec + ( double )ts.tv_nsec * 1e-9;
+#endif
+}
+
+static int32_t get_cores( void )
+{
+#if defined(_WIN32)
+	SYSTEM_INFO sysinfo;
+
+	GetSystemInfo( &sysinfo );
+	return ( int32_t )sysinfo.dwNumberOfProcessors;
+#else
+	long cores = sysconf( _SC_NPROCESSORS_ONLN );
+
+	return cores > 0 ? ( int32_t )cores : 1;
+#endif
+}
+
+static int run_job( void* arg, int32_t job, int32_t slot )
+{
+	bench_instance_t* instance = ( bench_instance_t* )arg;
+	uint32_t state = ( uint32_t )job * 2654435761u + 1;
+
+	( void )slot;
+
+	for( int32_t i = 0; i < instance->work; i++ )
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+	}
+
+	return ( int )( state & 0x7fffffff );
+}
+
+static VID_DEC_THREAD_FUNC( run_instance, arg )
+{
+	bench_instance_t* instance = ( bench_instance_t* )arg;
+	double start = now( );
+
+	for( int32_t i = 0; i < instance->pictures; i++ )
+	{
+		thread_pool_run( instance->pool, run_job, instance, instance->results, instance->jobs, instance->slots );
+	}
+
+	instance->seconds = now( ) - start;
+
+	return VID_DEC_THREAD_EXIT;
+}
+
+/*
+ * runs all instances at the same time, on one shared pool or on a pool each. Returns false if a pool or thread could
+ * not be created.
+ */
+static bool run_bench( bench_instance_t* instances, int32_t count, bool shared, int32_t cores, int32_t slots )
+{
+	thread_pool_t* shared_pool = NULL;
+	int32_t threads = count;
+	double start, elapsed;
+	bool ok = true;
+
+	if( shared == true )
+	{
+		shared_pool = thread_pool_create( cores );
+		if( shared_pool == NULL )
+		{
+			return false;
+		}
+		threads += cores;
+	}
+
+	for( int32_t i = 0; i < count; i++ )
+	{
+		// the caller takes part in its batches
+		instances[ i ].pool = shared_pool != NULL ? shared_pool : thread_pool_create( slots - 1 );
+		instances[ i ].slots = slots;
+		if( instances[ i ].pool == NULL )
+		{
+			ok = false;
+		}
+		if( shared == false )
+		{
+			threads += slots - 1;
+		}
+	}
+
+	start = now( );
+	for( int32_t i = 0; i < count && ok == true; i++ )
+	{
+		if( vid_dec_thread_create( &instances[ i ].thread, run_instance, &instances[ i ] ) == false )
+		{
+			fprintf( stderr, "could not start instance %d\n", i );
+			exit( 1 );
+		}
+	}
+
+	for( int32_t i = 0; i < count && ok == true; i++ )
+	{
+		vid_dec_thread_join( instances[ i ].thread );
+	}
+	elapsed = now( ) - start;
+
+	if( ok == true )
+	{
+		double rate_min = 1e30;
+		double rate_max = 0.0;
+
+		for( int32_t i = 0; i < count; i++ )
+		{
+			double rate = instances[ i ].pictures / instances[ i ].seconds;
+
+			rate_min = rate < rate_min ? rate : rate_min;
+			rate_max = rate > rate_max ? rate : rate_max;
+		}
+
+		printf( "%-10s %8d %14.1f %14.1f %14.1f %14.1f\n", shared ? "shared" : "instance", threads,
+			( double )count * instances[ 0 ].pictures / elapsed, ( double )count * instances[ 0 ].pictures * instances[ 0 ].jobs / elapsed,
+			rate_min, rate_max );
+	}
+
+	for( int32_t i = 0; i < count; i++ )
+	{
+		if( shared == false )
+		{
+			thread_pool_release( &instances[ i ].pool );
+		}
+		instances[ i ].pool = NULL;
+	}
+	thread_pool_release( &shared_pool );
+
+	return ok;
+}
+
+int main( int argc, char* argv[] )
+{
+	bench_instance_t instances[ MAX_INSTANCES ];
+	int32_t count = argc > 1 ? atoi( argv[ 1 ] ) : 10;
+	int32_t pictures = argc > 2 ? atoi( argv[ 2 ] ) : 200;
+	int32_t jobs = argc > 3 ? atoi( argv[ 3 ] ) : 34;
+	int32_t work = argc > 4 ? atoi( argv[ 4 ] ) : 20000;
+	int32_t cores = get_cores( );
+	int32_t slots = cores > 16 ? 16 : cores;
+	int result = 0;
+
+	if( count < 1 || count > MAX_INSTANCES || pictures < 1 || jobs < 1 || work < 0 )
+	{
+		fprintf( stderr, "usage: %s [instances [pictures [jobs [work]]]]\n", argv[ 0 ] );
+		return 1;
+	}
+
+	memset( instances, 0, sizeof( instances ) );
+	for( int32_t i = 0; i < count; i++ )
+	{
+		instances[ i ].pictures = pictures;
+		instances[ i ].jobs = jobs;
+		instances[ i ].work = work;
+		instances[ i ].results = ( int* )malloc( jobs * sizeof( int ) );
+		if( instances[ i ].results == NULL )
+		{
+			fprintf( stderr, "out of memory\n" );
+			return 1;
+		}
+	}
+
+	printf( "%d instances, %d pictures of %d jobs each, %d cores, %d slots per instance\n\n", count, pictures, jobs, cores, slots );
+	printf( "%-10s %8s %14s %14s %14s %14s\n", "pool", "threads", "pictures/s", "jobs/s", "slowest pic/s", "fastest pic/s" );
+
+	if( run_bench( instances, count, false, cores, slots ) == false || run_bench( instances, count, true, cores, slots ) == false )
+	{
+		fprintf( stderr, "could not create the thread pools\n" );
+		result = 1;
+	}
+
+	for( int32_t i = 0; i < count; i++ )
+	{
+		free( instances[ i ].results );
+	}
+
+	return result;
+}
@@ -60,7 +60,7 @@ typedef int bool;
 extern "C" {
 #endif
 
-	#define DV_PLUGIN_API_VERSION 0
+	#define DV_PLUGIN_API_VERSION 2
 
 /*!
 	dvpd_input_dec_picture_t
@@ -82,6 +82,80 @@ extern "C" {
 		                                         a way to access extra information like SPS or PPS  */
 	} dvpd_input_dec_picture_t;
 
+	/*!
+	dvpd_input_dec_chunk_t
+	@brief a bitstream chunk with its timestamps as passed to dvpd_input_dec_if_t::decode_batch.\n
+	*/
+	typedef struct
+	{
+		uint8_t *data;                      /**< @details pointer to the bitstream data */
+		uint32_t size;                      /**< @details length of the valid data */
+		uint64_t pts;                       /**< @details presentation time stamp, see dvpd_input_dec_if_t::decode */
+		uint64_t dts;                       /**< @details decoding time stamp, see dvpd_input_dec_if_t::decode */
+	} dvpd_input_dec_chunk_t;
+
+	/*!
+	dvpd_input_dec_drop_reason_t
+	@brief reasons for decoded pictures not being passed to the picture callback.\n
+	*/
+	typedef enum
+	{
+		DVPD_INPUT_DEC_DROP_FORMAT = 0,     /**< @details the output format of the decoder is not supported */
+		DVPD_INPUT_DEC_DROP_MEMORY,         /**< @details the picture could not be handed over because of a failed allocation */
+		DVPD_INPUT_DEC_DROP_COUNT
+	} dvpd_input_dec_drop_reason_t;
+
+	#define DVPD_INPUT_DEC_LATENCY_BUCKETS 24
+
+	/*!
+	DVPD_INPUT_DEC_RECEIVE_*
+	@brief results of dvpd_input_dec_if_t::receive_picture.\n
+	*/
+	#define DVPD_INPUT_DEC_RECEIVE_ERROR    -1  /**< @details invalid handle, or the instance does not output pictures to receive_picture */
+	#define DVPD_INPUT_DEC_RECEIVE_OK        0  /**< @details a picture was returned */
+	#define DVPD_INPUT_DEC_RECEIVE_AGAIN     1  /**< @details no picture became available within the timeout */
+	#define DVPD_INPUT_DEC_RECEIVE_EOF       2  /**< @details all pictures before the last flush have been returned */
+
+	/*!
+	dvpd_input_dec_stats_t
+	@brief performance counters of a video decoder instance (see dvpd_input_dec_if_t::get_stats).\n
+	All counters start at zero when the instance gets initialized. Latency histograms count events per power of two
+	microseconds: bucket 0 holds latencies below 1 us, bucket i latencies of at least 2^(i-1) and below 2^i us, the last
+	bucket everything longer.
+	*/
+	typedef struct
+	{
+		uint32_t size;                      /**< @details set by the caller to sizeof(dvpd_input_dec_stats_t), the plugin only fills members within size */
+
+		int64_t packets_in;                 /**< @details bitstream chunks passed to decode */
+		int64_t bytes_in;                   /**< @details bytes passed to decode */
+		int64_t packets_discarded;          /**< @details chunks dropped undecoded by a discarding flush */
+		int64_t packets_decoded;            /**< @details chunks accepted by the decoder */
+		int64_t bytes_decoded;              /**< @details bytes accepted by the decoder */
+		int64_t send_errors;                /**< @details chunks rejected by the decoder */
+		int64_t receive_errors;             /**< @details errors reported by the decoder while returning pictures */
+
+		int64_t frames_decoded;             /**< @details pictures returned by the decoder */
+		int64_t frames_out;                 /**< @details pictures passed to the picture callback */
+		int64_t frames_dropped[ DVPD_INPUT_DEC_DROP_COUNT ]; /**< @details pictures dropped, by dvpd_input_dec_drop_reason_t */
+
+		int64_t decode_time_us;             /**< @details time spent in the decoder, without picture callbacks */
+		int64_t callback_time_us;           /**< @details time spent in picture callbacks */
+		int64_t decode_latency[ DVPD_INPUT_DEC_LATENCY_BUCKETS ];   /**< @details decoder time per chunk */
+		int64_t callback_latency[ DVPD_INPUT_DEC_LATENCY_BUCKETS ]; /**< @details time per picture callback */
+
+		int64_t frames_skipped;             /**< @details pictures not decoded or not output because of a plugin specific decode mode or error policy */
+
+		int64_t memory_bytes;               /**< @details memory currently accounted to the instance, the scope is plugin specific */
+		int64_t memory_peak_bytes;          /**< @details maximum of memory_bytes */
+
+		int64_t resyncs;                    /**< @details recoveries from decoding errors at a key picture, with a plugin specific error policy */
+		int64_t resync_packets_dropped;     /**< @details chunks dropped while waiting for a key picture */
+		int64_t resync_time_us;             /**< @details time from the decoding errors to the first picture decoded after the key pictures */
+
+		int64_t format_changes;             /**< @details changes of the picture size or format within the stream */
+	} dvpd_input_dec_stats_t;
+
 	/*!
 	dvpd_input_dec_handle_t
 	@brief video decoder handle.\n
@@ -192,8 +266,119 @@ extern "C" {
 			@li = false    non-initialized state (not ready)
 		*/
 		bool( *is_init ) (dvpd_input_dec_handle_t h_dec );
+
+		/* the following functions are only available from DV_PLUGIN_API_VERSION 1 on (see dv_dec_video_dec_plugin_t) */
+
+		/*!
+		set_option
+		@brief
+		sets an implementation specific option of the underlying video decoder instance.
+		Options are identified by name; the available options and their values are documented by the plugin.
+		Unless documented otherwise, an option has to be set before the instance gets initialized.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [in]  name name of the option.
+		@param [in]  value value of the option as string.
+		@return
+			@li = true     success
+			@li = false    unknown option, invalid value or the option can not be changed in the current state
+		*/
+		bool( *set_option ) (dvpd_input_dec_handle_t h_dec, const char *name, const char *value );
+
+		/*!
+		release_picture
+		@brief
+		releases a decoded picture which the video decoder handed over to the caller.
+		If the video decoder hands over the ownership of its decoded pictures (plugin specific option), the image data of a picture stays valid
+		after the picture callback returned, until the picture is passed to this function. Pictures may be released from any thread.
+		@param [in]  h_dec handle to the video decoder instance that produced the picture.
+		@param [in]  dec_picture the decoded picture as passed to the picture callback.
+		*/
+		void( *release_picture ) (dvpd_input_dec_handle_t h_dec, dvpd_input_dec_picture_t *dec_picture );
+
+		/*!
+		get_input_buffer
+		@brief
+		provides a buffer owned by the underlying video decoder instance which the caller can fill with bitstream data.
+		If the data pointer passed to decode lies within such a buffer, the video decoder takes over the buffer instead of
+		copying the data. Every buffer must be passed to decode once, or it stays allocated until the instance is deinitialized.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [in]  size number of bytes the caller intends to write.
+		@return pointer to at least size writable bytes, NULL if no buffer is available (the caller then uses its own buffer)
+		*/
+		uint8_t*( *get_input_buffer ) (dvpd_input_dec_handle_t h_dec, uint32_t size );
+
+		/* the following functions are only available from DV_PLUGIN_API_VERSION 2 on (see dv_dec_video_dec_plugin_t) */
+
+		/*!
+		get_stats
+		@brief
+		reads the performance counters of the underlying video decoder instance. Can be called from any thread at any time,
+		the counters are read without stopping the decoder, so counters updated concurrently may be off by a few events.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [out] stats counters of the instance. stats->size has to be set by the caller.
+		@return
+			@li = true     success
+			@li = false    invalid handle or size
+		*/
+		bool( *get_stats ) (dvpd_input_dec_handle_t h_dec, dvpd_input_dec_stats_t *stats );
+
+		/*!
+		decode_batch
+		@brief
+		feeds several bitstream chunks to the underlying video decoder instance, with the same result as calling decode for each
+		of them in order. Only available if the plugin reports DVPD_VID_DEC_CAP_DECODE_BATCH.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [in]  chunks array of bitstream chunks in decoding order. The data only has to stay valid during the call.
+		@param [in]  count number of chunks.
+		*/
+		void( *decode_batch ) (dvpd_input_dec_handle_t h_dec, const dvpd_input_dec_chunk_t *chunks, uint32_t count );
+
+		/*!
+		get_option
+		@brief
+		reads the current value of an implementation specific option or a read-only property of the underlying video decoder
+		instance. The available names are documented by the plugin.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [in]  name name of the option or property.
+		@param [out] value buffer receiving the value as zero terminated string.
+		@param [in]  size size of the value buffer in bytes.
+		@return
+			@li = true     success
+			@li = false    unknown name, or the value does not fit into the buffer
+		*/
+		bool( *get_option ) (dvpd_input_dec_handle_t h_dec, const char *name, char *value, uint32_t size );
+
+		/*!
+		receive_picture
+		@brief
+		returns the next decoded picture of an instance initialized without picture callback (on_decoded_picture = NULL).
+		Such an instance queues its pictures instead of calling a callback; decode and decode_batch only feed the bitstream.
+		A picture is owned by the caller and must be passed to release_picture. The queue is bounded: while it is full, the
+		decoder waits for the caller, so pictures have to be received on another thread than the one calling decode and flush.
+		Every flush queues an end of stream after the pictures it outputs. Only available if the plugin reports
+		DVPD_VID_DEC_CAP_RECEIVE_PICTURE. Must not be called concurrently with deinit.
+		@param [in]  h_dec handle to the video decoder instance.
+		@param [out] dec_picture the decoded picture.
+		@param [in]  timeout_ms maximum time in milliseconds to wait for a picture, 0 returns at once, negative values wait
+		             without limit.
+		@return
+			@li = DVPD_INPUT_DEC_RECEIVE_OK      a picture was returned in dec_picture
+			@li = DVPD_INPUT_DEC_RECEIVE_AGAIN   no picture within the timeout
+			@li = DVPD_INPUT_DEC_RECEIVE_EOF     the end of stream queued by a flush, returned once per flush
+			@li = DVPD_INPUT_DEC_RECEIVE_ERROR   invalid handle or the instance has a picture callback
+		*/
+		int32_t( *receive_picture ) (dvpd_input_dec_handle_t h_dec, dvpd_input_dec_picture_t *dec_picture, int32_t timeout_ms );
 	} dvpd_input_dec_if_t;
 
+	/*!
+	DVPD_VID_DEC_CAP_*
+	@brief optional features of a video decoder plugin, reported in dv_dec_video_dec_plugin_t::capabilities.\n
+	*/
+	#define DVPD_VID_DEC_CAP_DECODE_BATCH    0x00000001 /**< @details decode_batch is implemented */
+	#define DVPD_VID_DEC_CAP_STATS           0x00000002 /**< @details get_stats is implemented */
+	#define DVPD_VID_DEC_CAP_INPUT_BUFFERS   0x00000004 /**< @details get_input_buffer can provide buffers */
+	#define DVPD_VID_DEC_CAP_RECEIVE_PICTURE 0x00000008 /**< @details receive_picture is implemented */
+
 
 	/*!
 	dv_dec_video_dec_plugin_t
@@ -201,7 +386,8 @@ extern "C" {
 	*/
 	typedef struct
 	{
-		int32_t dv_plugin_api_version; // always initialize this to DV_PLUGIN_API_VERSION
+		int32_t dv_plugin_api_version; // always initialize this to DV_PLUGIN_API_VERSION. the plugin replaces it with the version it filled in, functions
+		                               // of vid_dec_if introduced with a later version than that one are left untouched by the plugin.
 
 		const char *name;              // the plugin's friendly name
 		const char *description;       // description about what the plugin does
@@ -211,6 +397,8 @@ extern "C" {
 	
 		dvpd_input_dec_if_t vid_dec_if;
 
+		uint32_t capabilities;         // DVPD_VID_DEC_CAP_* flags, only set by plugins from DV_PLUGIN_API_VERSION 2 on.
+
 	} dv_dec_video_dec_plugin_t;
 
 	/*!
@@ -220,6 +408,16 @@ extern "C" {
 	*/
 	DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin );
 
+	/*!
+	dv_dec_vid_dec_plugin_describe_version
+	@brief fills the provided plugin structure with descriptive information and the functions of vid_dec_if up to the version
+	both sides support. dv_dec_vid_dec_plugin_describe only fills the fields of DV_PLUGIN_API_VERSION 0; callers built with a
+	later version look this function up first. Available from DV_PLUGIN_API_VERSION 1 on.\n
+	@param [in]  dv_dec_video_dec_plugin pointer to a dv_dec_video_dec_plugin_t structure to be filled.
+	@param [in]  api_version DV_PLUGIN_API_VERSION the caller has been built with.
+	*/
+	DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe_version( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin, int32_t api_version );
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,364 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_au_splitter.h"
+
+#define START_CODE_SIZE 3
+#define CLASSIFY_SIZE 6                 // start code, NAL unit header and first byte of the slice header
+
+typedef enum
+{
+	SCAN_END = 0,
+	SCAN_BOUNDARY,                      // a start code that begins an access unit
+	SCAN_INCOMPLETE                     // a start code that can not be classified yet
+} scan_result_t;
+
+struct au_splitter_s_
+{
+	nal_codec_t codec;
+	bool has_vcl;                       // the current access unit has slice data
+
+	uint8_t *buffer;                    // beginning of the current access unit, if it spans chunks
+	size_t size;
+	size_t capacity;
+	size_t scan_pos;                    // start codes before scan_pos have been classified
+
+	uint64_t pts;                       // timestamps of the current access unit
+	uint64_t dts;
+
+	uint64_t last_dts;
+	uint64_t stamp_dts;                 // dts of the last access unit with a timestamp of its own
+	int64_t since_stamp;                // access units since then
+	int64_t duration;                   // 0 if not known yet
+};
+
+static bool starts_access_unit( au_splitter_t* splitter, const uint8_t* nal )
+{
+	int32_t type;
+	bool first_slice;
+	bool prefix;
+
+	if( splitter->codec == NAL_CODEC_HEVC )
+	{
+		type = ( nal[ 0 ] >> 1 ) & 0x3f;
+		first_slice = ( nal[ 2 ] & 0x80 ) != 0;
+		prefix = ( type >= HEVC_NAL_VPS && type <= HEVC_NAL_AUD ) || type == HEVC_NAL_SEI_PREFIX ||
+			( type >= 41 && type <= 44 ) || ( type >= 48 && type <= 55 );
+	}
+	else
+	{
+		type = nal[ 0 ] & 0x1f;
+		first_slice = ( nal[ 1 ] & 0x80 ) != 0; // first_mb_in_slice equal to 0
+		prefix = ( type >= AVC_NAL_SEI && type <= AVC_NAL_AUD ) || ( type >= 14 && type <= 18 );
+	}
+
+	if( nal_is_vcl( splitter->codec, type ) == true )
+	{
+		bool boundary = ( splitter->has_vcl == true && first_slice == true );
+
+		splitter->has_vcl = true;
+		return boundary;
+	}
+
+	if( prefix == true && splitter->has_vcl == true )
+	{
+		splitter->has_vcl = false;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * classifies the start codes beginning in [from, limit) of data until one begins an access unit. pos returns its
+ * position, or where to continue the search once more data is available.
+ */
+static scan_result_t find_boundary( au_splitter_t* splitter, const uint8_t* data, size_t size, size_t from, size_t limit, size_t* pos )
+{
+	const uint8_t* end = data + size;
+	const uint8_t* p = data + from;
+
+	while( ( p = nal_find_start_code( p, end ) ) < data + limit )
+	{
+		if( ( size_t )( end - p ) < CLASSIFY_SIZE )
+		{
+			*pos = p - data;
+			return SCAN_INCOMPLETE;
+		}
+
+		if( starts_access_unit( splitter, p + START_CODE_SIZE ) == true )
+		{
+			*pos = p - data;
+			return SCAN_BOUNDARY;
+		}
+
+		p += START_CODE_SIZE;
+	}
+
+	// the last two bytes may be the beginning of a start code
+	*pos = ( limit - from > 2 ) ? limit - 2 : from;
+	return SCAN_END;
+}
+
+static bool append( au_splitter_t* splitter, const uint8_t* data, size_t size )
+{
+	if( splitter->size + size > splitter->capacity )
+	{
+		size_t capacity = splitter->capacity > 0 ? splitter->capacity : 64 * 1024;
+		uint8_t* buffer;
+
+		while( capacity < splitter->size + size )
+		{
+			capacity *= 2;
+		}
+
+		buffer = ( uint8_t* )realloc( splitter->buffer, capacity );
+		if( buffer == NULL )
+		{
+			return false;
+		}
+
+		splitter->buffer = buffer;
+		splitter->capacity = capacity;
+	}
+
+	memcpy( splitter->buffer + splitter->size, data, size );
+	splitter->size += size;
+
+	return true;
+}
+
+/*
+ * the first access unit that starts in a chunk takes the timestamps of the chunk.
+ */
+static void begin_access_unit( au_splitter_t* splitter, bool* stamped, uint64_t pts, uint64_t dts )
+{
+	if( *stamped == false )
+	{
+		splitter->pts = pts;
+		splitter->dts = dts;
+		*stamped = true;
+		return;
+	}
+
+	splitter->pts = AU_SPLITTER_NO_TIMESTAMP;
+	splitter->dts = AU_SPLITTER_NO_TIMESTAMP;
+}
+
+static void emit_access_unit( au_splitter_t* splitter, uint8_t* data, size_t size, au_splitter_cb_func_t on_access_unit, void* opaque )
+{
+	uint64_t dts = splitter->dts;
+
+	splitter->since_stamp++;
+	if( dts != AU_SPLITTER_NO_TIMESTAMP )
+	{
+		if( splitter->stamp_dts != AU_SPLITTER_NO_TIMESTAMP && ( int64_t )( dts - splitter->stamp_dts ) > 0 )
+		{
+			splitter->duration = ( int64_t )( dts - splitter->stamp_dts ) / splitter->since_stamp;
+		}
+
+		splitter->stamp_dts = dts;
+		splitter->since_stamp = 0;
+	}
+	else if( splitter->last_dts != AU_SPLITTER_NO_TIMESTAMP && splitter->duration > 0 )
+	{
+		dts = splitter->last_dts + splitter->duration;
+	}
+
+	splitter->last_dts = dts;
+
+	on_access_unit( opaque, data, ( uint32_t )size, splitter->pts, dts );
+}
+
+static void reset_timestamps( au_splitter_t* splitter )
+{
+	splitter->last_dts = AU_SPLITTER_NO_TIMESTAMP;
+	splitter->stamp_dts = AU_SPLITTER_NO_TIMESTAMP;
+	splitter->since_stamp = 0;
+	splitter->duration = 0;
+}
+
+au_splitter_t* au_splitter_create( nal_codec_t codec )
+{
+	au_splitter_t* splitter;
+
+	splitter = ( au_splitter_t* )malloc( sizeof( au_splitter_t ) );
+	if( splitter == NULL )
+	{
+		return NULL;
+	}
+
+	memset( splitter, 0, sizeof( au_splitter_t ) );
+	splitter->codec = codec;
+	reset_timestamps( splitter );
+
+	return splitter;
+}
+
+void au_splitter_release( au_splitter_t** splitter )
+{
+	if( splitter == NULL || *splitter == NULL )
+	{
+		return;
+	}
+
+	free( ( *splitter )->buffer );
+	free( *splitter );
+	*splitter = NULL;
+}
+
+void au_splitter_push( au_splitter_t* splitter, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts,
+	au_splitter_cb_func_t on_access_unit, void* opaque )
+{
+	bool stamped = false;
+	size_t start = 0;
+	size_t from = 0;
+	size_t pos;
+
+	if( size == 0 )
+	{
+		return;
+	}
+
+	// the current access unit spans chunks
+	if( splitter->size > 0 )
+	{
+		size_t previous = splitter->size;
+		size_t head = ( size < CLASSIFY_SIZE - 1 ) ? size : CLASSIFY_SIZE - 1;
+
+		// enough of the chunk to classify the start codes that begin in the buffer
+		if( append( splitter, data, head ) == false )
+		{
+			au_splitter_reset( splitter );
+			return;
+		}
+
+		for( ;; )
+		{
+			scan_result_t result = find_boundary( splitter, splitter->buffer, splitter->size, splitter->scan_pos, previous, &pos );
+
+			if( result == SCAN_INCOMPLETE )
+			{
+				splitter->scan_pos = pos;
+				return;
+			}
+
+			if( result == SCAN_END )
+			{
+				break;
+			}
+
+			emit_access_unit( splitter, splitter->buffer, pos, on_access_unit, opaque );
+
+			// the start code of the next access unit straddles the chunks
+			memmove( splitter->buffer, splitter->buffer + pos, splitter->size - pos );
+			splitter->size -= pos;
+			previous -= pos;
+			splitter->scan_pos = START_CODE_SIZE;
+			begin_access_unit( splitter, &stamped, pts, dts );
+		}
+
+		// the last two bytes may be the beginning of a start code
+		if( head == size )
+		{
+			splitter->scan_pos = ( previous + 2 > splitter->size && splitter->size >= 2 ) ? splitter->size - 2 : previous;
+			return;
+		}
+
+		if( find_boundary( splitter, data, size, 0, size, &pos ) != SCAN_BOUNDARY )
+		{
+			if( append( splitter, data + head, size - head ) == false )
+			{
+				au_splitter_reset( splitter );
+				return;
+			}
+
+			splitter->scan_pos = previous + pos;
+			return;
+		}
+
+		splitter->size = previous;
+		if( append( splitter, data, pos ) == false )
+		{
+			au_splitter_reset( splitter );
+			return;
+		}
+
+		emit_access_unit( splitter, splitter->buffer, splitter->size, on_access_unit, opaque );
+
+		splitter->size = 0;
+		splitter->scan_pos = 0;
+		start = pos;
+		from = pos + START_CODE_SIZE;
+	}
+
+	// access units within the chunk are passed on in place
+	begin_access_unit( splitter, &stamped, pts, dts );
+
+	while( find_boundary( splitter, data, size, from, size, &pos ) == SCAN_BOUNDARY )
+	{
+		emit_access_unit( splitter, data + start, pos - start, on_access_unit, opaque );
+
+		begin_access_unit( splitter, &stamped, pts, dts );
+		start = pos;
+		from = pos + START_CODE_SIZE;
+	}
+
+	if( append( splitter, data + start, size - start ) == false )
+	{
+		au_splitter_reset( splitter );
+		return;
+	}
+
+	splitter->scan_pos = pos - start;
+}
+
+void au_splitter_flush( au_splitter_t* splitter, au_splitter_cb_func_t on_access_unit, void* opaque )
+{
+	if( splitter->size > 0 )
+	{
+		emit_access_unit( splitter, splitter->buffer, splitter->size, on_access_unit, opaque );
+	}
+
+	au_splitter_reset( splitter );
+}
+
+void au_splitter_reset( au_splitter_t* splitter )
+{
+	splitter->size = 0;
+	splitter->scan_pos = 0;
+	splitter->has_vcl = false;
+	reset_timestamps( splitter );
+}
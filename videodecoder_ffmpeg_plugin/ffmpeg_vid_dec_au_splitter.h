@@ -0,0 +1,86 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief access unit splitter of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_au_splitter.h
+*
+* Splits an Annex-B byte stream passed in chunks of any size into access units. Access units that lie within one
+* chunk are passed on in place, only the access units that span chunks are collected in a buffer. An access unit
+* starts with the first access unit delimiter, parameter set, prefix SEI or first slice of a picture after the slices
+* of the previous picture.
+*
+* A chunk's timestamps belong to the first access unit that starts in the chunk. The other access units get the
+* decoding timestamp of the previous access unit plus the average distance of the timestamped access units, and no
+* presentation timestamp, as the presentation order is not known before decoding.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_AU_SPLITTER_H_
+#define __FFMPEG_VID_DEC_AU_SPLITTER_H_
+
+#include "ffmpeg_vid_dec_nal.h"
+
+/*!
+	AU_SPLITTER_NO_TIMESTAMP
+	@brief timestamp of a chunk or access unit without timestamp (AV_NOPTS_VALUE).\n
+*/
+#define AU_SPLITTER_NO_TIMESTAMP ( ( uint64_t )0x8000000000000000ULL )
+
+typedef void( *au_splitter_cb_func_t ) ( void* opaque, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts );
+
+typedef struct au_splitter_s_ au_splitter_t;
+
+au_splitter_t* au_splitter_create( nal_codec_t codec );
+void au_splitter_release( au_splitter_t** splitter );
+
+/*!
+	au_splitter_push
+	@brief passes a chunk of the byte stream. Calls on_access_unit for every access unit completed by the chunk,
+	the data passed is valid during the call only.\n
+*/
+void au_splitter_push( au_splitter_t* splitter, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts,
+	au_splitter_cb_func_t on_access_unit, void* opaque );
+
+/*!
+	au_splitter_flush
+	@brief passes on the last access unit at the end of the stream.\n
+*/
+void au_splitter_flush( au_splitter_t* splitter, au_splitter_cb_func_t on_access_unit, void* opaque );
+
+/*!
+	au_splitter_reset
+	@brief drops the collected data, the next chunk starts a new access unit.\n
+*/
+void au_splitter_reset( au_splitter_t* splitter );
+
+#endif // __FFMPEG_VID_DEC_AU_SPLITTER_H_
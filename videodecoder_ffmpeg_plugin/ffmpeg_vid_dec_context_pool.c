@@ -0,0 +1,231 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_context_pool.h"
+#include "ffmpeg_vid_dec_thread.h"
+#include <libavutil/time.h>
+
+#define IDLE_TIMEOUT_US ( 30 * 1000000LL )
+
+typedef struct pool_entry_s_
+{
+	struct pool_entry_s_ *next;
+	codec_config_t config;
+	pooled_codec_t codec;
+	int64_t idle_since;
+} pool_entry_t;
+
+// entries in the order they were put, oldest first
+static vid_dec_spinlock_t pool_lock = VID_DEC_SPINLOCK_INIT;
+static pool_entry_t *pool_entries = NULL;
+static int32_t pool_idle = 0;
+static int64_t pool_hits = 0;
+static int64_t pool_misses = 0;
+static int64_t pool_evictions = 0;
+
+static void free_codec( pooled_codec_t* codec )
+{
+	avcodec_free_context( &codec->av_codec_ctx );
+#if FRAME_POOL_SUPPORTED
+	frame_pool_release( &codec->frame_pool );
+#endif
+}
+
+/*
+ * unlinks expired entries and the oldest entries beyond capacity. Called with pool_lock held, the evicted contexts
+ * are freed after it was released since that joins their threads.
+ */
+static pool_entry_t* collect_evictions( int64_t now, int32_t capacity )
+{
+	pool_entry_t* evicted = NULL;
+	pool_entry_t** link = &pool_entries;
+
+	while( *link != NULL )
+	{
+		pool_entry_t* entry = *link;
+
+		if( now - entry->idle_since > IDLE_TIMEOUT_US || pool_idle > capacity )
+		{
+			*link = entry->next;
+			entry->next = evicted;
+			evicted = entry;
+			pool_idle--;
+			pool_evictions++;
+		}
+		else
+		{
+			link = &entry->next;
+		}
+	}
+
+	return evicted;
+}
+
+static void free_entries( pool_entry_t* entries )
+{
+	while( entries != NULL )
+	{
+		pool_entry_t* next = entries->next;
+
+		free_codec( &entries->codec );
+		free( entries );
+		entries = next;
+	}
+}
+
+bool context_pool_take( const codec_config_t* config, pooled_codec_t* codec )
+{
+	pool_entry_t* evicted;
+	pool_entry_t* found = NULL;
+
+	vid_dec_spin_lock( &pool_lock );
+
+	evicted = collect_evictions( av_gettime_relative( ), INT32_MAX );
+
+	for( pool_entry_t** link = &pool_entries; *link != NULL; link = &( *link )->next )
+	{
+		if( memcmp( &( *link )->config, config, sizeof( codec_config_t ) ) == 0 )
+		{
+			found = *link;
+			*link = found->next;
+			pool_idle--;
+			break;
+		}
+	}
+
+	if( found != NULL )
+	{
+		pool_hits++;
+	}
+	else
+	{
+		pool_misses++;
+	}
+
+	vid_dec_spin_unlock( &pool_lock );
+
+	free_entries( evicted );
+
+	if( found == NULL )
+	{
+		return false;
+	}
+
+	*codec = found->codec;
+	free( found );
+
+	return true;
+}
+
+void context_pool_put( const codec_config_t* config, pooled_codec_t* codec, int32_t capacity )
+{
+	pool_entry_t* entry = NULL;
+	pool_entry_t* evicted;
+
+	if( capacity > 0 )
+	{
+		entry = ( pool_entry_t* )malloc( sizeof( pool_entry_t ) );
+	}
+
+	if( entry == NULL )
+	{
+		free_codec( codec );
+		return;
+	}
+
+#if FRAME_POOL_SUPPORTED
+	// an idle context does not need frame buffers, the pool allocates them again for the next instance
+	if( codec->frame_pool != NULL )
+	{
+		frame_pool_trim( codec->frame_pool );
+	}
+#endif
+
+	entry->next = NULL;
+	entry->config = *config;
+	entry->codec = *codec;
+	entry->idle_since = av_gettime_relative( );
+	memset( codec, 0, sizeof( pooled_codec_t ) );
+
+	vid_dec_spin_lock( &pool_lock );
+
+	if( pool_entries == NULL )
+	{
+		pool_entries = entry;
+	}
+	else
+	{
+		pool_entry_t* last = pool_entries;
+
+		while( last->next != NULL )
+		{
+			last = last->next;
+		}
+		last->next = entry;
+	}
+	pool_idle++;
+
+	evicted = collect_evictions( entry->idle_since, capacity );
+
+	vid_dec_spin_unlock( &pool_lock );
+
+	free_entries( evicted );
+}
+
+void context_pool_get_stats( context_pool_stats_t* stats )
+{
+	vid_dec_spin_lock( &pool_lock );
+
+	stats->hits = pool_hits;
+	stats->misses = pool_misses;
+	stats->evictions = pool_evictions;
+	stats->idle = pool_idle;
+
+	vid_dec_spin_unlock( &pool_lock );
+}
+
+#if defined(__GNUC__) && !defined(_WIN32)
+// frees the idle contexts when the plugin is unloaded
+__attribute__(( destructor )) static void context_pool_drain( void )
+{
+	pool_entry_t* evicted;
+
+	vid_dec_spin_lock( &pool_lock );
+	evicted = collect_evictions( av_gettime_relative( ), 0 );
+	vid_dec_spin_unlock( &pool_lock );
+
+	free_entries( evicted );
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief process wide pool of opened codec contexts of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_context_pool.h
+*
+* Opening a decoder allocates its context and starts its threads. Instead of freeing it, deinit flushes the context
+* and parks it in the pool, where the next instance opening a decoder with the same configuration takes it. A
+* context travels together with its frame pool, which its get_buffer2 callback references and whose idle buffers are
+* freed when the context is pooled. Idle contexts are evicted when the pool exceeds its capacity, and after a timeout
+* once the pool is used again; there is no timer.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_CONTEXT_POOL_H_
+#define __FFMPEG_VID_DEC_CONTEXT_POOL_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_frame_pool.h"
+#include "ffmpeg_vid_dec_placement.h"
+#include <libavcodec/avcodec.h>
+
+/*!
+	codec_config_t
+	@brief everything applied to a codec context before avcodec_open2. Contexts are only shared between equal
+	configurations. Must be zero initialized before it is filled.\n
+*/
+typedef struct
+{
+	int32_t codec_id;
+	int32_t thread_type;                /**< @details FF_THREAD_* or 0 for the default of libavcodec */
+	int32_t thread_count;
+	int32_t frame_pool_alignment;       /**< @details 0 without frame pool */
+	int32_t frame_pool_hugepages;
+	int32_t lowres;
+	int32_t flags;                      /**< @details AV_CODEC_FLAG_* */
+	int32_t thread_pool;                /**< @details 1 if the slice jobs run on the shared thread pool */
+	placement_t placement;              /**< @details CPUs of the decoding threads, node of the frame pool */
+} codec_config_t;
+
+typedef struct
+{
+	AVCodecContext *av_codec_ctx;
+	frame_pool_t *frame_pool;
+} pooled_codec_t;
+
+typedef struct
+{
+	int64_t hits;                       /**< @details decoders opened from the pool */
+	int64_t misses;                     /**< @details decoders opened without a matching pooled context */
+	int64_t evictions;                  /**< @details contexts freed by the pool */
+	int32_t idle;                       /**< @details contexts currently pooled */
+} context_pool_stats_t;
+
+/*!
+	context_pool_take
+	@brief takes a pooled context of the given configuration. Returns false if there is none.\n
+*/
+bool context_pool_take( const codec_config_t* config, pooled_codec_t* codec );
+
+/*!
+	context_pool_put
+	@brief passes a flushed context to the pool, which keeps at most capacity idle contexts.\n
+*/
+void context_pool_put( const codec_config_t* config, pooled_codec_t* codec, int32_t capacity );
+
+void context_pool_get_stats( context_pool_stats_t* stats );
+
+#endif // __FFMPEG_VID_DEC_CONTEXT_POOL_H_
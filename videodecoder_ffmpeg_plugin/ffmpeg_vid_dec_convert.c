@@ -0,0 +1,607 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ffmpeg_vid_dec_convert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CONVERT_X86 1
+#else
+#define CONVERT_X86 0
+#endif
+
+#if CONVERT_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#include <cpuid.h>
+#define TARGET_SSE41 __attribute__(( target( "sse4.1" ) ))
+#define TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#define TARGET_AVX512 __attribute__(( target( "avx512f,avx512bw" ) ))
+#endif
+#include <immintrin.h>
+#endif
+
+static void deinterleave_u8_c( const uint8_t* src, uint8_t* dst_u, uint8_t* dst_v, int32_t n )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst_u[ i ] = src[ 2 * i ];
+		dst_v[ i ] = src[ 2 * i + 1 ];
+	}
+}
+
+static void deinterleave_u16_c( const uint16_t* src, uint16_t* dst_u, uint16_t* dst_v, int32_t n, int32_t shift )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst_u[ i ] = ( uint16_t )( src[ 2 * i ] >> shift );
+		dst_v[ i ] = ( uint16_t )( src[ 2 * i + 1 ] >> shift );
+	}
+}
+
+static void shift_u16_c( const uint16_t* src, uint16_t* dst, int32_t n, int32_t shift )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst[ i ] = ( uint16_t )( src[ i ] >> shift );
+	}
+}
+
+static void avg2_u8_c( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst[ i ] = ( uint8_t )( ( src0[ i ] + src1[ i ] + 1 ) >> 1 );
+	}
+}
+
+static void avg2_u16_c( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst[ i ] = ( uint16_t )( ( src0[ i ] + src1[ i ] + 1 ) >> 1 );
+	}
+}
+
+static void avg4_u8_c( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst[ i ] = ( uint8_t )( ( src0[ 2 * i ] + src0[ 2 * i + 1 ] + src1[ 2 * i ] + src1[ 2 * i + 1 ] + 2 ) >> 2 );
+	}
+}
+
+static void avg4_u16_c( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	for( int32_t i = 0; i < n; i++ )
+	{
+		dst[ i ] = ( uint16_t )( ( src0[ 2 * i ] + src0[ 2 * i + 1 ] + src1[ 2 * i ] + src1[ 2 * i + 1 ] + 2 ) >> 2 );
+	}
+}
+
+#if CONVERT_X86
+/*
+ * SSE4.1, 16 bytes per vector. Remainders are handled by the scalar kernels.
+ */
+TARGET_SSE41 static void deinterleave_u8_sse41( const uint8_t* src, uint8_t* dst_u, uint8_t* dst_v, int32_t n )
+{
+	const __m128i mask = _mm_setr_epi8( 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15 );
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		__m128i a = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( src + 2 * i ) ), mask );
+		__m128i b = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( src + 2 * i + 16 ) ), mask );
+
+		_mm_storeu_si128( ( __m128i* )( dst_u + i ), _mm_unpacklo_epi64( a, b ) );
+		_mm_storeu_si128( ( __m128i* )( dst_v + i ), _mm_unpackhi_epi64( a, b ) );
+	}
+
+	deinterleave_u8_c( src + 2 * i, dst_u + i, dst_v + i, n - i );
+}
+
+TARGET_SSE41 static void deinterleave_u16_sse41( const uint16_t* src, uint16_t* dst_u, uint16_t* dst_v, int32_t n, int32_t shift )
+{
+	const __m128i mask = _mm_setr_epi8( 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 );
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 8 <= n; i += 8 )
+	{
+		__m128i a = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( src + 2 * i ) ), mask );
+		__m128i b = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( src + 2 * i + 8 ) ), mask );
+
+		_mm_storeu_si128( ( __m128i* )( dst_u + i ), _mm_srl_epi16( _mm_unpacklo_epi64( a, b ), count ) );
+		_mm_storeu_si128( ( __m128i* )( dst_v + i ), _mm_srl_epi16( _mm_unpackhi_epi64( a, b ), count ) );
+	}
+
+	deinterleave_u16_c( src + 2 * i, dst_u + i, dst_v + i, n - i, shift );
+}
+
+TARGET_SSE41 static void shift_u16_sse41( const uint16_t* src, uint16_t* dst, int32_t n, int32_t shift )
+{
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 8 <= n; i += 8 )
+	{
+		_mm_storeu_si128( ( __m128i* )( dst + i ), _mm_srl_epi16( _mm_loadu_si128( ( const __m128i* )( src + i ) ), count ) );
+	}
+
+	shift_u16_c( src + i, dst + i, n - i, shift );
+}
+
+TARGET_SSE41 static void avg2_u8_sse41( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		__m128i a = _mm_loadu_si128( ( const __m128i* )( src0 + i ) );
+		__m128i b = _mm_loadu_si128( ( const __m128i* )( src1 + i ) );
+
+		_mm_storeu_si128( ( __m128i* )( dst + i ), _mm_avg_epu8( a, b ) );
+	}
+
+	avg2_u8_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_SSE41 static void avg2_u16_sse41( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 8 <= n; i += 8 )
+	{
+		__m128i a = _mm_loadu_si128( ( const __m128i* )( src0 + i ) );
+		__m128i b = _mm_loadu_si128( ( const __m128i* )( src1 + i ) );
+
+		_mm_storeu_si128( ( __m128i* )( dst + i ), _mm_avg_epu16( a, b ) );
+	}
+
+	avg2_u16_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_SSE41 static void avg4_u8_sse41( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	const __m128i ones = _mm_set1_epi8( 1 );
+	const __m128i round = _mm_set1_epi16( 2 );
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		// horizontal pair sums as 16 bit words
+		__m128i a0 = _mm_maddubs_epi16( _mm_loadu_si128( ( const __m128i* )( src0 + 2 * i ) ), ones );
+		__m128i b0 = _mm_maddubs_epi16( _mm_loadu_si128( ( const __m128i* )( src0 + 2 * i + 16 ) ), ones );
+		__m128i a1 = _mm_maddubs_epi16( _mm_loadu_si128( ( const __m128i* )( src1 + 2 * i ) ), ones );
+		__m128i b1 = _mm_maddubs_epi16( _mm_loadu_si128( ( const __m128i* )( src1 + 2 * i + 16 ) ), ones );
+		__m128i a = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( a0, a1 ), round ), 2 );
+		__m128i b = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( b0, b1 ), round ), 2 );
+
+		_mm_storeu_si128( ( __m128i* )( dst + i ), _mm_packus_epi16( a, b ) );
+	}
+
+	avg4_u8_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+TARGET_SSE41 static void avg4_u16_sse41( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	const __m128i ones = _mm_set1_epi16( 1 );
+	const __m128i round = _mm_set1_epi32( 2 );
+	int32_t i = 0;
+
+	for( ; i + 8 <= n; i += 8 )
+	{
+		// horizontal pair sums as 32 bit words
+		__m128i a0 = _mm_madd_epi16( _mm_loadu_si128( ( const __m128i* )( src0 + 2 * i ) ), ones );
+		__m128i b0 = _mm_madd_epi16( _mm_loadu_si128( ( const __m128i* )( src0 + 2 * i + 8 ) ), ones );
+		__m128i a1 = _mm_madd_epi16( _mm_loadu_si128( ( const __m128i* )( src1 + 2 * i ) ), ones );
+		__m128i b1 = _mm_madd_epi16( _mm_loadu_si128( ( const __m128i* )( src1 + 2 * i + 8 ) ), ones );
+		__m128i a = _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( a0, a1 ), round ), 2 );
+		__m128i b = _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( b0, b1 ), round ), 2 );
+
+		_mm_storeu_si128( ( __m128i* )( dst + i ), _mm_packus_epi32( a, b ) );
+	}
+
+	avg4_u16_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+/*
+ * AVX2, 32 bytes per vector. Shuffles and packs work within 128 bit lanes, the lanes are reordered afterwards.
+ */
+TARGET_AVX2 static void deinterleave_u8_avx2( const uint8_t* src, uint8_t* dst_u, uint8_t* dst_v, int32_t n )
+{
+	const __m256i mask = _mm256_setr_epi8( 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+		0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15 );
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m256i a = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i ) ), mask );
+		__m256i b = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i + 32 ) ), mask );
+
+		// u u v v -> u of both lanes in the low half, v in the high half
+		a = _mm256_permute4x64_epi64( a, 0xD8 );
+		b = _mm256_permute4x64_epi64( b, 0xD8 );
+
+		_mm256_storeu_si256( ( __m256i* )( dst_u + i ), _mm256_permute2x128_si256( a, b, 0x20 ) );
+		_mm256_storeu_si256( ( __m256i* )( dst_v + i ), _mm256_permute2x128_si256( a, b, 0x31 ) );
+	}
+
+	deinterleave_u8_c( src + 2 * i, dst_u + i, dst_v + i, n - i );
+}
+
+TARGET_AVX2 static void deinterleave_u16_avx2( const uint16_t* src, uint16_t* dst_u, uint16_t* dst_v, int32_t n, int32_t shift )
+{
+	const __m256i mask = _mm256_setr_epi8( 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+		0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 );
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		__m256i a = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i ) ), mask );
+		__m256i b = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i + 16 ) ), mask );
+
+		a = _mm256_permute4x64_epi64( a, 0xD8 );
+		b = _mm256_permute4x64_epi64( b, 0xD8 );
+
+		_mm256_storeu_si256( ( __m256i* )( dst_u + i ), _mm256_srl_epi16( _mm256_permute2x128_si256( a, b, 0x20 ), count ) );
+		_mm256_storeu_si256( ( __m256i* )( dst_v + i ), _mm256_srl_epi16( _mm256_permute2x128_si256( a, b, 0x31 ), count ) );
+	}
+
+	deinterleave_u16_c( src + 2 * i, dst_u + i, dst_v + i, n - i, shift );
+}
+
+TARGET_AVX2 static void shift_u16_avx2( const uint16_t* src, uint16_t* dst, int32_t n, int32_t shift )
+{
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		_mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_srl_epi16( _mm256_loadu_si256( ( const __m256i* )( src + i ) ), count ) );
+	}
+
+	shift_u16_c( src + i, dst + i, n - i, shift );
+}
+
+TARGET_AVX2 static void avg2_u8_avx2( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m256i a = _mm256_loadu_si256( ( const __m256i* )( src0 + i ) );
+		__m256i b = _mm256_loadu_si256( ( const __m256i* )( src1 + i ) );
+
+		_mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_avg_epu8( a, b ) );
+	}
+
+	avg2_u8_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_AVX2 static void avg2_u16_avx2( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		__m256i a = _mm256_loadu_si256( ( const __m256i* )( src0 + i ) );
+		__m256i b = _mm256_loadu_si256( ( const __m256i* )( src1 + i ) );
+
+		_mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_avg_epu16( a, b ) );
+	}
+
+	avg2_u16_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_AVX2 static void avg4_u8_avx2( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	const __m256i ones = _mm256_set1_epi8( 1 );
+	const __m256i round = _mm256_set1_epi16( 2 );
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m256i a0 = _mm256_maddubs_epi16( _mm256_loadu_si256( ( const __m256i* )( src0 + 2 * i ) ), ones );
+		__m256i b0 = _mm256_maddubs_epi16( _mm256_loadu_si256( ( const __m256i* )( src0 + 2 * i + 32 ) ), ones );
+		__m256i a1 = _mm256_maddubs_epi16( _mm256_loadu_si256( ( const __m256i* )( src1 + 2 * i ) ), ones );
+		__m256i b1 = _mm256_maddubs_epi16( _mm256_loadu_si256( ( const __m256i* )( src1 + 2 * i + 32 ) ), ones );
+		__m256i a = _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( a0, a1 ), round ), 2 );
+		__m256i b = _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( b0, b1 ), round ), 2 );
+
+		_mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_permute4x64_epi64( _mm256_packus_epi16( a, b ), 0xD8 ) );
+	}
+
+	avg4_u8_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+TARGET_AVX2 static void avg4_u16_avx2( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	const __m256i ones = _mm256_set1_epi16( 1 );
+	const __m256i round = _mm256_set1_epi32( 2 );
+	int32_t i = 0;
+
+	for( ; i + 16 <= n; i += 16 )
+	{
+		__m256i a0 = _mm256_madd_epi16( _mm256_loadu_si256( ( const __m256i* )( src0 + 2 * i ) ), ones );
+		__m256i b0 = _mm256_madd_epi16( _mm256_loadu_si256( ( const __m256i* )( src0 + 2 * i + 16 ) ), ones );
+		__m256i a1 = _mm256_madd_epi16( _mm256_loadu_si256( ( const __m256i* )( src1 + 2 * i ) ), ones );
+		__m256i b1 = _mm256_madd_epi16( _mm256_loadu_si256( ( const __m256i* )( src1 + 2 * i + 16 ) ), ones );
+		__m256i a = _mm256_srli_epi32( _mm256_add_epi32( _mm256_add_epi32( a0, a1 ), round ), 2 );
+		__m256i b = _mm256_srli_epi32( _mm256_add_epi32( _mm256_add_epi32( b0, b1 ), round ), 2 );
+
+		_mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), 0xD8 ) );
+	}
+
+	avg4_u16_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+/*
+ * AVX-512BW, 64 bytes per vector. Lane local results are gathered with 64 bit permutes.
+ */
+TARGET_AVX512 static void deinterleave_u8_avx512( const uint8_t* src, uint8_t* dst_u, uint8_t* dst_v, int32_t n )
+{
+	const __m512i mask = _mm512_broadcast_i32x4( _mm_setr_epi8( 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15 ) );
+	const __m512i even = _mm512_set_epi64( 14, 12, 10, 8, 6, 4, 2, 0 );
+	const __m512i odd = _mm512_set_epi64( 15, 13, 11, 9, 7, 5, 3, 1 );
+	int32_t i = 0;
+
+	for( ; i + 64 <= n; i += 64 )
+	{
+		__m512i a = _mm512_shuffle_epi8( _mm512_loadu_si512( ( const void* )( src + 2 * i ) ), mask );
+		__m512i b = _mm512_shuffle_epi8( _mm512_loadu_si512( ( const void* )( src + 2 * i + 64 ) ), mask );
+
+		_mm512_storeu_si512( ( void* )( dst_u + i ), _mm512_permutex2var_epi64( a, even, b ) );
+		_mm512_storeu_si512( ( void* )( dst_v + i ), _mm512_permutex2var_epi64( a, odd, b ) );
+	}
+
+	deinterleave_u8_c( src + 2 * i, dst_u + i, dst_v + i, n - i );
+}
+
+TARGET_AVX512 static void deinterleave_u16_avx512( const uint16_t* src, uint16_t* dst_u, uint16_t* dst_v, int32_t n, int32_t shift )
+{
+	const __m512i mask = _mm512_broadcast_i32x4( _mm_setr_epi8( 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 ) );
+	const __m512i even = _mm512_set_epi64( 14, 12, 10, 8, 6, 4, 2, 0 );
+	const __m512i odd = _mm512_set_epi64( 15, 13, 11, 9, 7, 5, 3, 1 );
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m512i a = _mm512_shuffle_epi8( _mm512_loadu_si512( ( const void* )( src + 2 * i ) ), mask );
+		__m512i b = _mm512_shuffle_epi8( _mm512_loadu_si512( ( const void* )( src + 2 * i + 32 ) ), mask );
+
+		_mm512_storeu_si512( ( void* )( dst_u + i ), _mm512_srl_epi16( _mm512_permutex2var_epi64( a, even, b ), count ) );
+		_mm512_storeu_si512( ( void* )( dst_v + i ), _mm512_srl_epi16( _mm512_permutex2var_epi64( a, odd, b ), count ) );
+	}
+
+	deinterleave_u16_c( src + 2 * i, dst_u + i, dst_v + i, n - i, shift );
+}
+
+TARGET_AVX512 static void shift_u16_avx512( const uint16_t* src, uint16_t* dst, int32_t n, int32_t shift )
+{
+	const __m128i count = _mm_cvtsi32_si128( shift );
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		_mm512_storeu_si512( ( void* )( dst + i ), _mm512_srl_epi16( _mm512_loadu_si512( ( const void* )( src + i ) ), count ) );
+	}
+
+	shift_u16_c( src + i, dst + i, n - i, shift );
+}
+
+TARGET_AVX512 static void avg2_u8_avx512( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 64 <= n; i += 64 )
+	{
+		__m512i a = _mm512_loadu_si512( ( const void* )( src0 + i ) );
+		__m512i b = _mm512_loadu_si512( ( const void* )( src1 + i ) );
+
+		_mm512_storeu_si512( ( void* )( dst + i ), _mm512_avg_epu8( a, b ) );
+	}
+
+	avg2_u8_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_AVX512 static void avg2_u16_avx512( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m512i a = _mm512_loadu_si512( ( const void* )( src0 + i ) );
+		__m512i b = _mm512_loadu_si512( ( const void* )( src1 + i ) );
+
+		_mm512_storeu_si512( ( void* )( dst + i ), _mm512_avg_epu16( a, b ) );
+	}
+
+	avg2_u16_c( src0 + i, src1 + i, dst + i, n - i );
+}
+
+TARGET_AVX512 static void avg4_u8_avx512( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n )
+{
+	const __m512i ones = _mm512_set1_epi8( 1 );
+	const __m512i round = _mm512_set1_epi16( 2 );
+	const __m512i order = _mm512_set_epi64( 7, 5, 3, 1, 6, 4, 2, 0 );
+	int32_t i = 0;
+
+	for( ; i + 64 <= n; i += 64 )
+	{
+		__m512i a0 = _mm512_maddubs_epi16( _mm512_loadu_si512( ( const void* )( src0 + 2 * i ) ), ones );
+		__m512i b0 = _mm512_maddubs_epi16( _mm512_loadu_si512( ( const void* )( src0 + 2 * i + 64 ) ), ones );
+		__m512i a1 = _mm512_maddubs_epi16( _mm512_loadu_si512( ( const void* )( src1 + 2 * i ) ), ones );
+		__m512i b1 = _mm512_maddubs_epi16( _mm512_loadu_si512( ( const void* )( src1 + 2 * i + 64 ) ), ones );
+		__m512i a = _mm512_srli_epi16( _mm512_add_epi16( _mm512_add_epi16( a0, a1 ), round ), 2 );
+		__m512i b = _mm512_srli_epi16( _mm512_add_epi16( _mm512_add_epi16( b0, b1 ), round ), 2 );
+
+		_mm512_storeu_si512( ( void* )( dst + i ), _mm512_permutexvar_epi64( order, _mm512_packus_epi16( a, b ) ) );
+	}
+
+	avg4_u8_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+TARGET_AVX512 static void avg4_u16_avx512( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n )
+{
+	const __m512i ones = _mm512_set1_epi16( 1 );
+	const __m512i round = _mm512_set1_epi32( 2 );
+	const __m512i order = _mm512_set_epi64( 7, 5, 3, 1, 6, 4, 2, 0 );
+	int32_t i = 0;
+
+	for( ; i + 32 <= n; i += 32 )
+	{
+		__m512i a0 = _mm512_madd_epi16( _mm512_loadu_si512( ( const void* )( src0 + 2 * i ) ), ones );
+		__m512i b0 = _mm512_madd_epi16( _mm512_loadu_si512( ( const void* )( src0 + 2 * i + 32 ) ), ones );
+		__m512i a1 = _mm512_madd_epi16( _mm512_loadu_si512( ( const void* )( src1 + 2 * i ) ), ones );
+		__m512i b1 = _mm512_madd_epi16( _mm512_loadu_si512( ( const void* )( src1 + 2 * i + 32 ) ), ones );
+		__m512i a = _mm512_srli_epi32( _mm512_add_epi32( _mm512_add_epi32( a0, a1 ), round ), 2 );
+		__m512i b = _mm512_srli_epi32( _mm512_add_epi32( _mm512_add_epi32( b0, b1 ), round ), 2 );
+
+		_mm512_storeu_si512( ( void* )( dst + i ), _mm512_permutexvar_epi64( order, _mm512_packus_epi32( a, b ) ) );
+	}
+
+	avg4_u16_c( src0 + 2 * i, src1 + 2 * i, dst + i, n - i );
+}
+
+static void cpuid( uint32_t leaf, uint32_t subleaf, uint32_t regs[ 4 ] )
+{
+#if defined(_MSC_VER)
+	__cpuidex( ( int* )regs, ( int )leaf, ( int )subleaf );
+#else
+	__cpuid_count( leaf, subleaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+#endif
+}
+
+static uint64_t xgetbv( void )
+{
+#if defined(_MSC_VER)
+	return _xgetbv( 0 );
+#else
+	uint32_t eax, edx;
+
+	__asm__ volatile( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+
+	return ( ( uint64_t )edx << 32 ) | eax;
+#endif
+}
+#endif
+
+static const convert_kernels_t kernels[ CONVERT_ISA_COUNT ] =
+{
+	{ deinterleave_u8_c, deinterleave_u16_c, shift_u16_c, avg2_u8_c, avg2_u16_c, avg4_u8_c, avg4_u16_c },
+#if CONVERT_X86
+	{ deinterleave_u8_sse41, deinterleave_u16_sse41, shift_u16_sse41, avg2_u8_sse41, avg2_u16_sse41, avg4_u8_sse41, avg4_u16_sse41 },
+	{ deinterleave_u8_avx2, deinterleave_u16_avx2, shift_u16_avx2, avg2_u8_avx2, avg2_u16_avx2, avg4_u8_avx2, avg4_u16_avx2 },
+	{ deinterleave_u8_avx512, deinterleave_u16_avx512, shift_u16_avx512, avg2_u8_avx512, avg2_u16_avx512, avg4_u8_avx512, avg4_u16_avx512 },
+#endif
+};
+
+convert_isa_t convert_detect_isa( void )
+{
+#if CONVERT_X86
+	uint32_t regs[ 4 ];
+	uint32_t max_leaf;
+	uint64_t xcr0;
+	convert_isa_t isa = CONVERT_ISA_C;
+
+	cpuid( 0, 0, regs );
+	max_leaf = regs[ 0 ];
+
+	cpuid( 1, 0, regs );
+	if( ( regs[ 2 ] & ( 1u << 19 ) ) == 0 )
+	{
+		return isa;
+	}
+	isa = CONVERT_ISA_SSE41;
+
+	// AVX state must be enabled by the operating system (OSXSAVE, XCR0)
+	if( max_leaf < 7 || ( regs[ 2 ] & ( 1u << 27 ) ) == 0 || ( regs[ 2 ] & ( 1u << 28 ) ) == 0 )
+	{
+		return isa;
+	}
+
+	xcr0 = xgetbv( );
+	if( ( xcr0 & 0x6 ) != 0x6 )
+	{
+		return isa;
+	}
+
+	cpuid( 7, 0, regs );
+	if( ( regs[ 1 ] & ( 1u << 5 ) ) == 0 )
+	{
+		return isa;
+	}
+	isa = CONVERT_ISA_AVX2;
+
+	if( ( xcr0 & 0xE6 ) == 0xE6 && ( regs[ 1 ] & ( 1u << 16 ) ) != 0 && ( regs[ 1 ] & ( 1u << 30 ) ) != 0 )
+	{
+		isa = CONVERT_ISA_AVX512;
+	}
+
+	return isa;
+#else
+	return CONVERT_ISA_C;
+#endif
+}
+
+const convert_kernels_t* convert_get_kernels( convert_isa_t isa )
+{
+	if( isa < CONVERT_ISA_C || isa > convert_detect_isa( ) )
+	{
+		return NULL;
+	}
+
+	return &kernels[ isa ];
+}
+
+const char* convert_isa_name( convert_isa_t isa )
+{
+	switch( isa )
+	{
+	case CONVERT_ISA_C:
+		return "c";
+	case CONVERT_ISA_SSE41:
+		return "sse4";
+	case CONVERT_ISA_AVX2:
+		return "avx2";
+	case CONVERT_ISA_AVX512:
+		return "avx512";
+	default:
+		return "unknown";
+	}
+}
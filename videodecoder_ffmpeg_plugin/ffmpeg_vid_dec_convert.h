@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief sample conversion kernels of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_convert.h
+*
+* Row kernels that bring semi-planar, 4:2:2 and 4:4:4 decoder output into the planar 4:2:0 layout of
+* dvpd_input_dec_picture_t. Every kernel exists as scalar C code and, on x86, as SSE4.1, AVX2 and AVX-512BW code
+* selected at runtime. The kernels do not depend on FFmpeg.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_CONVERT_H_
+#define __FFMPEG_VID_DEC_CONVERT_H_
+
+#include "dvpd_vid_dec_plugin.h"
+
+typedef enum
+{
+	CONVERT_ISA_C = 0,
+	CONVERT_ISA_SSE41,
+	CONVERT_ISA_AVX2,
+	CONVERT_ISA_AVX512,
+	CONVERT_ISA_COUNT
+} convert_isa_t;
+
+/*!
+	convert_kernels_t
+	@brief row kernels of one instruction set. n is the number of output samples per destination row.
+	avg2 averages two rows, avg4 averages 2x2 blocks of two rows with 2 * n samples each, both rounding to nearest.
+	The 16 bit averaging kernels support samples of up to 15 bits.\n
+*/
+typedef struct
+{
+	void( *deinterleave_u8 ) ( const uint8_t* src, uint8_t* dst_u, uint8_t* dst_v, int32_t n );
+	void( *deinterleave_u16 ) ( const uint16_t* src, uint16_t* dst_u, uint16_t* dst_v, int32_t n, int32_t shift );
+	void( *shift_u16 ) ( const uint16_t* src, uint16_t* dst, int32_t n, int32_t shift );
+	void( *avg2_u8 ) ( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n );
+	void( *avg2_u16 ) ( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n );
+	void( *avg4_u8 ) ( const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t n );
+	void( *avg4_u16 ) ( const uint16_t* src0, const uint16_t* src1, uint16_t* dst, int32_t n );
+} convert_kernels_t;
+
+/*!
+	convert_detect_isa
+	@brief returns the best instruction set supported by the CPU, the operating system and the build.\n
+*/
+convert_isa_t convert_detect_isa( void );
+
+/*!
+	convert_get_kernels
+	@brief returns the kernels of the given instruction set, NULL if it is not supported.\n
+*/
+const convert_kernels_t* convert_get_kernels( convert_isa_t isa );
+
+const char* convert_isa_name( convert_isa_t isa );
+
+#endif // __FFMPEG_VID_DEC_CONVERT_H_
@@ -0,0 +1,345 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_format.h"
+#include <libavutil/imgutils.h>
+
+#define PLANE_ALIGNMENT 64
+
+typedef enum
+{
+	LAYOUT_PLANAR_420 = 0,
+	LAYOUT_SEMI_PLANAR_420,
+	LAYOUT_PLANAR_422,
+	LAYOUT_PLANAR_444
+} layout_t;
+
+struct format_converter_s_
+{
+	const convert_kernels_t *kernels;
+
+	AVBufferPool *pools[ 3 ];
+	size_t pool_sizes[ 3 ];
+};
+
+static bool describe_format( int format, layout_t* layout, int8_t* bit_depth, int32_t* shift )
+{
+	*shift = 0;
+
+	switch( ( enum AVPixelFormat )format )
+	{
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUVJ420P:
+		*layout = LAYOUT_PLANAR_420;
+		*bit_depth = 8;
+		break;
+	case AV_PIX_FMT_YUV420P10LE:
+		*layout = LAYOUT_PLANAR_420;
+		*bit_depth = 10;
+		break;
+	case AV_PIX_FMT_YUV420P12LE:
+		*layout = LAYOUT_PLANAR_420;
+		*bit_depth = 12;
+		break;
+	case AV_PIX_FMT_NV12:
+		*layout = LAYOUT_SEMI_PLANAR_420;
+		*bit_depth = 8;
+		break;
+	case AV_PIX_FMT_P010LE:
+		// samples are stored in the upper 10 bits
+		*layout = LAYOUT_SEMI_PLANAR_420;
+		*bit_depth = 10;
+		*shift = 6;
+		break;
+	case AV_PIX_FMT_YUV422P:
+	case AV_PIX_FMT_YUVJ422P:
+		*layout = LAYOUT_PLANAR_422;
+		*bit_depth = 8;
+		break;
+	case AV_PIX_FMT_YUV422P10LE:
+		*layout = LAYOUT_PLANAR_422;
+		*bit_depth = 10;
+		break;
+	case AV_PIX_FMT_YUV422P12LE:
+		*layout = LAYOUT_PLANAR_422;
+		*bit_depth = 12;
+		break;
+	case AV_PIX_FMT_YUV444P:
+	case AV_PIX_FMT_YUVJ444P:
+		*layout = LAYOUT_PLANAR_444;
+		*bit_depth = 8;
+		break;
+	case AV_PIX_FMT_YUV444P10LE:
+		*layout = LAYOUT_PLANAR_444;
+		*bit_depth = 10;
+		break;
+	case AV_PIX_FMT_YUV444P12LE:
+		*layout = LAYOUT_PLANAR_444;
+		*bit_depth = 12;
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+static bool alloc_plane( format_converter_t* converter, AVFrame* frame, int32_t plane, int32_t row_size, int32_t rows )
+{
+	int32_t linesize = FFALIGN( row_size, PLANE_ALIGNMENT );
+	size_t size = ( size_t )linesize * rows;
+
+	// a smaller picture keeps using the buffers if they waste at most a quarter
+	if( converter->pools[ plane ] == NULL || converter->pool_sizes[ plane ] < size || converter->pool_sizes[ plane ] - size > size / 4 )
+	{
+		// buffers of the previous size are freed when their last reference is released
+		av_buffer_pool_uninit( &converter->pools[ plane ] );
+
+		converter->pools[ plane ] = av_buffer_pool_init( size, av_buffer_alloc );
+		if( converter->pools[ plane ] == NULL )
+		{
+			return false;
+		}
+		converter->pool_sizes[ plane ] = size;
+	}
+
+	frame->buf[ plane ] = av_buffer_pool_get( converter->pools[ plane ] );
+	if( frame->buf[ plane ] == NULL )
+	{
+		return false;
+	}
+
+	frame->data[ plane ] = frame->buf[ plane ]->data;
+	frame->linesize[ plane ] = linesize;
+
+	return true;
+}
+
+static void downsample_row( const convert_kernels_t* kernels, layout_t layout, int32_t sample_size,
+	const uint8_t* src0, const uint8_t* src1, uint8_t* dst, int32_t width )
+{
+	if( layout == LAYOUT_PLANAR_422 )
+	{
+		int32_t n = ( width + 1 ) >> 1;
+
+		if( sample_size == 1 )
+		{
+			kernels->avg2_u8( src0, src1, dst, n );
+		}
+		else
+		{
+			kernels->avg2_u16( ( const uint16_t* )src0, ( const uint16_t* )src1, ( uint16_t* )dst, n );
+		}
+	}
+	else
+	{
+		int32_t n = width >> 1;
+
+		if( sample_size == 1 )
+		{
+			kernels->avg4_u8( src0, src1, dst, n );
+			if( ( width & 1 ) != 0 )
+			{
+				dst[ n ] = ( uint8_t )( ( src0[ width - 1 ] + src1[ width - 1 ] + 1 ) >> 1 );
+			}
+		}
+		else
+		{
+			const uint16_t* row0 = ( const uint16_t* )src0;
+			const uint16_t* row1 = ( const uint16_t* )src1;
+
+			kernels->avg4_u16( row0, row1, ( uint16_t* )dst, n );
+			if( ( width & 1 ) != 0 )
+			{
+				( ( uint16_t* )dst )[ n ] = ( uint16_t )( ( row0[ width - 1 ] + row1[ width - 1 ] + 1 ) >> 1 );
+			}
+		}
+	}
+}
+
+static bool convert_frame( format_converter_t* converter, AVFrame* src, AVFrame* dst, layout_t layout, int8_t bit_depth, int32_t shift )
+{
+	const convert_kernels_t* kernels = converter->kernels;
+	int32_t sample_size = ( bit_depth > 8 ) ? 2 : 1;
+	int32_t chroma_width = ( src->width + 1 ) >> 1;
+	int32_t chroma_height = ( src->height + 1 ) >> 1;
+	AVBufferRef* luma_buffer = av_frame_get_plane_buffer( src, 0 );
+
+	if( av_frame_copy_props( dst, src ) < 0 )
+	{
+		return false;
+	}
+
+	dst->format = ( bit_depth == 8 ) ? AV_PIX_FMT_YUV420P : ( bit_depth == 10 ) ? AV_PIX_FMT_YUV420P10LE : AV_PIX_FMT_YUV420P12LE;
+	dst->width = src->width;
+	dst->height = src->height;
+
+	if( shift == 0 && luma_buffer != NULL )
+	{
+		dst->buf[ 0 ] = av_buffer_ref( luma_buffer );
+		if( dst->buf[ 0 ] == NULL )
+		{
+			return false;
+		}
+		dst->data[ 0 ] = src->data[ 0 ];
+		dst->linesize[ 0 ] = src->linesize[ 0 ];
+	}
+	else
+	{
+		// frames without reference counted buffers are only valid until the next decoder call
+		if( alloc_plane( converter, dst, 0, src->width * sample_size, src->height ) == false )
+		{
+			return false;
+		}
+
+		if( shift == 0 )
+		{
+			av_image_copy_plane( dst->data[ 0 ], dst->linesize[ 0 ], src->data[ 0 ], src->linesize[ 0 ], src->width * sample_size, src->height );
+		}
+		else
+		{
+			for( int32_t y = 0; y < src->height; y++ )
+			{
+				kernels->shift_u16( ( const uint16_t* )( src->data[ 0 ] + ( ptrdiff_t )y * src->linesize[ 0 ] ),
+					( uint16_t* )( dst->data[ 0 ] + ( ptrdiff_t )y * dst->linesize[ 0 ] ), src->width, shift );
+			}
+		}
+	}
+
+	if( alloc_plane( converter, dst, 1, chroma_width * sample_size, chroma_height ) == false ||
+		alloc_plane( converter, dst, 2, chroma_width * sample_size, chroma_height ) == false )
+	{
+		return false;
+	}
+
+	for( int32_t y = 0; y < chroma_height; y++ )
+	{
+		uint8_t* dst_u = dst->data[ 1 ] + ( ptrdiff_t )y * dst->linesize[ 1 ];
+		uint8_t* dst_v = dst->data[ 2 ] + ( ptrdiff_t )y * dst->linesize[ 2 ];
+
+		if( layout == LAYOUT_SEMI_PLANAR_420 )
+		{
+			const uint8_t* row = src->data[ 1 ] + ( ptrdiff_t )y * src->linesize[ 1 ];
+
+			if( sample_size == 1 )
+			{
+				kernels->deinterleave_u8( row, dst_u, dst_v, chroma_width );
+			}
+			else
+			{
+				kernels->deinterleave_u16( ( const uint16_t* )row, ( uint16_t* )dst_u, ( uint16_t* )dst_v, chroma_width, shift );
+			}
+		}
+		else
+		{
+			// the last row of an odd picture height is averaged with itself
+			ptrdiff_t y0 = 2 * y;
+			ptrdiff_t y1 = ( 2 * y + 1 < src->height ) ? 2 * y + 1 : 2 * y;
+
+			downsample_row( kernels, layout, sample_size, src->data[ 1 ] + y0 * src->linesize[ 1 ], src->data[ 1 ] + y1 * src->linesize[ 1 ],
+				dst_u, src->width );
+			downsample_row( kernels, layout, sample_size, src->data[ 2 ] + y0 * src->linesize[ 2 ], src->data[ 2 ] + y1 * src->linesize[ 2 ],
+				dst_v, src->width );
+		}
+	}
+
+	return true;
+}
+
+format_converter_t* format_converter_create( convert_isa_t isa )
+{
+	format_converter_t* converter;
+	const convert_kernels_t* kernels = convert_get_kernels( isa );
+
+	if( kernels == NULL )
+	{
+		return NULL;
+	}
+
+	converter = ( format_converter_t* )malloc( sizeof( format_converter_t ) );
+	if( converter == NULL )
+	{
+		return NULL;
+	}
+
+	memset( converter, 0, sizeof( format_converter_t ) );
+	converter->kernels = kernels;
+
+	return converter;
+}
+
+void format_converter_release( format_converter_t** converter )
+{
+	if( converter == NULL || *converter == NULL )
+	{
+		return;
+	}
+
+	for( int32_t i = 0; i < 3; i++ )
+	{
+		av_buffer_pool_uninit( &( *converter )->pools[ i ] );
+	}
+
+	free( *converter );
+	*converter = NULL;
+}
+
+AVFrame* format_converter_map( format_converter_t* converter, AVFrame* src, AVFrame* dst, int8_t* bit_depth )
+{
+	layout_t layout;
+	int32_t shift;
+
+	if( describe_format( src->format, &layout, bit_depth, &shift ) == false )
+	{
+		return NULL;
+	}
+
+	if( layout == LAYOUT_PLANAR_420 )
+	{
+		return src;
+	}
+
+	av_frame_unref( dst );
+
+	if( convert_frame( converter, src, dst, layout, *bit_depth, shift ) == false )
+	{
+		av_frame_unref( dst );
+		return NULL;
+	}
+
+	av_frame_unref( src );
+
+	return dst;
+}
@@ -0,0 +1,74 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief output format mapping of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_format.h
+*
+* dvpd_input_dec_picture_t carries three planes of 4:2:0 samples with 8 to 12 bits. Decoded frames in that layout
+* are passed through. Semi-planar (NV12, P010), 4:2:2 and 4:4:4 frames are converted with the kernels of
+* ffmpeg_vid_dec_convert.h into planes from a pool owned by the converter. Luma planes are shared with the decoded
+* frame whenever the samples need no conversion.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_FORMAT_H_
+#define __FFMPEG_VID_DEC_FORMAT_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_convert.h"
+#include <libavutil/frame.h>
+
+typedef struct format_converter_s_ format_converter_t;
+
+/*!
+	format_converter_create
+	@brief creates a converter using the kernels of the given instruction set, which must be supported.\n
+*/
+format_converter_t* format_converter_create( convert_isa_t isa );
+
+/*!
+	format_converter_release
+	@brief releases the converter. Converted planes still referenced are freed when their last reference is released.\n
+*/
+void format_converter_release( format_converter_t** converter );
+
+/*!
+	format_converter_map
+	@brief returns the frame to deliver for the decoded frame src and sets bit_depth.\n
+	@li src if its layout is carried as is.
+	@li dst if the frame was converted. dst holds its own references, src is unreferenced.
+	@li NULL if the format is not supported or the conversion failed. src is left untouched.
+*/
+AVFrame* format_converter_map( format_converter_t* converter, AVFrame* src, AVFrame* dst, int8_t* bit_depth );
+
+#endif // __FFMPEG_VID_DEC_FORMAT_H_
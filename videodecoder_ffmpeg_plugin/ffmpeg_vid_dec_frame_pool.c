@@ -0,0 +1,594 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "ffmpeg_vid_dec_frame_pool.h"
+#include "ffmpeg_vid_dec_placement.h"
+#include "ffmpeg_vid_dec_thread.h"
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+
+#if FRAME_POOL_SUPPORTED
+
+#define FRAME_POOL_MAX_PLANES 4
+#define FRAME_POOL_MAX_CLASSES 8
+#define FRAME_POOL_KEPT_CONFIGURATIONS 2
+#define HUGE_PAGE_SIZE ( 2 * 1024 * 1024 )
+
+#if ( LIBAVUTIL_VERSION_MAJOR < 57 )
+typedef int pool_size_t;
+#else
+typedef size_t pool_size_t;
+#endif
+
+typedef enum
+{
+	BUFFER_ALIGNED_ALLOC = 0,
+	BUFFER_MMAP
+} buffer_kind_t;
+
+typedef struct
+{
+	frame_pool_t *frame_pool;
+	buffer_kind_t kind;
+	size_t size;
+} pool_buffer_t;
+
+/*
+ * buffers of one size class, shared by the planes and formats whose size falls into the class.
+ */
+typedef struct
+{
+	AVBufferPool *pool;
+	size_t size;
+	uint32_t last_use;
+} size_class_t;
+
+struct frame_pool_s_
+{
+	vid_dec_mutex_t mutex;
+	volatile int32_t refs;
+
+	int32_t alignment;
+	frame_pool_hugepages_t hugepages;
+	int32_t numa_node;
+
+	int format;
+	int width;
+	int height;
+	int planes;
+	int linesize[ FRAME_POOL_MAX_PLANES ];
+	AVBufferPool *pools[ FRAME_POOL_MAX_PLANES ];
+	size_class_t classes[ FRAME_POOL_MAX_CLASSES ];
+	uint32_t configuration;
+
+	volatile int64_t requests;
+	volatile int64_t fallbacks;
+	volatile int64_t allocations;
+	volatile int64_t huge_page_allocations;
+	volatile int64_t node_allocations;
+	volatile int64_t bytes;
+	volatile int64_t peak_bytes;
+	volatile int64_t reconfigurations;
+	volatile int64_t reused_classes;
+};
+
+static void frame_pool_unref( frame_pool_t* frame_pool )
+{
+	if( vid_dec_atomic_add32( &frame_pool->refs, -1 ) == 0 )
+	{
+		vid_dec_mutex_destroy( &frame_pool->mutex );
+		free( frame_pool );
+	}
+}
+
+static uint8_t* aligned_alloc_bytes( size_t size, size_t alignment )
+{
+#if defined(_WIN32)
+	return ( uint8_t* )_aligned_malloc( size, alignment );
+#else
+	void* data = NULL;
+
+	if( posix_memalign( &data, alignment, size ) != 0 )
+	{
+		return NULL;
+	}
+
+	return ( uint8_t* )data;
+#endif
+}
+
+static void aligned_free_bytes( uint8_t* data )
+{
+#if defined(_WIN32)
+	_aligned_free( data );
+#else
+	free( data );
+#endif
+}
+
+#if !defined(_WIN32)
+static uint8_t* map_huge_pages( frame_pool_t* frame_pool, pool_buffer_t* buffer )
+{
+	size_t size = FFALIGN( buffer->size, HUGE_PAGE_SIZE );
+	uint8_t* data;
+	uint8_t* aligned;
+
+#if defined(MAP_HUGETLB)
+	if( frame_pool->hugepages == FRAME_POOL_HUGEPAGES_HUGETLB )
+	{
+		data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+		if( data != MAP_FAILED )
+		{
+			buffer->kind = BUFFER_MMAP;
+			buffer->size = size;
+			vid_dec_atomic_add64( &frame_pool->huge_page_allocations, 1 );
+			return data;
+		}
+	}
+#endif
+
+	// over-allocate by one huge page so that the mapping can be trimmed to a huge page boundary
+	data = mmap( NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if( data == MAP_FAILED )
+	{
+		return NULL;
+	}
+
+	aligned = ( uint8_t* )FFALIGN( ( uintptr_t )data, ( uintptr_t )HUGE_PAGE_SIZE );
+	if( aligned > data )
+	{
+		munmap( data, aligned - data );
+	}
+	if( data + size + HUGE_PAGE_SIZE > aligned + size )
+	{
+		munmap( aligned + size, ( data + size + HUGE_PAGE_SIZE ) - ( aligned + size ) );
+	}
+
+	buffer->kind = BUFFER_MMAP;
+	buffer->size = size;
+
+#if defined(MADV_HUGEPAGE)
+	if( madvise( aligned, size, MADV_HUGEPAGE ) == 0 )
+	{
+		vid_dec_atomic_add64( &frame_pool->huge_page_allocations, 1 );
+	}
+#endif
+
+	return aligned;
+}
+
+/*
+ * page aligned mapping, whose pages can be bound to a node before they are touched.
+ */
+static uint8_t* map_pages( pool_buffer_t* buffer )
+{
+	size_t page_size = ( size_t )sysconf( _SC_PAGESIZE );
+	size_t size = ( buffer->size + page_size - 1 ) / page_size * page_size;
+	uint8_t* data;
+
+	data = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if( data == MAP_FAILED )
+	{
+		return NULL;
+	}
+
+	buffer->kind = BUFFER_MMAP;
+	buffer->size = size;
+
+	return data;
+}
+#endif
+
+static void release_buffer_memory( pool_buffer_t* buffer, uint8_t* data )
+{
+#if !defined(_WIN32)
+	if( buffer->kind == BUFFER_MMAP )
+	{
+		munmap( data, buffer->size );
+		return;
+	}
+#endif
+	aligned_free_bytes( data );
+}
+
+static void pool_buffer_free( void* opaque, uint8_t* data )
+{
+	pool_buffer_t* buffer = ( pool_buffer_t* )opaque;
+
+	vid_dec_atomic_add64( &buffer->frame_pool->bytes, -( int64_t )buffer->size );
+
+	release_buffer_memory( buffer, data );
+	free( buffer );
+}
+
+static AVBufferRef* pool_buffer_alloc( void* opaque, pool_size_t size )
+{
+	frame_pool_t* frame_pool = ( frame_pool_t* )opaque;
+	pool_buffer_t* buffer;
+	AVBufferRef* buffer_ref;
+	uint8_t* data = NULL;
+
+	buffer = ( pool_buffer_t* )malloc( sizeof( pool_buffer_t ) );
+	if( buffer == NULL )
+	{
+		return NULL;
+	}
+
+	buffer->frame_pool = frame_pool;
+	buffer->kind = BUFFER_ALIGNED_ALLOC;
+	buffer->size = size;
+
+#if !defined(_WIN32)
+	if( frame_pool->hugepages != FRAME_POOL_HUGEPAGES_OFF )
+	{
+		data = map_huge_pages( frame_pool, buffer );
+	}
+
+	if( frame_pool->numa_node >= 0 )
+	{
+		if( data == NULL )
+		{
+			data = map_pages( buffer );
+		}
+
+		if( data != NULL && placement_bind_memory( data, buffer->size, frame_pool->numa_node ) == true )
+		{
+			vid_dec_atomic_add64( &frame_pool->node_allocations, 1 );
+		}
+	}
+#endif
+
+	if( data == NULL )
+	{
+		data = aligned_alloc_bytes( size, frame_pool->alignment );
+	}
+
+	if( data == NULL )
+	{
+		free( buffer );
+		return NULL;
+	}
+
+	buffer_ref = av_buffer_create( data, size, pool_buffer_free, buffer, 0 );
+	if( buffer_ref == NULL )
+	{
+		release_buffer_memory( buffer, data );
+		free( buffer );
+		return NULL;
+	}
+
+	vid_dec_atomic_add64( &frame_pool->allocations, 1 );
+	vid_dec_atomic_max64( &frame_pool->peak_bytes, vid_dec_atomic_add64( &frame_pool->bytes, ( int64_t )buffer->size ) );
+
+	return buffer_ref;
+}
+
+static void plane_pool_free( void* opaque )
+{
+	frame_pool_unref( ( frame_pool_t* )opaque );
+}
+
+static void uninit_plane_pools( frame_pool_t* frame_pool )
+{
+	for( int32_t i = 0; i < FRAME_POOL_MAX_CLASSES; i++ )
+	{
+		av_buffer_pool_uninit( &frame_pool->classes[ i ].pool );
+	}
+
+	memset( frame_pool->pools, 0, sizeof( frame_pool->pools ) );
+	frame_pool->planes = 0;
+	frame_pool->format = AV_PIX_FMT_NONE;
+}
+
+/*
+ * rounds up to a multiple of a sixteenth of the power of two below size, which wastes less than 6.25%.
+ */
+static size_t round_size_class( size_t size )
+{
+	size_t step = 4096;
+
+	while( step * 16 <= size )
+	{
+		step *= 2;
+	}
+
+	return ( size + step - 1 ) / step * step;
+}
+
+/*
+ * returns the pool of the smallest size class that holds size and wastes at most a quarter, creating the class if
+ * there is none. The least recently used class of a previous configuration makes room for it.
+ */
+static AVBufferPool* get_size_class( frame_pool_t* frame_pool, size_t size )
+{
+	size_class_t* best = NULL;
+	size_class_t* victim = NULL;
+
+	for( int32_t i = 0; i < FRAME_POOL_MAX_CLASSES; i++ )
+	{
+		size_class_t* size_class = &frame_pool->classes[ i ];
+
+		if( size_class->pool == NULL )
+		{
+			if( victim == NULL || victim->pool != NULL )
+			{
+				victim = size_class;
+			}
+			continue;
+		}
+
+		if( size_class->size >= size && size_class->size - size <= size / 4 && ( best == NULL || size_class->size < best->size ) )
+		{
+			best = size_class;
+		}
+
+		if( size_class->last_use != frame_pool->configuration &&
+			( victim == NULL || ( victim->pool != NULL && size_class->last_use < victim->last_use ) ) )
+		{
+			victim = size_class;
+		}
+	}
+
+	if( best != NULL )
+	{
+		if( best->last_use != frame_pool->configuration )
+		{
+			vid_dec_atomic_add64( &frame_pool->reused_classes, 1 );
+		}
+		best->last_use = frame_pool->configuration;
+		return best->pool;
+	}
+
+	if( victim == NULL )
+	{
+		return NULL;
+	}
+
+	// idle buffers of the evicted class are freed now, the others when the frames holding them are released
+	av_buffer_pool_uninit( &victim->pool );
+
+	victim->size = round_size_class( size );
+	victim->pool = av_buffer_pool_init2( victim->size, frame_pool, pool_buffer_alloc, plane_pool_free );
+	if( victim->pool == NULL )
+	{
+		return NULL;
+	}
+	vid_dec_atomic_add32( &frame_pool->refs, 1 );
+	victim->last_use = frame_pool->configuration;
+
+	return victim->pool;
+}
+
+static bool configure_plane_pools( frame_pool_t* frame_pool, AVCodecContext* av_codec_ctx, const AVFrame* frame, const AVPixFmtDescriptor* desc )
+{
+	int linesize_align[ AV_NUM_DATA_POINTERS ];
+	int linesize[ 4 ];
+	int width = frame->width;
+	int height = frame->height;
+	int align = frame_pool->alignment;
+	int planes = 0;
+	int unaligned;
+
+	// the pools of the previous configuration are kept, the size classes are reused by the new one
+	memset( frame_pool->pools, 0, sizeof( frame_pool->pools ) );
+	frame_pool->planes = 0;
+	frame_pool->format = AV_PIX_FMT_NONE;
+	frame_pool->configuration++;
+
+	avcodec_align_dimensions2( av_codec_ctx, &width, &height, linesize_align );
+
+	for( int32_t i = 0; i < desc->nb_components; i++ )
+	{
+		planes = FFMAX( planes, desc->comp[ i ].plane + 1 );
+	}
+
+	for( int32_t i = 0; i < planes; i++ )
+	{
+		align = FFMAX( align, linesize_align[ i ] );
+	}
+
+	// same approach as the default allocator: widen until every plane stride is aligned
+	do
+	{
+		if( av_image_fill_linesizes( linesize, ( enum AVPixelFormat )frame->format, width ) < 0 )
+		{
+			return false;
+		}
+		width += width & ~( width - 1 );
+
+		unaligned = 0;
+		for( int32_t i = 0; i < planes; i++ )
+		{
+			unaligned |= linesize[ i ] % align;
+		}
+	} while( unaligned );
+
+	for( int32_t i = 0; i < planes; i++ )
+	{
+		int32_t log2_chroma_h = ( i == 1 || i == 2 ) ? desc->log2_chroma_h : 0;
+		int32_t plane_height = ( height + ( 1 << log2_chroma_h ) - 1 ) >> log2_chroma_h;
+		size_t size = ( size_t )linesize[ i ] * plane_height + 16 + frame_pool->alignment - 1;
+
+		frame_pool->pools[ i ] = get_size_class( frame_pool, size );
+		if( frame_pool->pools[ i ] == NULL )
+		{
+			memset( frame_pool->pools, 0, sizeof( frame_pool->pools ) );
+			return false;
+		}
+
+		frame_pool->linesize[ i ] = linesize[ i ];
+	}
+
+	frame_pool->planes = planes;
+	frame_pool->format = frame->format;
+	frame_pool->width = frame->width;
+	frame_pool->height = frame->height;
+
+	// a stream switching back and forth reuses the classes of the last configurations, older ones are freed
+	for( int32_t i = 0; i < FRAME_POOL_MAX_CLASSES; i++ )
+	{
+		if( frame_pool->configuration - frame_pool->classes[ i ].last_use >= FRAME_POOL_KEPT_CONFIGURATIONS )
+		{
+			av_buffer_pool_uninit( &frame_pool->classes[ i ].pool );
+		}
+	}
+
+	return true;
+}
+
+frame_pool_t* frame_pool_create( int32_t alignment, frame_pool_hugepages_t hugepages, int32_t numa_node )
+{
+	frame_pool_t* frame_pool;
+
+	if( alignment < 16 || ( alignment & ( alignment - 1 ) ) != 0 )
+	{
+		return NULL;
+	}
+
+	frame_pool = ( frame_pool_t* )malloc( sizeof( frame_pool_t ) );
+	if( frame_pool == NULL )
+	{
+		return NULL;
+	}
+
+	memset( frame_pool, 0, sizeof( frame_pool_t ) );
+
+	vid_dec_mutex_init( &frame_pool->mutex );
+	frame_pool->refs = 1;
+	frame_pool->alignment = alignment;
+	frame_pool->hugepages = hugepages;
+	frame_pool->numa_node = numa_node;
+	frame_pool->format = AV_PIX_FMT_NONE;
+
+	return frame_pool;
+}
+
+void frame_pool_release( frame_pool_t** frame_pool )
+{
+	if( frame_pool == NULL || *frame_pool == NULL )
+	{
+		return;
+	}
+
+	vid_dec_mutex_lock( &( *frame_pool )->mutex );
+	uninit_plane_pools( *frame_pool );
+	vid_dec_mutex_unlock( &( *frame_pool )->mutex );
+
+	frame_pool_unref( *frame_pool );
+	*frame_pool = NULL;
+}
+
+int frame_pool_get_buffer( frame_pool_t* frame_pool, AVCodecContext* av_codec_ctx, AVFrame* frame, int flags )
+{
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get( ( enum AVPixelFormat )frame->format );
+
+	vid_dec_atomic_add64( &frame_pool->requests, 1 );
+
+	if( desc == NULL || ( desc->flags & ( AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL ) ) != 0 )
+	{
+		vid_dec_atomic_add64( &frame_pool->fallbacks, 1 );
+		return avcodec_default_get_buffer2( av_codec_ctx, frame, flags );
+	}
+
+	vid_dec_mutex_lock( &frame_pool->mutex );
+
+	if( frame_pool->format != frame->format || frame_pool->width != frame->width || frame_pool->height != frame->height )
+	{
+		if( frame_pool->format != AV_PIX_FMT_NONE )
+		{
+			vid_dec_atomic_add64( &frame_pool->reconfigurations, 1 );
+		}
+
+		if( configure_plane_pools( frame_pool, av_codec_ctx, frame, desc ) == false )
+		{
+			vid_dec_mutex_unlock( &frame_pool->mutex );
+			return AVERROR( ENOMEM );
+		}
+	}
+
+	for( int32_t i = 0; i < frame_pool->planes; i++ )
+	{
+		frame->buf[ i ] = av_buffer_pool_get( frame_pool->pools[ i ] );
+		if( frame->buf[ i ] == NULL )
+		{
+			vid_dec_mutex_unlock( &frame_pool->mutex );
+			av_frame_unref( frame );
+			return AVERROR( ENOMEM );
+		}
+
+		frame->data[ i ] = frame->buf[ i ]->data;
+		frame->linesize[ i ] = frame_pool->linesize[ i ];
+	}
+
+	vid_dec_mutex_unlock( &frame_pool->mutex );
+
+	frame->extended_data = frame->data;
+
+	return 0;
+}
+
+void frame_pool_trim( frame_pool_t* frame_pool )
+{
+	vid_dec_mutex_lock( &frame_pool->mutex );
+	uninit_plane_pools( frame_pool );
+	vid_dec_mutex_unlock( &frame_pool->mutex );
+}
+
+void frame_pool_get_stats( frame_pool_t* frame_pool, frame_pool_stats_t* stats )
+{
+	memset( stats, 0, sizeof( frame_pool_stats_t ) );
+
+	if( frame_pool == NULL )
+	{
+		return;
+	}
+
+	stats->requests = vid_dec_atomic_load64( &frame_pool->requests );
+	stats->fallbacks = vid_dec_atomic_load64( &frame_pool->fallbacks );
+	stats->allocations = vid_dec_atomic_load64( &frame_pool->allocations );
+	stats->huge_page_allocations = vid_dec_atomic_load64( &frame_pool->huge_page_allocations );
+	stats->node_allocations = vid_dec_atomic_load64( &frame_pool->node_allocations );
+	stats->bytes = vid_dec_atomic_load64( &frame_pool->bytes );
+	stats->peak_bytes = vid_dec_atomic_load64( &frame_pool->peak_bytes );
+	stats->reconfigurations = vid_dec_atomic_load64( &frame_pool->reconfigurations );
+	stats->reused_classes = vid_dec_atomic_load64( &frame_pool->reused_classes );
+}
+
+#endif // FRAME_POOL_SUPPORTED
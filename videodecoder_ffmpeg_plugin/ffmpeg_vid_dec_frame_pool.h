@@ -0,0 +1,107 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief pooled frame buffer allocator of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_frame_pool.h
+*
+* Plane buffers are pooled by size class. A change of the frame size or pixel format within the stream only assigns
+* the planes to size classes again: classes that fit the new planes keep their buffers, and the classes of the
+* previous configuration stay available, so that a stream switching between two formats allocates nothing.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_FRAME_POOL_H_
+#define __FFMPEG_VID_DEC_FRAME_POOL_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include <libavcodec/avcodec.h>
+
+#define FRAME_POOL_SUPPORTED ( LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(56,0,100) )
+
+typedef enum
+{
+	FRAME_POOL_HUGEPAGES_OFF = 0,
+	FRAME_POOL_HUGEPAGES_THP,           /**< @details transparent huge pages (madvise) */
+	FRAME_POOL_HUGEPAGES_HUGETLB        /**< @details reserved huge pages (MAP_HUGETLB), falls back to transparent huge pages */
+} frame_pool_hugepages_t;
+
+typedef struct
+{
+	int64_t requests;                   /**< @details frames requested by the decoder */
+	int64_t fallbacks;                  /**< @details frames passed on to the default allocator of libavcodec */
+	int64_t allocations;                /**< @details plane buffers allocated from the system */
+	int64_t huge_page_allocations;      /**< @details plane buffers backed by huge pages */
+	int64_t node_allocations;           /**< @details plane buffers bound to the NUMA node of the pool */
+	int64_t bytes;                      /**< @details bytes currently allocated by the pool */
+	int64_t peak_bytes;                 /**< @details maximum of bytes */
+	int64_t reconfigurations;           /**< @details changes of the frame size or pixel format within the stream */
+	int64_t reused_classes;             /**< @details size classes of a previous configuration reused by a new one */
+} frame_pool_stats_t;
+
+typedef struct frame_pool_s_ frame_pool_t;
+
+/*!
+	frame_pool_create
+	@brief creates a frame pool.\n
+	@param [in]  alignment alignment of plane pointers and strides in bytes (power of two).
+	@param [in]  hugepages huge page backing of the plane buffers.
+	@param [in]  numa_node NUMA node the plane buffers are allocated on (Linux only), -1 for the first touch policy.
+	@return the frame pool or NULL on error
+*/
+frame_pool_t* frame_pool_create( int32_t alignment, frame_pool_hugepages_t hugepages, int32_t numa_node );
+
+/*!
+	frame_pool_release
+	@brief releases the frame pool. Buffers still referenced by frames are freed when the last frame is released.\n
+*/
+void frame_pool_release( frame_pool_t** frame_pool );
+
+/*!
+	frame_pool_trim
+	@brief frees the idle buffers of the pool. Buffers still referenced by frames are freed when they are released.\n
+*/
+void frame_pool_trim( frame_pool_t* frame_pool );
+
+/*!
+	frame_pool_get_buffer
+	@brief get_buffer2 implementation. Thread safe.\n
+*/
+int frame_pool_get_buffer( frame_pool_t* frame_pool, AVCodecContext* av_codec_ctx, AVFrame* frame, int flags );
+
+/*!
+	frame_pool_get_stats
+	@brief returns the allocation statistics of the frame pool.\n
+*/
+void frame_pool_get_stats( frame_pool_t* frame_pool, frame_pool_stats_t* stats );
+
+#endif // __FFMPEG_VID_DEC_FRAME_POOL_H_
@@ -0,0 +1,723 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_gop_decoder.h"
+#include "ffmpeg_vid_dec_parameter_sets.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+#if GOP_DECODER_SUPPORTED
+
+#define INITIAL_CAPACITY 16
+
+typedef enum
+{
+	AU_NONE = 0,                        /**< @details no slice data */
+	AU_TRAILING,
+	AU_RADL,
+	AU_RASL,
+	AU_CRA,
+	AU_KEY                              /**< @details IDR and BLA pictures */
+} au_kind_t;
+
+typedef struct
+{
+	AVFrame *frame;
+	picture_sequence_t sequence;
+} segment_output_t;
+
+typedef struct segment_s_
+{
+	struct segment_s_ *next;
+
+	AVPacket **packets;
+	int32_t packet_count;
+	int32_t packet_capacity;
+	bool leading_parameter_sets;        /**< @details the first packet holds the parameter sets of earlier segments */
+	int32_t pictures;
+
+	segment_output_t *outputs;
+	int32_t output_count;
+	int32_t output_capacity;
+	bool done;
+} segment_t;
+
+typedef struct
+{
+	gop_decoder_t *gop;
+	pooled_codec_t codec;
+	AVFrame *frame;
+	vid_dec_thread_t thread;
+	bool running;
+} gop_worker_t;
+
+struct gop_decoder_s_
+{
+	nal_codec_t codec;
+	int32_t max_segments;
+	gop_output_func_t output;
+	void *opaque;
+	dec_stats_t *stats;
+
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t work;
+	vid_dec_cond_t done;
+	segment_t *head;                    /**< @details oldest dispatched segment, output next */
+	segment_t *tail;
+	segment_t *next_job;                /**< @details first dispatched segment no worker has taken */
+	int32_t in_flight;
+	bool stop;
+
+	gop_worker_t *workers;
+	int32_t worker_count;
+
+	segment_t *current;                 /**< @details segment receiving the access units */
+	segment_t *held;                    /**< @details segment before the CRA picture starting current, until its leading pictures are known */
+
+	parameter_sets_t parameter_sets;
+
+	gop_decoder_stats_t counters;
+};
+
+static au_kind_t classify( nal_codec_t codec, int32_t type )
+{
+	if( type < 0 )
+	{
+		return AU_NONE;
+	}
+
+	if( nal_is_idr( codec, type ) == true )
+	{
+		return AU_KEY;
+	}
+
+	if( codec == NAL_CODEC_AVC )
+	{
+		return AU_TRAILING;
+	}
+
+	switch( type )
+	{
+	case HEVC_NAL_CRA:
+		return AU_CRA;
+	case HEVC_NAL_RASL_N:
+	case HEVC_NAL_RASL_R:
+		return AU_RASL;
+	case HEVC_NAL_RADL_N:
+	case HEVC_NAL_RADL_R:
+		return AU_RADL;
+	default:
+		return AU_TRAILING;
+	}
+}
+
+/*
+ * stores the parameter sets ahead of the first slice and classifies the access unit by its first slice.
+ */
+static au_kind_t inspect_access_unit( gop_decoder_t* gop, const AVPacket* pkt )
+{
+	nal_iterator_t it;
+	nal_unit_t nal;
+
+	nal_iterator_init( &it, gop->codec, pkt->data, pkt->size );
+
+	while( nal_iterator_next( &it, &nal ) == true )
+	{
+		if( nal_is_vcl( gop->codec, nal.type ) == true )
+		{
+			return classify( gop->codec, nal.type );
+		}
+
+		if( nal_is_parameter_set( gop->codec, nal.type ) == true )
+		{
+			parameter_sets_store( &gop->parameter_sets, &nal );
+		}
+	}
+
+	return AU_NONE;
+}
+
+static AVPacket* create_parameter_set_packet( gop_decoder_t* gop )
+{
+	AVPacket* pkt;
+	int32_t size;
+	uint8_t* data = parameter_sets_write( &gop->parameter_sets, &size );
+
+	if( data == NULL )
+	{
+		return NULL;
+	}
+
+	pkt = av_packet_alloc( );
+	if( pkt == NULL || av_packet_from_data( pkt, data, size ) < 0 )
+	{
+		av_packet_free( &pkt );
+		av_free( data );
+		return NULL;
+	}
+
+	return pkt;
+}
+
+static bool add_packet( segment_t* segment, AVPacket* pkt )
+{
+	if( segment->packet_count == segment->packet_capacity )
+	{
+		int32_t capacity = segment->packet_capacity > 0 ? segment->packet_capacity * 2 : INITIAL_CAPACITY;
+		AVPacket** packets = ( AVPacket** )realloc( segment->packets, capacity * sizeof( AVPacket* ) );
+
+		if( packets == NULL )
+		{
+			return false;
+		}
+
+		segment->packets = packets;
+		segment->packet_capacity = capacity;
+	}
+
+	segment->packets[ segment->packet_count++ ] = pkt;
+
+	return true;
+}
+
+static bool add_output( segment_t* segment, AVFrame* frame, const picture_sequence_t* sequence )
+{
+	if( segment->output_count == segment->output_capacity )
+	{
+		int32_t capacity = segment->output_capacity > 0 ? segment->output_capacity * 2 : INITIAL_CAPACITY;
+		segment_output_t* outputs = ( segment_output_t* )realloc( segment->outputs, capacity * sizeof( segment_output_t ) );
+
+		if( outputs == NULL )
+		{
+			return false;
+		}
+
+		segment->outputs = outputs;
+		segment->output_capacity = capacity;
+	}
+
+	segment->outputs[ segment->output_count ].frame = frame;
+	segment->outputs[ segment->output_count ].sequence = *sequence;
+	segment->output_count++;
+
+	return true;
+}
+
+static segment_t* create_segment( gop_decoder_t* gop )
+{
+	segment_t* segment = ( segment_t* )malloc( sizeof( segment_t ) );
+	AVPacket* pkt;
+
+	if( segment == NULL )
+	{
+		return NULL;
+	}
+
+	memset( segment, 0, sizeof( segment_t ) );
+
+	// the access units of the segment may refer to parameter sets of earlier segments
+	pkt = create_parameter_set_packet( gop );
+	if( pkt != NULL )
+	{
+		if( add_packet( segment, pkt ) == true )
+		{
+			segment->leading_parameter_sets = true;
+		}
+		else
+		{
+			av_packet_free( &pkt );
+		}
+	}
+
+	return segment;
+}
+
+static void free_segment( segment_t** segment )
+{
+	if( *segment == NULL )
+	{
+		return;
+	}
+
+	for( int32_t i = 0; i < ( *segment )->packet_count; i++ )
+	{
+		av_packet_free( &( *segment )->packets[ i ] );
+	}
+
+	for( int32_t i = 0; i < ( *segment )->output_count; i++ )
+	{
+		av_frame_free( &( *segment )->outputs[ i ].frame );
+	}
+
+	free( ( *segment )->packets );
+	free( ( *segment )->outputs );
+	free( *segment );
+	*segment = NULL;
+}
+
+/*
+ * appends the access units of the segment started by a CRA picture to the previous segment.
+ */
+static void merge_segments( segment_t* previous, segment_t** segment )
+{
+	int32_t first = ( *segment )->leading_parameter_sets ? 1 : 0;
+
+	for( int32_t i = first; i < ( *segment )->packet_count; i++ )
+	{
+		if( add_packet( previous, ( *segment )->packets[ i ] ) == true )
+		{
+			( *segment )->packets[ i ] = NULL;
+		}
+	}
+	previous->pictures += ( *segment )->pictures;
+
+	free_segment( segment );
+}
+
+static void receive_frames( gop_worker_t* worker, segment_t* segment )
+{
+	AVCodecContext* av_codec_ctx = worker->codec.av_codec_ctx;
+	dec_stats_t* stats = worker->gop->stats;
+
+	while( 1 )
+	{
+		picture_sequence_t sequence;
+		int32_t ret;
+
+		if( worker->frame == NULL )
+		{
+			worker->frame = av_frame_alloc( );
+			if( worker->frame == NULL )
+			{
+				return;
+			}
+		}
+
+		ret = avcodec_receive_frame( av_codec_ctx, worker->frame );
+		if( ret == AVERROR( EAGAIN ) || ret == AVERROR_EOF )
+		{
+			return;
+		}
+		else if( ret < 0 )
+		{
+			dec_stats_add( &stats->receive_errors, 1 );
+			av_log( av_codec_ctx, AV_LOG_VERBOSE, "error during decoding: %s\n", av_err2str( ret ) );
+			return;
+		}
+
+		picture_sequence_read( &sequence, av_codec_ctx );
+		if( add_output( segment, worker->frame, &sequence ) == false )
+		{
+			dec_stats_add( &stats->frames_dropped[ DVPD_INPUT_DEC_DROP_MEMORY ], 1 );
+			av_frame_unref( worker->frame );
+			continue;
+		}
+
+		worker->frame = NULL;
+	}
+}
+
+static void decode_segment( gop_worker_t* worker, segment_t* segment )
+{
+	AVCodecContext* av_codec_ctx = worker->codec.av_codec_ctx;
+	dec_stats_t* stats = worker->gop->stats;
+
+	// the segment ends with a drain, which outputs all of its pictures
+	for( int32_t i = 0; i <= segment->packet_count; i++ )
+	{
+		AVPacket* pkt = ( i < segment->packet_count ) ? segment->packets[ i ] : NULL;
+		int32_t ret;
+
+		if( i < segment->packet_count && pkt == NULL )
+		{
+			continue;
+		}
+
+		ret = avcodec_send_packet( av_codec_ctx, pkt );
+		if( ret < 0 )
+		{
+			dec_stats_add( &stats->send_errors, 1 );
+			av_log( av_codec_ctx, AV_LOG_VERBOSE, "error sending a packet for decoding: %s\n", av_err2str( ret ) );
+		}
+		else if( pkt != NULL && ( i > 0 || segment->leading_parameter_sets == false ) )
+		{
+			dec_stats_add( &stats->packets_decoded, 1 );
+			dec_stats_add( &stats->bytes_decoded, pkt->size );
+		}
+
+		// the input buffer returns to its pool as soon as libavcodec is done with it
+		if( pkt != NULL )
+		{
+			av_packet_free( &segment->packets[ i ] );
+		}
+
+		receive_frames( worker, segment );
+	}
+
+	avcodec_flush_buffers( av_codec_ctx );
+}
+
+static VID_DEC_THREAD_FUNC( gop_worker, arg )
+{
+	gop_worker_t* worker = ( gop_worker_t* )arg;
+	gop_decoder_t* gop = worker->gop;
+
+	vid_dec_mutex_lock( &gop->mutex );
+
+	while( 1 )
+	{
+		segment_t* segment;
+
+		while( gop->stop == false && gop->next_job == NULL )
+		{
+			vid_dec_cond_wait( &gop->work, &gop->mutex );
+		}
+
+		if( gop->stop == true )
+		{
+			break;
+		}
+
+		segment = gop->next_job;
+		gop->next_job = segment->next;
+		vid_dec_mutex_unlock( &gop->mutex );
+
+		decode_segment( worker, segment );
+
+		vid_dec_mutex_lock( &gop->mutex );
+		segment->done = true;
+		vid_dec_cond_broadcast( &gop->done );
+	}
+
+	vid_dec_mutex_unlock( &gop->mutex );
+
+	return VID_DEC_THREAD_EXIT;
+}
+
+/*
+ * outputs the pictures of the oldest dispatched segment. Returns false if there is none or, without wait, if it is
+ * still being decoded.
+ */
+static bool output_segment( gop_decoder_t* gop, bool wait )
+{
+	segment_t* segment;
+
+	vid_dec_mutex_lock( &gop->mutex );
+
+	segment = gop->head;
+	while( segment != NULL && segment->done == false && wait == true )
+	{
+		vid_dec_cond_wait( &gop->done, &gop->mutex );
+	}
+
+	if( segment == NULL || segment->done == false )
+	{
+		vid_dec_mutex_unlock( &gop->mutex );
+		return false;
+	}
+
+	gop->head = segment->next;
+	if( gop->head == NULL )
+	{
+		gop->tail = NULL;
+	}
+	gop->in_flight--;
+
+	vid_dec_mutex_unlock( &gop->mutex );
+
+	for( int32_t i = 0; i < segment->output_count; i++ )
+	{
+		gop->output( gop->opaque, segment->outputs[ i ].frame, &segment->outputs[ i ].sequence );
+		av_frame_free( &segment->outputs[ i ].frame );
+	}
+
+	free_segment( &segment );
+
+	return true;
+}
+
+static void dispatch( gop_decoder_t* gop, segment_t* segment )
+{
+	while( output_segment( gop, false ) == true )
+	{
+	}
+
+	// the decoded pictures of the segments in flight bound the memory
+	while( gop->in_flight >= gop->max_segments )
+	{
+		output_segment( gop, true );
+	}
+
+	vid_dec_mutex_lock( &gop->mutex );
+
+	if( gop->tail != NULL )
+	{
+		gop->tail->next = segment;
+	}
+	else
+	{
+		gop->head = segment;
+	}
+	gop->tail = segment;
+
+	if( gop->next_job == NULL )
+	{
+		gop->next_job = segment;
+	}
+	gop->in_flight++;
+	gop->counters.segments++;
+
+	vid_dec_cond_signal( &gop->work );
+	vid_dec_mutex_unlock( &gop->mutex );
+}
+
+gop_decoder_t* gop_decoder_create( nal_codec_t codec, int32_t segments, gop_open_codec_func_t open_codec, gop_output_func_t output,
+	void* opaque, dec_stats_t* stats )
+{
+	gop_decoder_t* gop;
+
+	gop = ( gop_decoder_t* )malloc( sizeof( gop_decoder_t ) );
+	if( gop == NULL )
+	{
+		return NULL;
+	}
+
+	memset( gop, 0, sizeof( gop_decoder_t ) );
+
+	gop->codec = codec;
+	gop->max_segments = segments;
+	gop->output = output;
+	gop->opaque = opaque;
+	gop->stats = stats;
+
+	vid_dec_mutex_init( &gop->mutex );
+	vid_dec_cond_init( &gop->work );
+	vid_dec_cond_init( &gop->done );
+
+	gop->workers = ( gop_worker_t* )calloc( segments, sizeof( gop_worker_t ) );
+	if( gop->workers == NULL )
+	{
+		goto bail;
+	}
+
+	for( ; gop->worker_count < segments; gop->worker_count++ )
+	{
+		gop_worker_t* worker = &gop->workers[ gop->worker_count ];
+
+		worker->gop = gop;
+
+		if( open_codec( opaque, &worker->codec ) == false )
+		{
+			goto bail;
+		}
+
+		if( vid_dec_thread_create( &worker->thread, gop_worker, worker ) == false )
+		{
+			gop->worker_count++;
+			goto bail;
+		}
+		worker->running = true;
+	}
+
+	return gop;
+
+bail:
+	gop_decoder_release( &gop, NULL );
+
+	return NULL;
+}
+
+void gop_decoder_release( gop_decoder_t** gop, gop_decoder_stats_t* stats )
+{
+	if( gop == NULL || *gop == NULL )
+	{
+		return;
+	}
+
+	gop_decoder_discard( *gop );
+
+	vid_dec_mutex_lock( &( *gop )->mutex );
+	( *gop )->stop = true;
+	vid_dec_cond_broadcast( &( *gop )->work );
+	vid_dec_mutex_unlock( &( *gop )->mutex );
+
+	for( int32_t i = 0; i < ( *gop )->worker_count; i++ )
+	{
+		gop_worker_t* worker = &( *gop )->workers[ i ];
+
+		if( worker->running == true )
+		{
+			vid_dec_thread_join( worker->thread );
+		}
+
+		av_frame_free( &worker->frame );
+		avcodec_free_context( &worker->codec.av_codec_ctx );
+#if FRAME_POOL_SUPPORTED
+		frame_pool_release( &worker->codec.frame_pool );
+#endif
+	}
+
+	parameter_sets_clear( &( *gop )->parameter_sets );
+
+	if( stats != NULL )
+	{
+		*stats = ( *gop )->counters;
+	}
+
+	vid_dec_cond_destroy( &( *gop )->done );
+	vid_dec_cond_destroy( &( *gop )->work );
+	vid_dec_mutex_destroy( &( *gop )->mutex );
+	free( ( *gop )->workers );
+	free( *gop );
+	*gop = NULL;
+}
+
+void gop_decoder_push( gop_decoder_t* gop, AVPacket* pkt )
+{
+	au_kind_t kind = inspect_access_unit( gop, pkt );
+
+	// RASL pictures reference pictures before their CRA picture, which a decoder starting at the CRA picture skips
+	if( gop->held != NULL )
+	{
+		if( kind == AU_RASL )
+		{
+			merge_segments( gop->held, &gop->current );
+			gop->current = gop->held;
+			gop->held = NULL;
+			gop->counters.merged++;
+		}
+		else if( kind != AU_NONE && kind != AU_RADL )
+		{
+			dispatch( gop, gop->held );
+			gop->held = NULL;
+		}
+	}
+
+	if( ( kind == AU_KEY || kind == AU_CRA ) && gop->current != NULL && gop->current->pictures > 0 )
+	{
+		if( kind == AU_CRA )
+		{
+			gop->held = gop->current;
+		}
+		else
+		{
+			dispatch( gop, gop->current );
+		}
+		gop->current = NULL;
+	}
+
+	if( gop->current == NULL )
+	{
+		gop->current = create_segment( gop );
+		if( gop->current == NULL )
+		{
+			dec_stats_add( &gop->stats->send_errors, 1 );
+			av_packet_free( &pkt );
+			return;
+		}
+	}
+
+	if( add_packet( gop->current, pkt ) == false )
+	{
+		dec_stats_add( &gop->stats->send_errors, 1 );
+		av_packet_free( &pkt );
+		return;
+	}
+
+	if( kind != AU_NONE )
+	{
+		gop->current->pictures++;
+	}
+}
+
+void gop_decoder_drain( gop_decoder_t* gop )
+{
+	if( gop->held != NULL )
+	{
+		dispatch( gop, gop->held );
+		gop->held = NULL;
+	}
+
+	if( gop->current != NULL )
+	{
+		dispatch( gop, gop->current );
+		gop->current = NULL;
+	}
+
+	while( output_segment( gop, true ) == true )
+	{
+	}
+}
+
+void gop_decoder_discard( gop_decoder_t* gop )
+{
+	segment_t* segment;
+
+	free_segment( &gop->held );
+	free_segment( &gop->current );
+
+	vid_dec_mutex_lock( &gop->mutex );
+
+	// segments no worker has taken are dropped without decoding
+	for( segment = gop->next_job; segment != NULL; segment = segment->next )
+	{
+		segment->done = true;
+	}
+	gop->next_job = NULL;
+
+	for( segment = gop->head; segment != NULL; segment = segment->next )
+	{
+		while( segment->done == false )
+		{
+			vid_dec_cond_wait( &gop->done, &gop->mutex );
+		}
+	}
+
+	segment = gop->head;
+	gop->head = NULL;
+	gop->tail = NULL;
+	gop->in_flight = 0;
+
+	vid_dec_mutex_unlock( &gop->mutex );
+
+	while( segment != NULL )
+	{
+		segment_t* next = segment->next;
+
+		free_segment( &segment );
+		segment = next;
+	}
+}
+
+#endif // GOP_DECODER_SUPPORTED
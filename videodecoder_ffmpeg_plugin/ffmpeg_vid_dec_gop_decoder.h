@@ -0,0 +1,115 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief GOP parallel decoding of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_gop_decoder.h
+*
+* The access units are collected in segments starting at key pictures, which are decoded on a set of independent
+* codec contexts at the same time. Each segment is decoded from its start to a drain, so its pictures are the ones a
+* single decoder outputs for it. The pictures are output on the thread passing the access units, segment by segment
+* in stream order, which keeps the presentation order. Parameter sets of earlier segments are passed ahead of every
+* segment.
+*
+* HEVC segments start at IDR and BLA pictures and at CRA pictures without RASL pictures, which reference pictures of
+* the previous segment. A CRA picture with RASL pictures continues the previous segment. AVC segments start at IDR
+* pictures. Open GOPs starting at recovery points are not split.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_GOP_DECODER_H_
+#define __FFMPEG_VID_DEC_GOP_DECODER_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_context_pool.h"
+#include "ffmpeg_vid_dec_nal.h"
+#include "ffmpeg_vid_dec_picture_info.h"
+#include "ffmpeg_vid_dec_stats.h"
+#include <libavcodec/avcodec.h>
+
+// segments are drained with the decode API of avcodec_send_packet
+#define GOP_DECODER_SUPPORTED ( LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101) )
+
+typedef struct
+{
+	int64_t segments;                   /**< @details segments decoded */
+	int64_t merged;                     /**< @details CRA pictures continuing the previous segment */
+} gop_decoder_stats_t;
+
+typedef struct gop_decoder_s_ gop_decoder_t;
+
+/*!
+	gop_open_codec_func_t
+	@brief opens the codec context of a worker.\n
+*/
+typedef bool( *gop_open_codec_func_t )( void* opaque, pooled_codec_t* codec );
+
+/*!
+	gop_output_func_t
+	@brief outputs a decoded frame. The callback may move the reference out of frame, which is freed afterwards.\n
+*/
+typedef void( *gop_output_func_t )( void* opaque, AVFrame* frame, const picture_sequence_t* sequence );
+
+/*!
+	gop_decoder_create
+	@brief creates a GOP decoder decoding up to segments segments at the same time, each on its own worker thread and
+	codec context. Decoded packets and errors are counted in stats.\n
+*/
+gop_decoder_t* gop_decoder_create( nal_codec_t codec, int32_t segments, gop_open_codec_func_t open_codec, gop_output_func_t output,
+	void* opaque, dec_stats_t* stats );
+
+/*!
+	gop_decoder_release
+	@brief drops all pending access units and pictures, stops the workers and frees the decoder.\n
+*/
+void gop_decoder_release( gop_decoder_t** gop, gop_decoder_stats_t* stats );
+
+/*!
+	gop_decoder_push
+	@brief passes a reference counted access unit, which the decoder takes over. Outputs the pictures of the segments
+	decoded so far and blocks while the maximum number of segments is in flight.\n
+*/
+void gop_decoder_push( gop_decoder_t* gop, AVPacket* pkt );
+
+/*!
+	gop_decoder_drain
+	@brief decodes all pending access units and outputs their pictures.\n
+*/
+void gop_decoder_drain( gop_decoder_t* gop );
+
+/*!
+	gop_decoder_discard
+	@brief drops all pending access units and pictures.\n
+*/
+void gop_decoder_discard( gop_decoder_t* gop );
+
+#endif // __FFMPEG_VID_DEC_GOP_DECODER_H_
@@ -0,0 +1,544 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "ffmpeg_vid_dec_hash.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HASH_X86 1
+#else
+#define HASH_X86 0
+#endif
+
+#if HASH_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_AVX512
+#else
+#define TARGET_SSE41 __attribute__(( target( "sse4.1" ) ))
+#define TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#define TARGET_AVX512 __attribute__(( target( "avx512f" ) ))
+#endif
+#include <immintrin.h>
+#endif
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+
+#define SECRET_SIZE 192
+#define SECRET_CONSUME_RATE 8
+#define SECRET_MERGEACCS_START 11
+#define SECRET_LASTACC_START 7
+#define STRIPES_PER_BLOCK ( ( SECRET_SIZE - HASH_STRIPE_SIZE ) / SECRET_CONSUME_RATE )
+#define MID_SIZE_MAX 240
+
+static const uint8_t secret[ SECRET_SIZE ] =
+{
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+static const uint64_t initial_acc[ 8 ] =
+{
+	0xC2B2AE3DU, PRIME64_1, PRIME64_2, PRIME64_3, 0x85EBCA77C2B2AE63ULL, 0x85EBCA77U, 0x27D4EB2F165667C5ULL, PRIME32_1
+};
+
+// the hash is defined on little endian values
+static inline uint32_t read32( const uint8_t* data )
+{
+	return ( uint32_t )data[ 0 ] | ( ( uint32_t )data[ 1 ] << 8 ) | ( ( uint32_t )data[ 2 ] << 16 ) | ( ( uint32_t )data[ 3 ] << 24 );
+}
+
+static inline uint64_t read64( const uint8_t* data )
+{
+	return ( uint64_t )read32( data ) | ( ( uint64_t )read32( data + 4 ) << 32 );
+}
+
+static inline uint64_t swap64( uint64_t x )
+{
+	x = ( ( x << 8 ) & 0xFF00FF00FF00FF00ULL ) | ( ( x >> 8 ) & 0x00FF00FF00FF00FFULL );
+	x = ( ( x << 16 ) & 0xFFFF0000FFFF0000ULL ) | ( ( x >> 16 ) & 0x0000FFFF0000FFFFULL );
+
+	return ( x << 32 ) | ( x >> 32 );
+}
+
+/*
+ * xor of the upper and lower half of the 128 bit product.
+ */
+static inline uint64_t mul128_fold64( uint64_t a, uint64_t b )
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 product = ( unsigned __int128 )a * b;
+
+	return ( uint64_t )product ^ ( uint64_t )( product >> 64 );
+#else
+	uint64_t lo_lo = ( a & 0xFFFFFFFF ) * ( b & 0xFFFFFFFF );
+	uint64_t hi_lo = ( a >> 32 ) * ( b & 0xFFFFFFFF );
+	uint64_t lo_hi = ( a & 0xFFFFFFFF ) * ( b >> 32 );
+	uint64_t hi_hi = ( a >> 32 ) * ( b >> 32 );
+	uint64_t cross = ( lo_lo >> 32 ) + ( hi_lo & 0xFFFFFFFF ) + lo_hi;
+	uint64_t upper = ( hi_lo >> 32 ) + ( cross >> 32 ) + hi_hi;
+	uint64_t lower = ( cross << 32 ) | ( lo_lo & 0xFFFFFFFF );
+
+	return lower ^ upper;
+#endif
+}
+
+static inline uint64_t xxh64_avalanche( uint64_t h )
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+
+	return h ^ ( h >> 32 );
+}
+
+static inline uint64_t avalanche( uint64_t h )
+{
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ULL;
+
+	return h ^ ( h >> 32 );
+}
+
+static inline uint64_t rrmxmx( uint64_t h, uint64_t size )
+{
+	h ^= ( ( h << 49 ) | ( h >> 15 ) ) ^ ( ( h << 24 ) | ( h >> 40 ) );
+	h *= 0x9FB21C651E98DF25ULL;
+	h ^= ( h >> 35 ) + size;
+	h *= 0x9FB21C651E98DF25ULL;
+
+	return h ^ ( h >> 28 );
+}
+
+static inline uint64_t mix16( const uint8_t* data, const uint8_t* key )
+{
+	return mul128_fold64( read64( data ) ^ read64( key ), read64( data + 8 ) ^ read64( key + 8 ) );
+}
+
+static void accumulate_c( uint64_t* acc, const uint8_t* data, const uint8_t* key, size_t stripes )
+{
+	for( size_t n = 0; n < stripes; n++ )
+	{
+		for( int32_t i = 0; i < 8; i++ )
+		{
+			uint64_t value = read64( data + 8 * i );
+			uint64_t keyed = value ^ read64( key + 8 * i );
+
+			acc[ i ^ 1 ] += value;
+			acc[ i ] += ( keyed & 0xFFFFFFFF ) * ( keyed >> 32 );
+		}
+
+		data += HASH_STRIPE_SIZE;
+		key += SECRET_CONSUME_RATE;
+	}
+}
+
+static void scramble_c( uint64_t* acc, const uint8_t* key )
+{
+	for( int32_t i = 0; i < 8; i++ )
+	{
+		uint64_t value = acc[ i ];
+
+		value ^= value >> 47;
+		value ^= read64( key + 8 * i );
+		acc[ i ] = value * PRIME32_1;
+	}
+}
+
+#if HASH_X86
+/*
+ * every 64 bit lane adds the product of the low and high half of the keyed input and the input of its neighbour lane.
+ */
+TARGET_SSE41 static void accumulate_sse41( uint64_t* acc, const uint8_t* data, const uint8_t* key, size_t stripes )
+{
+	__m128i a[ 4 ];
+
+	for( int32_t i = 0; i < 4; i++ )
+	{
+		a[ i ] = _mm_loadu_si128( ( const __m128i* )acc + i );
+	}
+
+	for( size_t n = 0; n < stripes; n++ )
+	{
+		for( int32_t i = 0; i < 4; i++ )
+		{
+			__m128i value = _mm_loadu_si128( ( const __m128i* )data + i );
+			__m128i keyed = _mm_xor_si128( value, _mm_loadu_si128( ( const __m128i* )key + i ) );
+			__m128i product = _mm_mul_epu32( keyed, _mm_srli_epi64( keyed, 32 ) );
+
+			a[ i ] = _mm_add_epi64( a[ i ], _mm_add_epi64( product, _mm_shuffle_epi32( value, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+		}
+
+		data += HASH_STRIPE_SIZE;
+		key += SECRET_CONSUME_RATE;
+	}
+
+	for( int32_t i = 0; i < 4; i++ )
+	{
+		_mm_storeu_si128( ( __m128i* )acc + i, a[ i ] );
+	}
+}
+
+TARGET_SSE41 static void scramble_sse41( uint64_t* acc, const uint8_t* key )
+{
+	const __m128i prime = _mm_set1_epi32( ( int32_t )PRIME32_1 );
+
+	for( int32_t i = 0; i < 4; i++ )
+	{
+		__m128i value = _mm_loadu_si128( ( const __m128i* )acc + i );
+		__m128i keyed;
+
+		value = _mm_xor_si128( value, _mm_srli_epi64( value, 47 ) );
+		keyed = _mm_xor_si128( value, _mm_loadu_si128( ( const __m128i* )key + i ) );
+
+		// 64 x 32 bit multiplication from two 32 x 32 bit products
+		value = _mm_add_epi64( _mm_mul_epu32( keyed, prime ), _mm_slli_epi64( _mm_mul_epu32( _mm_srli_epi64( keyed, 32 ), prime ), 32 ) );
+		_mm_storeu_si128( ( __m128i* )acc + i, value );
+	}
+}
+
+TARGET_AVX2 static void accumulate_avx2( uint64_t* acc, const uint8_t* data, const uint8_t* key, size_t stripes )
+{
+	__m256i a0 = _mm256_loadu_si256( ( const __m256i* )acc );
+	__m256i a1 = _mm256_loadu_si256( ( const __m256i* )acc + 1 );
+
+	for( size_t n = 0; n < stripes; n++ )
+	{
+		__m256i value0 = _mm256_loadu_si256( ( const __m256i* )data );
+		__m256i value1 = _mm256_loadu_si256( ( const __m256i* )data + 1 );
+		__m256i keyed0 = _mm256_xor_si256( value0, _mm256_loadu_si256( ( const __m256i* )key ) );
+		__m256i keyed1 = _mm256_xor_si256( value1, _mm256_loadu_si256( ( const __m256i* )key + 1 ) );
+
+		a0 = _mm256_add_epi64( a0, _mm256_add_epi64( _mm256_mul_epu32( keyed0, _mm256_srli_epi64( keyed0, 32 ) ),
+			_mm256_shuffle_epi32( value0, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+		a1 = _mm256_add_epi64( a1, _mm256_add_epi64( _mm256_mul_epu32( keyed1, _mm256_srli_epi64( keyed1, 32 ) ),
+			_mm256_shuffle_epi32( value1, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+
+		data += HASH_STRIPE_SIZE;
+		key += SECRET_CONSUME_RATE;
+	}
+
+	_mm256_storeu_si256( ( __m256i* )acc, a0 );
+	_mm256_storeu_si256( ( __m256i* )acc + 1, a1 );
+}
+
+TARGET_AVX2 static void scramble_avx2( uint64_t* acc, const uint8_t* key )
+{
+	const __m256i prime = _mm256_set1_epi32( ( int32_t )PRIME32_1 );
+
+	for( int32_t i = 0; i < 2; i++ )
+	{
+		__m256i value = _mm256_loadu_si256( ( const __m256i* )acc + i );
+		__m256i keyed;
+
+		value = _mm256_xor_si256( value, _mm256_srli_epi64( value, 47 ) );
+		keyed = _mm256_xor_si256( value, _mm256_loadu_si256( ( const __m256i* )key + i ) );
+
+		value = _mm256_add_epi64( _mm256_mul_epu32( keyed, prime ), _mm256_slli_epi64( _mm256_mul_epu32( _mm256_srli_epi64( keyed, 32 ), prime ), 32 ) );
+		_mm256_storeu_si256( ( __m256i* )acc + i, value );
+	}
+}
+
+TARGET_AVX512 static void accumulate_avx512( uint64_t* acc, const uint8_t* data, const uint8_t* key, size_t stripes )
+{
+	__m512i a = _mm512_loadu_si512( ( const void* )acc );
+
+	for( size_t n = 0; n < stripes; n++ )
+	{
+		__m512i value = _mm512_loadu_si512( ( const void* )data );
+		__m512i keyed = _mm512_xor_si512( value, _mm512_loadu_si512( ( const void* )key ) );
+
+		a = _mm512_add_epi64( a, _mm512_add_epi64( _mm512_mul_epu32( keyed, _mm512_srli_epi64( keyed, 32 ) ),
+			_mm512_shuffle_epi32( value, ( _MM_PERM_ENUM )_MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+
+		data += HASH_STRIPE_SIZE;
+		key += SECRET_CONSUME_RATE;
+	}
+
+	_mm512_storeu_si512( ( void* )acc, a );
+}
+
+TARGET_AVX512 static void scramble_avx512( uint64_t* acc, const uint8_t* key )
+{
+	const __m512i prime = _mm512_set1_epi32( ( int32_t )PRIME32_1 );
+	__m512i value = _mm512_loadu_si512( ( const void* )acc );
+	__m512i keyed;
+
+	value = _mm512_xor_si512( value, _mm512_srli_epi64( value, 47 ) );
+	keyed = _mm512_xor_si512( value, _mm512_loadu_si512( ( const void* )key ) );
+
+	value = _mm512_add_epi64( _mm512_mul_epu32( keyed, prime ), _mm512_slli_epi64( _mm512_mul_epu32( _mm512_srli_epi64( keyed, 32 ), prime ), 32 ) );
+	_mm512_storeu_si512( ( void* )acc, value );
+}
+#endif
+
+static const hash_kernels_t kernels[ CONVERT_ISA_COUNT ] =
+{
+	{ accumulate_c, scramble_c },
+#if HASH_X86
+	{ accumulate_sse41, scramble_sse41 },
+	{ accumulate_avx2, scramble_avx2 },
+	{ accumulate_avx512, scramble_avx512 },
+#endif
+};
+
+const hash_kernels_t* hash_get_kernels( convert_isa_t isa )
+{
+	if( isa < CONVERT_ISA_C || isa > convert_detect_isa( ) )
+	{
+		return NULL;
+	}
+
+	return &kernels[ isa ];
+}
+
+/*
+ * accumulates whole stripes, scrambling at the end of every block of the secret.
+ */
+static void consume_stripes( const hash_kernels_t* hash_kernels, uint64_t* acc, size_t* block_stripes, const uint8_t* data, size_t stripes )
+{
+	while( stripes > 0 )
+	{
+		size_t n = STRIPES_PER_BLOCK - *block_stripes;
+
+		if( n > stripes )
+		{
+			n = stripes;
+		}
+
+		hash_kernels->accumulate( acc, data, secret + *block_stripes * SECRET_CONSUME_RATE, n );
+		data += n * HASH_STRIPE_SIZE;
+		stripes -= n;
+
+		*block_stripes += n;
+		if( *block_stripes == STRIPES_PER_BLOCK )
+		{
+			hash_kernels->scramble( acc, secret + SECRET_SIZE - HASH_STRIPE_SIZE );
+			*block_stripes = 0;
+		}
+	}
+}
+
+void hash_init( hash_state_t* state, const hash_kernels_t* hash_kernels )
+{
+	memcpy( state->acc, initial_acc, sizeof( state->acc ) );
+	state->buffered = 0;
+	state->stripes = 0;
+	state->total_size = 0;
+	state->kernels = hash_kernels;
+}
+
+void hash_update( hash_state_t* state, const uint8_t* data, size_t size )
+{
+	state->total_size += size;
+
+	if( state->buffered + size <= HASH_BUFFER_SIZE )
+	{
+		memcpy( state->buffer + state->buffered, data, size );
+		state->buffered += size;
+		return;
+	}
+
+	// the last byte of the stream is always kept back, the digest hashes the last stripe again
+	if( state->buffered > 0 )
+	{
+		size_t fill = HASH_BUFFER_SIZE - state->buffered;
+
+		memcpy( state->buffer + state->buffered, data, fill );
+		data += fill;
+		size -= fill;
+
+		consume_stripes( state->kernels, state->acc, &state->stripes, state->buffer, HASH_BUFFER_SIZE / HASH_STRIPE_SIZE );
+		state->buffered = 0;
+	}
+
+	if( size > HASH_BUFFER_SIZE )
+	{
+		size_t stripes = ( size - 1 ) / HASH_STRIPE_SIZE;
+
+		consume_stripes( state->kernels, state->acc, &state->stripes, data, stripes );
+		data += stripes * HASH_STRIPE_SIZE;
+		size -= stripes * HASH_STRIPE_SIZE;
+
+		// the end of the buffer holds the last stripe consumed
+		memcpy( state->buffer + HASH_BUFFER_SIZE - HASH_STRIPE_SIZE, data - HASH_STRIPE_SIZE, HASH_STRIPE_SIZE );
+	}
+
+	memcpy( state->buffer, data, size );
+	state->buffered = size;
+}
+
+static uint64_t hash_short( const uint8_t* data, size_t size )
+{
+	uint64_t acc = ( uint64_t )size * PRIME64_1;
+
+	if( size == 0 )
+	{
+		return xxh64_avalanche( read64( secret + 56 ) ^ read64( secret + 64 ) );
+	}
+
+	if( size <= 3 )
+	{
+		uint32_t combo = ( ( uint32_t )data[ 0 ] << 16 ) | ( ( uint32_t )data[ size >> 1 ] << 24 ) | data[ size - 1 ] | ( ( uint32_t )size << 8 );
+
+		return xxh64_avalanche( combo ^ ( uint64_t )( read32( secret ) ^ read32( secret + 4 ) ) );
+	}
+
+	if( size <= 8 )
+	{
+		uint64_t value = read32( data + size - 4 ) + ( ( uint64_t )read32( data ) << 32 );
+
+		return rrmxmx( value ^ ( read64( secret + 8 ) ^ read64( secret + 16 ) ), size );
+	}
+
+	if( size <= 16 )
+	{
+		uint64_t lo = read64( data ) ^ ( read64( secret + 24 ) ^ read64( secret + 32 ) );
+		uint64_t hi = read64( data + size - 8 ) ^ ( read64( secret + 40 ) ^ read64( secret + 48 ) );
+
+		return avalanche( size + swap64( lo ) + hi + mul128_fold64( lo, hi ) );
+	}
+
+	if( size <= 128 )
+	{
+		if( size > 32 )
+		{
+			if( size > 64 )
+			{
+				if( size > 96 )
+				{
+					acc += mix16( data + 48, secret + 96 );
+					acc += mix16( data + size - 64, secret + 112 );
+				}
+				acc += mix16( data + 32, secret + 64 );
+				acc += mix16( data + size - 48, secret + 80 );
+			}
+			acc += mix16( data + 16, secret + 32 );
+			acc += mix16( data + size - 32, secret + 48 );
+		}
+		acc += mix16( data, secret );
+		acc += mix16( data + size - 16, secret + 16 );
+
+		return avalanche( acc );
+	}
+
+	for( size_t i = 0; i < 8; i++ )
+	{
+		acc += mix16( data + 16 * i, secret + 16 * i );
+	}
+	acc = avalanche( acc );
+
+	for( size_t i = 8; i < size / 16; i++ )
+	{
+		acc += mix16( data + 16 * i, secret + 16 * ( i - 8 ) + 3 );
+	}
+	acc += mix16( data + size - 16, secret + 136 - 17 );
+
+	return avalanche( acc );
+}
+
+uint64_t hash_digest( const hash_state_t* state )
+{
+	const uint8_t* last_secret = secret + SECRET_SIZE - HASH_STRIPE_SIZE - SECRET_LASTACC_START;
+	uint64_t acc[ 8 ];
+	size_t stripes = state->stripes;
+	uint64_t result = state->total_size * PRIME64_1;
+
+	if( state->total_size <= MID_SIZE_MAX )
+	{
+		return hash_short( state->buffer, state->buffered );
+	}
+
+	memcpy( acc, state->acc, sizeof( acc ) );
+
+	if( state->buffered >= HASH_STRIPE_SIZE )
+	{
+		consume_stripes( state->kernels, acc, &stripes, state->buffer, ( state->buffered - 1 ) / HASH_STRIPE_SIZE );
+		state->kernels->accumulate( acc, state->buffer + state->buffered - HASH_STRIPE_SIZE, last_secret, 1 );
+	}
+	else
+	{
+		uint8_t last_stripe[ HASH_STRIPE_SIZE ];
+		size_t catchup = HASH_STRIPE_SIZE - state->buffered;
+
+		memcpy( last_stripe, state->buffer + HASH_BUFFER_SIZE - catchup, catchup );
+		memcpy( last_stripe + catchup, state->buffer, state->buffered );
+		state->kernels->accumulate( acc, last_stripe, last_secret, 1 );
+	}
+
+	for( int32_t i = 0; i < 4; i++ )
+	{
+		const uint8_t* key = secret + SECRET_MERGEACCS_START + 16 * i;
+
+		result += mul128_fold64( acc[ 2 * i ] ^ read64( key ), acc[ 2 * i + 1 ] ^ read64( key + 8 ) );
+	}
+
+	return avalanche( result );
+}
+
+uint64_t hash_plane( const hash_kernels_t* hash_kernels, const uint8_t* data, ptrdiff_t stride, size_t row_size, int32_t rows )
+{
+	hash_state_t state;
+
+	hash_init( &state, hash_kernels );
+
+	// a plane without padding is one run
+	if( stride >= 0 && ( size_t )stride == row_size )
+	{
+		hash_update( &state, data, row_size * rows );
+		return hash_digest( &state );
+	}
+
+	for( int32_t y = 0; y < rows; y++ )
+	{
+		hash_update( &state, data + ( ptrdiff_t )y * stride, row_size );
+	}
+
+	return hash_digest( &state );
+}
@@ -0,0 +1,95 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief picture hashing of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_hash.h
+*
+* 64 bit XXH3 hash (xxHash 0.8, default secret, seed 0) of a byte stream. The stripe kernels exist as scalar C code and,
+* on x86, as SSE4.1, AVX2 and AVX-512 code selected at runtime; all of them produce the same hash. A plane is hashed as
+* the stream of its visible rows without the padding at the end of each row, so the hash of a plane equals the XXH3
+* hash of the tightly packed plane (e.g. xxhsum -H3 of a raw dump) and does not depend on the stride.
+* The kernels do not depend on FFmpeg.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_HASH_H_
+#define __FFMPEG_VID_DEC_HASH_H_
+
+#include "ffmpeg_vid_dec_convert.h"
+#include <stddef.h>
+
+#define HASH_STRIPE_SIZE 64
+#define HASH_BUFFER_SIZE 256
+
+/*!
+	hash_kernels_t
+	@brief stripe kernels of one instruction set. accumulate adds stripes of 64 bytes to the accumulators, using the
+	secret from the given position on, scramble mixes the accumulators at the end of a block.\n
+*/
+typedef struct
+{
+	void( *accumulate ) ( uint64_t* acc, const uint8_t* data, const uint8_t* secret, size_t stripes );
+	void( *scramble ) ( uint64_t* acc, const uint8_t* secret );
+} hash_kernels_t;
+
+/*!
+	hash_state_t
+	@brief state of a streaming hash.\n
+*/
+typedef struct
+{
+	uint64_t acc[ 8 ];
+	uint8_t buffer[ HASH_BUFFER_SIZE ];
+	size_t buffered;
+	size_t stripes;                     /**< @details stripes accumulated in the current block */
+	uint64_t total_size;
+	const hash_kernels_t *kernels;
+} hash_state_t;
+
+/*!
+	hash_get_kernels
+	@brief returns the kernels of the given instruction set, NULL if it is not supported.\n
+*/
+const hash_kernels_t* hash_get_kernels( convert_isa_t isa );
+
+void hash_init( hash_state_t* state, const hash_kernels_t* kernels );
+void hash_update( hash_state_t* state, const uint8_t* data, size_t size );
+uint64_t hash_digest( const hash_state_t* state );
+
+/*!
+	hash_plane
+	@brief returns the hash of rows rows of row_size bytes each, stride bytes apart.\n
+*/
+uint64_t hash_plane( const hash_kernels_t* kernels, const uint8_t* data, ptrdiff_t stride, size_t row_size, int32_t rows );
+
+#endif // __FFMPEG_VID_DEC_HASH_H_
@@ -0,0 +1,223 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_input_arena.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+#if INPUT_ARENA_SUPPORTED
+
+#define MIN_CLASS_SHIFT 16              // 64 KiB
+#define MAX_CLASS_SHIFT 26              // 64 MiB
+#define NUM_CLASSES ( MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1 )
+
+#if ( LIBAVUTIL_VERSION_MAJOR < 57 )
+typedef int pool_size_t;
+#else
+typedef size_t pool_size_t;
+#endif
+
+struct input_arena_s_
+{
+	vid_dec_mutex_t mutex;
+	volatile int32_t refs;
+
+	AVBufferPool *pools[ NUM_CLASSES ];
+
+	volatile int64_t requests;
+	volatile int64_t allocations;
+	volatile int64_t bytes;
+	volatile int64_t peak_bytes;
+};
+
+typedef struct
+{
+	input_arena_t *arena;
+	size_t size;
+} arena_buffer_t;
+
+static void input_arena_unref( input_arena_t* arena )
+{
+	if( vid_dec_atomic_add32( &arena->refs, -1 ) == 0 )
+	{
+		vid_dec_mutex_destroy( &arena->mutex );
+		free( arena );
+	}
+}
+
+static void arena_buffer_free( void* opaque, uint8_t* data )
+{
+	arena_buffer_t* buffer = ( arena_buffer_t* )opaque;
+
+	vid_dec_atomic_add64( &buffer->arena->bytes, -( int64_t )buffer->size );
+
+	av_free( data );
+	free( buffer );
+}
+
+static AVBufferRef* arena_buffer_create( input_arena_t* arena, size_t size )
+{
+	arena_buffer_t* buffer;
+	AVBufferRef* buffer_ref;
+	uint8_t* data;
+
+	buffer = ( arena_buffer_t* )malloc( sizeof( arena_buffer_t ) );
+	if( buffer == NULL )
+	{
+		return NULL;
+	}
+
+	data = ( uint8_t* )av_malloc( size );
+	if( data == NULL )
+	{
+		free( buffer );
+		return NULL;
+	}
+
+	buffer->arena = arena;
+	buffer->size = size;
+
+	buffer_ref = av_buffer_create( data, size, arena_buffer_free, buffer, 0 );
+	if( buffer_ref == NULL )
+	{
+		av_free( data );
+		free( buffer );
+		return NULL;
+	}
+
+	vid_dec_atomic_add64( &arena->allocations, 1 );
+	vid_dec_atomic_max64( &arena->peak_bytes, vid_dec_atomic_add64( &arena->bytes, ( int64_t )size ) );
+
+	return buffer_ref;
+}
+
+static AVBufferRef* arena_pool_alloc( void* opaque, pool_size_t size )
+{
+	return arena_buffer_create( ( input_arena_t* )opaque, size );
+}
+
+static void arena_pool_free( void* opaque )
+{
+	input_arena_unref( ( input_arena_t* )opaque );
+}
+
+input_arena_t* input_arena_create( void )
+{
+	input_arena_t* arena = ( input_arena_t* )malloc( sizeof( input_arena_t ) );
+
+	if( arena == NULL )
+	{
+		return NULL;
+	}
+
+	memset( arena, 0, sizeof( input_arena_t ) );
+
+	vid_dec_mutex_init( &arena->mutex );
+	arena->refs = 1;
+
+	return arena;
+}
+
+void input_arena_release( input_arena_t** arena )
+{
+	if( arena == NULL || *arena == NULL )
+	{
+		return;
+	}
+
+	vid_dec_mutex_lock( &( *arena )->mutex );
+	for( int32_t i = 0; i < NUM_CLASSES; i++ )
+	{
+		av_buffer_pool_uninit( &( *arena )->pools[ i ] );
+	}
+	vid_dec_mutex_unlock( &( *arena )->mutex );
+
+	input_arena_unref( *arena );
+	*arena = NULL;
+}
+
+AVBufferRef* input_arena_get( input_arena_t* arena, size_t size )
+{
+	size_t padded_size = size + AV_INPUT_BUFFER_PADDING_SIZE;
+	int32_t size_class = 0;
+	AVBufferPool* pool;
+
+	vid_dec_atomic_add64( &arena->requests, 1 );
+
+	while( ( ( size_t )1 << ( MIN_CLASS_SHIFT + size_class ) ) < padded_size )
+	{
+		if( ++size_class == NUM_CLASSES )
+		{
+			// larger than the largest class, not worth keeping around
+			return arena_buffer_create( arena, padded_size );
+		}
+	}
+
+	vid_dec_mutex_lock( &arena->mutex );
+	pool = arena->pools[ size_class ];
+	if( pool == NULL )
+	{
+		pool = av_buffer_pool_init2( ( size_t )1 << ( MIN_CLASS_SHIFT + size_class ), arena, arena_pool_alloc, arena_pool_free );
+		if( pool != NULL )
+		{
+			vid_dec_atomic_add32( &arena->refs, 1 );
+			arena->pools[ size_class ] = pool;
+		}
+	}
+	vid_dec_mutex_unlock( &arena->mutex );
+
+	if( pool == NULL )
+	{
+		return NULL;
+	}
+
+	return av_buffer_pool_get( pool );
+}
+
+void input_arena_get_stats( input_arena_t* arena, input_arena_stats_t* stats )
+{
+	memset( stats, 0, sizeof( input_arena_stats_t ) );
+
+	if( arena == NULL )
+	{
+		return;
+	}
+
+	stats->requests = vid_dec_atomic_load64( &arena->requests );
+	stats->allocations = vid_dec_atomic_load64( &arena->allocations );
+	stats->bytes = vid_dec_atomic_load64( &arena->bytes );
+	stats->peak_bytes = vid_dec_atomic_load64( &arena->peak_bytes );
+}
+
+#endif // INPUT_ARENA_SUPPORTED
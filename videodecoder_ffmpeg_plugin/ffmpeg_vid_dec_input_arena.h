@@ -0,0 +1,78 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief pooled bitstream buffers of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_input_arena.h
+*
+* Access units are passed to libavcodec in reference counted buffers with AV_INPUT_BUFFER_PADDING_SIZE zeroed
+* bytes behind the payload, so libavcodec can take a reference instead of copying the payload. Buffers are
+* recycled per power of two size class.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_INPUT_ARENA_H_
+#define __FFMPEG_VID_DEC_INPUT_ARENA_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include <libavcodec/avcodec.h>
+
+#define INPUT_ARENA_SUPPORTED ( LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(56,0,100) && LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101) )
+
+typedef struct
+{
+	int64_t requests;                   /**< @details buffers handed out */
+	int64_t allocations;                /**< @details buffers allocated from the system */
+	int64_t bytes;                      /**< @details bytes currently allocated by the arena */
+	int64_t peak_bytes;                 /**< @details maximum of bytes */
+} input_arena_stats_t;
+
+typedef struct input_arena_s_ input_arena_t;
+
+input_arena_t* input_arena_create( void );
+
+/*!
+	input_arena_release
+	@brief releases the arena. Buffers still referenced are freed when their last reference is released.\n
+*/
+void input_arena_release( input_arena_t** arena );
+
+/*!
+	input_arena_get
+	@brief returns a buffer for a payload of the given size. The buffer is at least size + AV_INPUT_BUFFER_PADDING_SIZE bytes
+	large. Thread safe.\n
+*/
+AVBufferRef* input_arena_get( input_arena_t* arena, size_t size );
+
+void input_arena_get_stats( input_arena_t* arena, input_arena_stats_t* stats );
+
+#endif // __FFMPEG_VID_DEC_INPUT_ARENA_H_
@@ -0,0 +1,508 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_layer_group.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+#define MAX_KEY_LENGTH 64
+#define STALL_TIMEOUT_MS 250
+#define JOIN_TIMEOUT_MS 500
+
+typedef struct group_picture_s_
+{
+	struct group_picture_s_ *next;
+
+	dvpd_input_dec_picture_t picture;
+	picture_info_t *info;
+	bool owned;
+	int32_t layer;
+	on_decoded_picture_cb_func_t on_decoded_picture;
+	void *app_data;
+} group_picture_t;
+
+typedef struct
+{
+	group_picture_t *head;
+	group_picture_t *tail;
+	int32_t count;
+} picture_list_t;
+
+typedef struct
+{
+	bool joined;
+	bool drained;
+	bool owned;
+	on_decoded_picture_cb_func_t on_decoded_picture;
+	void *app_data;
+
+	picture_list_t pending;
+	int64_t pushed;
+	int64_t stall_mark;                 // pushed count of the other layer when it last stalled
+	layer_group_stats_t stats;
+} layer_slot_t;
+
+struct layer_group_s_
+{
+	layer_group_t *next;
+	char key[ MAX_KEY_LENGTH ];
+	int32_t members;                    // protected by registry_lock
+	int32_t window;
+	bool awaiting;                      // pictures wait for a layer that has not joined yet
+
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t idle;
+	vid_dec_cond_t progress;
+	bool delivering;
+	picture_list_t ready;
+	picture_list_t unused;
+	layer_slot_t layers[ LAYER_GROUP_LAYERS ];
+};
+
+static vid_dec_spinlock_t registry_lock = VID_DEC_SPINLOCK_INIT;
+static layer_group_t *registry = NULL;
+
+static void list_push( picture_list_t* list, group_picture_t* picture )
+{
+	picture->next = NULL;
+	if( list->tail != NULL )
+	{
+		list->tail->next = picture;
+	}
+	else
+	{
+		list->head = picture;
+	}
+	list->tail = picture;
+	list->count++;
+}
+
+static group_picture_t* list_pop( picture_list_t* list )
+{
+	group_picture_t* picture = list->head;
+
+	if( picture != NULL )
+	{
+		list->head = picture->next;
+		if( list->head == NULL )
+		{
+			list->tail = NULL;
+		}
+		list->count--;
+	}
+
+	return picture;
+}
+
+static void move_ready( layer_group_t* group, int32_t layer, bool paired )
+{
+	layer_slot_t* slot = &group->layers[ layer ];
+
+	list_push( &group->ready, list_pop( &slot->pending ) );
+
+	if( paired == true )
+	{
+		slot->stats.paired++;
+	}
+	else
+	{
+		slot->stats.unpaired++;
+	}
+}
+
+/*
+ * a layer that left or drained sends no partners anymore. A layer that has not joined yet is awaited until both
+ * layers have joined or the join timeout expired.
+ */
+static bool partner_gone( const layer_group_t* group, const layer_slot_t* other )
+{
+	if( other->joined == false )
+	{
+		return group->awaiting == false;
+	}
+
+	return other->drained;
+}
+
+/*
+ * moves deliverable pictures to the ready list. Pictures leave the decoders in PTS order, so a picture without a
+ * partner of equal PTS at the head of the other layer will not get one anymore.
+ */
+static void match_pictures( layer_group_t* group )
+{
+	while( 1 )
+	{
+		group_picture_t* base = group->layers[ 0 ].pending.head;
+		group_picture_t* enhancement = group->layers[ 1 ].pending.head;
+
+		if( base != NULL && enhancement != NULL )
+		{
+			if( base->picture.pts == enhancement->picture.pts )
+			{
+				move_ready( group, 0, true );
+				move_ready( group, 1, true );
+			}
+			else
+			{
+				move_ready( group, ( base->picture.pts < enhancement->picture.pts ) ? 0 : 1, false );
+			}
+		}
+		else if( base != NULL || enhancement != NULL )
+		{
+			int32_t layer = ( base != NULL ) ? 0 : 1;
+			layer_slot_t* other = &group->layers[ 1 - layer ];
+
+			if( partner_gone( group, other ) == true )
+			{
+				move_ready( group, layer, false );
+			}
+			else
+			{
+				break;
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/*
+ * delivers the ready pictures. Only one thread delivers at a time, pictures that become ready meanwhile are picked
+ * up by the delivering thread. With wait, returns after all ready pictures have been delivered.
+ */
+static void deliver_pictures( layer_group_t* group, bool wait )
+{
+	vid_dec_mutex_lock( &group->mutex );
+
+	while( 1 )
+	{
+		picture_list_t delivered;
+
+		if( group->delivering == true )
+		{
+			if( wait == false )
+			{
+				break;
+			}
+
+			vid_dec_cond_wait( &group->idle, &group->mutex );
+			continue;
+		}
+
+		if( group->ready.head == NULL )
+		{
+			break;
+		}
+
+		delivered = group->ready;
+		memset( &group->ready, 0, sizeof( picture_list_t ) );
+		group->delivering = true;
+		vid_dec_mutex_unlock( &group->mutex );
+
+		for( group_picture_t* picture = delivered.head; picture != NULL; picture = picture->next )
+		{
+			picture->on_decoded_picture( &picture->picture, picture->app_data, picture->layer );
+
+			if( picture->owned == false )
+			{
+				picture_info_release( picture->info );
+			}
+			picture->info = NULL;
+		}
+
+		vid_dec_mutex_lock( &group->mutex );
+
+		while( delivered.head != NULL )
+		{
+			list_push( &group->unused, list_pop( &delivered ) );
+		}
+
+		group->delivering = false;
+		vid_dec_cond_broadcast( &group->idle );
+	}
+
+	vid_dec_mutex_unlock( &group->mutex );
+}
+
+static void drop_pending( layer_group_t* group, layer_slot_t* slot )
+{
+	group_picture_t* picture;
+
+	while( ( picture = list_pop( &slot->pending ) ) != NULL )
+	{
+		picture_info_release( picture->info );
+		picture->info = NULL;
+		list_push( &group->unused, picture );
+	}
+}
+
+static void destroy_group( layer_group_t* group )
+{
+	group_picture_t* picture;
+
+	while( ( picture = list_pop( &group->unused ) ) != NULL )
+	{
+		free( picture );
+	}
+
+	vid_dec_cond_destroy( &group->idle );
+	vid_dec_cond_destroy( &group->progress );
+	vid_dec_mutex_destroy( &group->mutex );
+	free( group );
+}
+
+layer_group_t* layer_group_join( const char* key, int32_t layer, on_decoded_picture_cb_func_t on_decoded_picture, void* app_data,
+	bool owned, int32_t window )
+{
+	layer_group_t* group;
+	layer_slot_t* slot;
+
+	if( layer < 0 || layer >= LAYER_GROUP_LAYERS || strlen( key ) >= MAX_KEY_LENGTH )
+	{
+		return NULL;
+	}
+
+	vid_dec_spin_lock( &registry_lock );
+
+	for( group = registry; group != NULL; group = group->next )
+	{
+		if( strcmp( group->key, key ) == 0 )
+		{
+			break;
+		}
+	}
+
+	if( group == NULL )
+	{
+		group = ( layer_group_t* )malloc( sizeof( layer_group_t ) );
+		if( group == NULL )
+		{
+			vid_dec_spin_unlock( &registry_lock );
+			return NULL;
+		}
+
+		memset( group, 0, sizeof( layer_group_t ) );
+		strcpy( group->key, key );
+		group->window = window;
+		group->awaiting = true;
+		vid_dec_mutex_init( &group->mutex );
+		vid_dec_cond_init( &group->idle );
+		vid_dec_cond_init( &group->progress );
+
+		group->next = registry;
+		registry = group;
+	}
+
+	vid_dec_mutex_lock( &group->mutex );
+
+	slot = &group->layers[ layer ];
+	if( slot->joined == true )
+	{
+		vid_dec_mutex_unlock( &group->mutex );
+		vid_dec_spin_unlock( &registry_lock );
+		return NULL;
+	}
+
+	memset( slot, 0, sizeof( layer_slot_t ) );
+	slot->joined = true;
+	slot->owned = owned;
+	slot->on_decoded_picture = on_decoded_picture;
+	slot->app_data = app_data;
+	slot->stall_mark = -1;
+
+	if( group->layers[ 1 - layer ].joined == true )
+	{
+		group->awaiting = false;
+	}
+	vid_dec_cond_broadcast( &group->progress );
+
+	vid_dec_mutex_unlock( &group->mutex );
+
+	group->members++;
+
+	vid_dec_spin_unlock( &registry_lock );
+
+	return group;
+}
+
+void layer_group_leave( layer_group_t** group, int32_t layer, layer_group_stats_t* stats )
+{
+	layer_group_t* leaving;
+	layer_slot_t* slot;
+	bool last = false;
+
+	if( group == NULL || *group == NULL )
+	{
+		return;
+	}
+
+	leaving = *group;
+	slot = &leaving->layers[ layer ];
+
+	vid_dec_mutex_lock( &leaving->mutex );
+	drop_pending( leaving, slot );
+	slot->joined = false;
+	match_pictures( leaving );
+	vid_dec_cond_broadcast( &leaving->progress );
+	vid_dec_mutex_unlock( &leaving->mutex );
+
+	deliver_pictures( leaving, true );
+
+	if( stats != NULL )
+	{
+		*stats = slot->stats;
+	}
+
+	vid_dec_spin_lock( &registry_lock );
+
+	if( --leaving->members == 0 )
+	{
+		layer_group_t** link = &registry;
+
+		while( *link != leaving )
+		{
+			link = &( *link )->next;
+		}
+		*link = leaving->next;
+		last = true;
+	}
+
+	vid_dec_spin_unlock( &registry_lock );
+
+	if( last == true )
+	{
+		destroy_group( leaving );
+	}
+
+	*group = NULL;
+}
+
+void layer_group_push( layer_group_t* group, int32_t layer, const dvpd_input_dec_picture_t* picture, picture_info_t* info )
+{
+	layer_slot_t* slot = &group->layers[ layer ];
+	layer_slot_t* other = &group->layers[ 1 - layer ];
+	group_picture_t* pending;
+
+	vid_dec_mutex_lock( &group->mutex );
+
+	pending = list_pop( &group->unused );
+	if( pending == NULL )
+	{
+		pending = ( group_picture_t* )malloc( sizeof( group_picture_t ) );
+		if( pending == NULL )
+		{
+			vid_dec_mutex_unlock( &group->mutex );
+			picture_info_release( info );
+			return;
+		}
+	}
+
+	pending->picture = *picture;
+	pending->info = info;
+	pending->owned = slot->owned;
+	pending->layer = layer;
+	pending->on_decoded_picture = slot->on_decoded_picture;
+	pending->app_data = slot->app_data;
+
+	list_push( &slot->pending, pending );
+	slot->pushed++;
+	match_pictures( group );
+	vid_dec_cond_broadcast( &group->progress );
+
+	// a layer running ahead by more than the window waits for the other layer, unless that stalled since its last push
+	// or did not join in time
+	while( slot->pending.count > group->window )
+	{
+		if( partner_gone( group, other ) == true || other->pushed == slot->stall_mark )
+		{
+			move_ready( group, layer, false );
+		}
+		else if( other->joined == false )
+		{
+			if( vid_dec_cond_timedwait( &group->progress, &group->mutex, JOIN_TIMEOUT_MS ) == false )
+			{
+				group->awaiting = false;
+			}
+		}
+		else if( vid_dec_cond_timedwait( &group->progress, &group->mutex, STALL_TIMEOUT_MS ) == false )
+		{
+			slot->stall_mark = other->pushed;
+		}
+	}
+	match_pictures( group );
+
+	vid_dec_mutex_unlock( &group->mutex );
+
+	deliver_pictures( group, false );
+}
+
+void layer_group_drained( layer_group_t* group, int32_t layer )
+{
+	layer_slot_t* slot = &group->layers[ layer ];
+
+	vid_dec_mutex_lock( &group->mutex );
+	slot->drained = true;
+
+	// the pending pictures wait a bounded time for the other layer to join and pair them
+	while( group->awaiting == true && group->layers[ 1 - layer ].joined == false && slot->pending.head != NULL )
+	{
+		if( vid_dec_cond_timedwait( &group->progress, &group->mutex, JOIN_TIMEOUT_MS ) == false )
+		{
+			group->awaiting = false;
+		}
+	}
+
+	match_pictures( group );
+	vid_dec_cond_broadcast( &group->progress );
+	vid_dec_mutex_unlock( &group->mutex );
+
+	deliver_pictures( group, true );
+}
+
+void layer_group_resume( layer_group_t* group, int32_t layer )
+{
+	vid_dec_mutex_lock( &group->mutex );
+	group->layers[ layer ].drained = false;
+	vid_dec_mutex_unlock( &group->mutex );
+}
+
+void layer_group_discard( layer_group_t* group, int32_t layer )
+{
+	vid_dec_mutex_lock( &group->mutex );
+	drop_pending( group, &group->layers[ layer ] );
+	vid_dec_cond_broadcast( &group->progress );
+	vid_dec_mutex_unlock( &group->mutex );
+}
@@ -0,0 +1,104 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief pairing of base and enhancement layer pictures of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_layer_group.h
+*
+* The two decoder instances of a dual-layer stream decode on their own worker threads and hand their pictures to a
+* process wide layer group. The group delivers pictures with equal PTS as pairs, base layer first, and serializes
+* the picture callbacks of both instances. Pictures without a partner are delivered alone once the partner can no
+* longer arrive: the other layer output a later picture, was drained or left the group. Until both layers have joined,
+* the pictures of the first one wait for the other, at most for a join timeout once the window is full or the layer
+* is drained. A layer that runs ahead of the other by more than the reorder window waits for it. If the other layer
+* stalls, the pictures beyond the window are delivered alone.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_LAYER_GROUP_H_
+#define __FFMPEG_VID_DEC_LAYER_GROUP_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_picture_info.h"
+
+#define LAYER_GROUP_LAYERS 2
+
+typedef struct
+{
+	int64_t paired;                     /**< @details pictures delivered with a partner */
+	int64_t unpaired;                   /**< @details pictures delivered alone */
+} layer_group_stats_t;
+
+typedef struct layer_group_s_ layer_group_t;
+
+/*!
+	layer_group_join
+	@brief joins the group with the given key as layer 0 or 1, creating the group if needed. Returns NULL if the layer
+	is already taken. owned selects whether delivered pictures keep their info (released with release_picture) or
+	the info is released after the callback.\n
+*/
+layer_group_t* layer_group_join( const char* key, int32_t layer, on_decoded_picture_cb_func_t on_decoded_picture, void* app_data,
+	bool owned, int32_t window );
+
+/*!
+	layer_group_leave
+	@brief drops the pending pictures of the layer, delivers the pictures of the other layer that now lack a partner
+	and leaves the group.\n
+*/
+void layer_group_leave( layer_group_t** group, int32_t layer, layer_group_stats_t* stats );
+
+/*!
+	layer_group_push
+	@brief passes a decoded picture and the info holding its data to the group.\n
+*/
+void layer_group_push( layer_group_t* group, int32_t layer, const dvpd_input_dec_picture_t* picture, picture_info_t* info );
+
+/*!
+	layer_group_drained
+	@brief signals that all pictures of the layer have been pushed. Returns after all pictures that became deliverable
+	have been delivered.\n
+*/
+void layer_group_drained( layer_group_t* group, int32_t layer );
+
+/*!
+	layer_group_resume
+	@brief signals new input of a drained layer.\n
+*/
+void layer_group_resume( layer_group_t* group, int32_t layer );
+
+/*!
+	layer_group_discard
+	@brief drops the pending pictures of the layer.\n
+*/
+void layer_group_discard( layer_group_t* group, int32_t layer );
+
+#endif // __FFMPEG_VID_DEC_LAYER_GROUP_H_
@@ -0,0 +1,260 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_memory_budget.h"
+#include "ffmpeg_vid_dec_thread.h"
+#include <libavutil/time.h>
+
+typedef struct
+{
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t released;
+	int64_t limit;
+	int64_t bytes;
+	int64_t peak_bytes;
+	int32_t clients;
+	int32_t previews;
+	int64_t waits;
+} memory_budget_t;
+
+struct memory_budget_client_s_
+{
+	int64_t bytes;
+	bool preview;
+};
+
+static vid_dec_spinlock_t budget_lock = VID_DEC_SPINLOCK_INIT;
+static memory_budget_t *budget = NULL;
+static int32_t budget_users = 0;
+
+memory_budget_client_t* memory_budget_join( int64_t limit )
+{
+	memory_budget_client_t* client = ( memory_budget_client_t* )calloc( 1, sizeof( memory_budget_client_t ) );
+
+	if( client == NULL )
+	{
+		return NULL;
+	}
+
+	vid_dec_spin_lock( &budget_lock );
+
+	if( budget == NULL )
+	{
+		budget = ( memory_budget_t* )calloc( 1, sizeof( memory_budget_t ) );
+		if( budget == NULL )
+		{
+			vid_dec_spin_unlock( &budget_lock );
+			free( client );
+			return NULL;
+		}
+
+		vid_dec_mutex_init( &budget->mutex );
+		vid_dec_cond_init( &budget->released );
+	}
+	budget_users++;
+
+	vid_dec_spin_unlock( &budget_lock );
+
+	vid_dec_mutex_lock( &budget->mutex );
+	budget->limit = limit;
+	budget->clients++;
+	vid_dec_mutex_unlock( &budget->mutex );
+
+	return client;
+}
+
+void memory_budget_leave( memory_budget_client_t** client )
+{
+	memory_budget_t* unused = NULL;
+
+	if( *client == NULL )
+	{
+		return;
+	}
+
+	vid_dec_mutex_lock( &budget->mutex );
+	budget->bytes -= ( *client )->bytes;
+	budget->clients--;
+	if( ( *client )->preview == true )
+	{
+		budget->previews--;
+	}
+	vid_dec_cond_broadcast( &budget->released );
+	vid_dec_mutex_unlock( &budget->mutex );
+
+	free( *client );
+	*client = NULL;
+
+	vid_dec_spin_lock( &budget_lock );
+	if( --budget_users == 0 )
+	{
+		unused = budget;
+		budget = NULL;
+	}
+	vid_dec_spin_unlock( &budget_lock );
+
+	if( unused != NULL )
+	{
+		vid_dec_cond_destroy( &unused->released );
+		vid_dec_mutex_destroy( &unused->mutex );
+		free( unused );
+	}
+}
+
+void memory_budget_update( memory_budget_client_t* client, int64_t bytes, bool preview )
+{
+	vid_dec_mutex_lock( &budget->mutex );
+
+	budget->bytes += bytes - client->bytes;
+	if( budget->bytes > budget->peak_bytes )
+	{
+		budget->peak_bytes = budget->bytes;
+	}
+
+	if( bytes < client->bytes )
+	{
+		vid_dec_cond_broadcast( &budget->released );
+	}
+
+	if( preview != client->preview )
+	{
+		budget->previews += ( preview == true ) ? 1 : -1;
+	}
+
+	client->bytes = bytes;
+	client->preview = preview;
+
+	vid_dec_mutex_unlock( &budget->mutex );
+}
+
+/*
+ * called with the mutex held. Preview instances always give way, so the other instances divide the budget among
+ * themselves.
+ */
+static int64_t client_share( memory_budget_client_t* client )
+{
+	if( client->preview == true || budget->previews == budget->clients )
+	{
+		return budget->limit / budget->clients;
+	}
+
+	return budget->limit / ( budget->clients - budget->previews );
+}
+
+/*
+ * called with the mutex held.
+ */
+static bool must_give_way( memory_budget_client_t* client )
+{
+	if( budget->limit == 0 || budget->bytes <= budget->limit )
+	{
+		return false;
+	}
+
+	return client->preview == true || client->bytes > client_share( client );
+}
+
+bool memory_budget_exceeded( memory_budget_client_t* client )
+{
+	bool exceeded;
+
+	vid_dec_mutex_lock( &budget->mutex );
+	exceeded = must_give_way( client );
+	vid_dec_mutex_unlock( &budget->mutex );
+
+	return exceeded;
+}
+
+int64_t memory_budget_share( memory_budget_client_t* client )
+{
+	int64_t share;
+
+	vid_dec_mutex_lock( &budget->mutex );
+	share = client_share( client );
+	vid_dec_mutex_unlock( &budget->mutex );
+
+	return share;
+}
+
+bool memory_budget_wait( memory_budget_client_t* client, int32_t timeout_ms )
+{
+	int64_t deadline = av_gettime_relative( ) + ( int64_t )timeout_ms * 1000;
+	bool released = true;
+
+	vid_dec_mutex_lock( &budget->mutex );
+
+	if( must_give_way( client ) == true )
+	{
+		budget->waits++;
+	}
+
+	while( must_give_way( client ) == true )
+	{
+		int64_t remaining = deadline - av_gettime_relative( );
+
+		if( remaining <= 0 )
+		{
+			released = false;
+			break;
+		}
+
+		vid_dec_cond_timedwait( &budget->released, &budget->mutex, ( int32_t )( ( remaining + 999 ) / 1000 ) );
+	}
+
+	vid_dec_mutex_unlock( &budget->mutex );
+
+	return released;
+}
+
+void memory_budget_get_stats( memory_budget_stats_t* stats )
+{
+	memset( stats, 0, sizeof( memory_budget_stats_t ) );
+
+	vid_dec_spin_lock( &budget_lock );
+
+	if( budget != NULL )
+	{
+		vid_dec_mutex_lock( &budget->mutex );
+		stats->limit = budget->limit;
+		stats->bytes = budget->bytes;
+		stats->peak_bytes = budget->peak_bytes;
+		stats->clients = budget->clients;
+		stats->waits = budget->waits;
+		vid_dec_mutex_unlock( &budget->mutex );
+	}
+
+	vid_dec_spin_unlock( &budget_lock );
+}
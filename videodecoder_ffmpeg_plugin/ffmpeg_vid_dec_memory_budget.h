@@ -0,0 +1,103 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief process-wide memory budget of the decoder instances of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_memory_budget.h
+*
+* Every joined instance reports the memory it accounts, the budget sums it up for the process. While the sum exceeds
+* the budget, instances give way: preview instances always, other instances while they hold more than their share
+* (the budget divided by the number of other instances). An instance giving way reduces its memory and holds back its next
+* access unit until the sum falls below the budget or a timeout expires, which spreads the bursts of many streams.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_MEMORY_BUDGET_H_
+#define __FFMPEG_VID_DEC_MEMORY_BUDGET_H_
+
+#include "dvpd_vid_dec_plugin.h"
+
+typedef struct
+{
+	int64_t limit;                      /**< @details budget in bytes */
+	int64_t bytes;                      /**< @details bytes accounted by all instances */
+	int64_t peak_bytes;                 /**< @details maximum of bytes */
+	int32_t clients;                    /**< @details instances sharing the budget */
+	int64_t waits;                      /**< @details access units held back */
+} memory_budget_stats_t;
+
+typedef struct memory_budget_client_s_ memory_budget_client_t;
+
+/*!
+	memory_budget_join
+	@brief joins the budget of the process, which is set to limit bytes. The budget exists while instances share it.\n
+*/
+memory_budget_client_t* memory_budget_join( int64_t limit );
+
+/*!
+	memory_budget_leave
+	@brief removes the bytes of the client from the budget and frees the client.\n
+*/
+void memory_budget_leave( memory_budget_client_t** client );
+
+/*!
+	memory_budget_update
+	@brief sets the bytes the client accounts and whether it is a preview instance, which gives way first.\n
+*/
+void memory_budget_update( memory_budget_client_t* client, int64_t bytes, bool preview );
+
+/*!
+	memory_budget_exceeded
+	@brief returns true if the process exceeds the budget and the client has to give way.\n
+*/
+bool memory_budget_exceeded( memory_budget_client_t* client );
+
+/*!
+	memory_budget_share
+	@brief returns the bytes the client may hold while the budget is exceeded: the budget divided by the instances
+	that are not previews, for a preview the budget divided by all instances.\n
+*/
+int64_t memory_budget_share( memory_budget_client_t* client );
+
+/*!
+	memory_budget_wait
+	@brief blocks while the client has to give way, at most timeout_ms milliseconds. Returns false on timeout.\n
+*/
+bool memory_budget_wait( memory_budget_client_t* client, int32_t timeout_ms );
+
+/*!
+	memory_budget_get_stats
+	@brief returns the state of the budget of the process, all zero without instances.\n
+*/
+void memory_budget_get_stats( memory_budget_stats_t* stats );
+
+#endif // __FFMPEG_VID_DEC_MEMORY_BUDGET_H_
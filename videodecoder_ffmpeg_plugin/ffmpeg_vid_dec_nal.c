@@ -0,0 +1,450 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "ffmpeg_vid_dec_nal.h"
+
+// SSE2 is part of every x86-64 CPU
+#if defined(__SSE2__) || defined(_M_X64)
+#define NAL_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define NAL_SSE2 0
+#endif
+
+#if NAL_SSE2
+static int32_t lowest_bit( uint32_t mask )
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+
+	_BitScanForward( &index, mask );
+	return ( int32_t )index;
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+#endif
+
+const uint8_t* nal_find_start_code( const uint8_t* p, const uint8_t* end )
+{
+#if NAL_SSE2
+	const __m128i zero = _mm_setzero_si128( );
+
+	// skips 16 bytes at a time until two consecutive zero bytes, which emulation prevention keeps rare within NAL units
+	while( end - p > 18 )
+	{
+		uint32_t zeros = ( uint32_t )_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i* )p ), zero ) );
+		uint32_t pairs = zeros & ( ( zeros >> 1 ) | ( p[ 16 ] == 0 ? 0x8000u : 0 ) );
+
+		if( pairs == 0 )
+		{
+			p += 16;
+			continue;
+		}
+
+		p += lowest_bit( pairs );
+		if( p[ 2 ] == 1 )
+		{
+			return p;
+		}
+		p++;
+	}
+#endif
+
+	while( p + 2 < end )
+	{
+		if( p[ 2 ] > 1 )
+		{
+			p += 3;
+		}
+		else if( p[ 1 ] != 0 )
+		{
+			p += 2;
+		}
+		else if( p[ 0 ] != 0 || p[ 2 ] != 1 )
+		{
+			p += 1;
+		}
+		else
+		{
+			return p;
+		}
+	}
+
+	return end;
+}
+
+void nal_iterator_init( nal_iterator_t* it, nal_codec_t codec, const uint8_t* data, size_t size )
+{
+	it->end = data + size;
+	it->pos = nal_find_start_code( data, it->end );
+	it->codec = codec;
+}
+
+bool nal_iterator_next( nal_iterator_t* it, nal_unit_t* nal )
+{
+	size_t header_size = ( it->codec == NAL_CODEC_HEVC ) ? 2 : 1;
+	const uint8_t* start;
+	const uint8_t* next;
+	const uint8_t* last;
+
+	while( it->pos < it->end )
+	{
+		start = it->pos + 3;
+		next = nal_find_start_code( start, it->end );
+
+		last = next;
+		while( last > start && last[ -1 ] == 0 )
+		{
+			last--;
+		}
+
+		it->pos = next;
+
+		if( ( size_t )( last - start ) < header_size )
+		{
+			continue;
+		}
+
+		nal->data = start;
+		nal->size = last - start;
+		nal->type = ( it->codec == NAL_CODEC_HEVC ) ? ( ( start[ 0 ] >> 1 ) & 0x3f ) : ( start[ 0 ] & 0x1f );
+
+		return true;
+	}
+
+	return false;
+}
+
+bool nal_is_vcl( nal_codec_t codec, int32_t type )
+{
+	if( codec == NAL_CODEC_HEVC )
+	{
+		return type < 32;
+	}
+
+	return type >= AVC_NAL_SLICE && type <= AVC_NAL_IDR_SLICE;
+}
+
+bool nal_is_parameter_set( nal_codec_t codec, int32_t type )
+{
+	if( codec == NAL_CODEC_HEVC )
+	{
+		return type >= HEVC_NAL_VPS && type <= HEVC_NAL_PPS;
+	}
+
+	return type == AVC_NAL_SPS || type == AVC_NAL_PPS;
+}
+
+bool nal_is_idr( nal_codec_t codec, int32_t type )
+{
+	if( codec == NAL_CODEC_HEVC )
+	{
+		return type >= HEVC_NAL_BLA_W_LP && type <= HEVC_NAL_IDR_N_LP;
+	}
+
+	return type == AVC_NAL_IDR_SLICE;
+}
+
+int32_t nal_first_vcl_type( nal_codec_t codec, const uint8_t* data, size_t size )
+{
+	nal_iterator_t it;
+	nal_unit_t nal;
+
+	nal_iterator_init( &it, codec, data, size );
+
+	while( nal_iterator_next( &it, &nal ) == true )
+	{
+		if( nal_is_vcl( codec, nal.type ) == true )
+		{
+			return nal.type;
+		}
+	}
+
+	return -1;
+}
+
+void bit_reader_init( bit_reader_t* reader, const nal_unit_t* nal, size_t header_size )
+{
+	memset( reader, 0, sizeof( bit_reader_t ) );
+
+	reader->data = nal->data;
+	reader->size = nal->size;
+	reader->pos = header_size;
+}
+
+static int32_t bit_reader_read_bit( bit_reader_t* reader )
+{
+	int32_t bit;
+
+	if( reader->pos >= reader->size )
+	{
+		reader->overrun = true;
+		return 0;
+	}
+
+	if( reader->bit == 0 )
+	{
+		// 00 00 03 is an emulation prevention sequence, the 03 is not part of the RBSP
+		if( reader->zeros >= 2 && reader->data[ reader->pos ] == 0x03 )
+		{
+			reader->zeros = 0;
+			reader->pos++;
+			if( reader->pos >= reader->size )
+			{
+				reader->overrun = true;
+				return 0;
+			}
+		}
+
+		reader->zeros = ( reader->data[ reader->pos ] == 0 ) ? reader->zeros + 1 : 0;
+	}
+
+	bit = ( reader->data[ reader->pos ] >> ( 7 - reader->bit ) ) & 1;
+
+	if( ++reader->bit == 8 )
+	{
+		reader->bit = 0;
+		reader->pos++;
+	}
+
+	return bit;
+}
+
+uint32_t bit_reader_read( bit_reader_t* reader, int32_t bits )
+{
+	uint32_t value = 0;
+
+	while( bits-- > 0 )
+	{
+		value = ( value << 1 ) | ( uint32_t )bit_reader_read_bit( reader );
+	}
+
+	return value;
+}
+
+uint32_t bit_reader_read_ue( bit_reader_t* reader )
+{
+	int32_t leading_zeros = 0;
+
+	while( bit_reader_read_bit( reader ) == 0 )
+	{
+		if( reader->overrun || ++leading_zeros > 31 )
+		{
+			reader->overrun = true;
+			return 0;
+		}
+	}
+
+	return ( ( 1u << leading_zeros ) - 1 ) + bit_reader_read( reader, leading_zeros );
+}
+
+int32_t bit_reader_read_se( bit_reader_t* reader )
+{
+	uint32_t value = bit_reader_read_ue( reader );
+
+	return ( value & 1 ) ? ( int32_t )( ( value + 1 ) >> 1 ) : -( int32_t )( value >> 1 );
+}
+
+static void parse_hevc_pps_layout( const nal_unit_t* nal, nal_layout_t* layout )
+{
+	bit_reader_t reader;
+	bool tiles;
+	bool wpp;
+
+	bit_reader_init( &reader, nal, 2 );
+
+	bit_reader_read_ue( &reader );      // pps_pic_parameter_set_id
+	bit_reader_read_ue( &reader );      // pps_seq_parameter_set_id
+	bit_reader_read( &reader, 1 );      // dependent_slice_segments_enabled_flag
+	bit_reader_read( &reader, 1 );      // output_flag_present_flag
+	bit_reader_read( &reader, 3 );      // num_extra_slice_header_bits
+	bit_reader_read( &reader, 1 );      // sign_data_hiding_enabled_flag
+	bit_reader_read( &reader, 1 );      // cabac_init_present_flag
+	bit_reader_read_ue( &reader );      // num_ref_idx_l0_default_active_minus1
+	bit_reader_read_ue( &reader );      // num_ref_idx_l1_default_active_minus1
+	bit_reader_read_se( &reader );      // init_qp_minus26
+	bit_reader_read( &reader, 1 );      // constrained_intra_pred_flag
+	bit_reader_read( &reader, 1 );      // transform_skip_enabled_flag
+	if( bit_reader_read( &reader, 1 ) ) // cu_qp_delta_enabled_flag
+	{
+		bit_reader_read_ue( &reader );  // diff_cu_qp_delta_depth
+	}
+	bit_reader_read_se( &reader );      // pps_cb_qp_offset
+	bit_reader_read_se( &reader );      // pps_cr_qp_offset
+	bit_reader_read( &reader, 1 );      // pps_slice_chroma_qp_offsets_present_flag
+	bit_reader_read( &reader, 1 );      // weighted_pred_flag
+	bit_reader_read( &reader, 1 );      // weighted_bipred_flag
+	bit_reader_read( &reader, 1 );      // transquant_bypass_enabled_flag
+	tiles = bit_reader_read( &reader, 1 ) != 0;
+	wpp = bit_reader_read( &reader, 1 ) != 0;
+
+	if( reader.overrun == false )
+	{
+		layout->tiles |= tiles;
+		layout->wpp |= wpp;
+	}
+}
+
+void nal_parse_layout( nal_codec_t codec, const uint8_t* data, size_t size, nal_layout_t* layout )
+{
+	nal_iterator_t it;
+	nal_unit_t nal;
+
+	memset( layout, 0, sizeof( nal_layout_t ) );
+
+	nal_iterator_init( &it, codec, data, size );
+
+	while( nal_iterator_next( &it, &nal ) == true )
+	{
+		if( codec == NAL_CODEC_HEVC && nal.type == HEVC_NAL_PPS )
+		{
+			parse_hevc_pps_layout( &nal, layout );
+		}
+		else if( nal_is_vcl( codec, nal.type ) == true )
+		{
+			bool first_slice;
+
+			if( codec == NAL_CODEC_HEVC )
+			{
+				if( nal.size < 3 )
+				{
+					continue;
+				}
+
+				// first_slice_segment_in_pic_flag
+				first_slice = ( nal.data[ 2 ] & 0x80 ) != 0;
+			}
+			else
+			{
+				// first_mb_in_slice == 0 is coded as a single '1' bit
+				first_slice = ( nal.size > 1 ) && ( nal.data[ 1 ] & 0x80 ) != 0;
+			}
+
+			if( first_slice == true && layout->slices > 0 )
+			{
+				break;
+			}
+
+			layout->slices++;
+		}
+	}
+}
+
+static bool has_avc_recovery_point( const nal_unit_t* nal )
+{
+	bit_reader_t reader;
+
+	bit_reader_init( &reader, nal, 1 );
+
+	// sei_message( ) until the rbsp trailing bits
+	while( reader.pos + 1 < reader.size && reader.overrun == false )
+	{
+		uint32_t payload_type = 0;
+		uint32_t payload_size = 0;
+		uint32_t byte;
+
+		do
+		{
+			byte = bit_reader_read( &reader, 8 );
+			payload_type += byte;
+		} while( byte == 0xff && reader.overrun == false );
+
+		do
+		{
+			byte = bit_reader_read( &reader, 8 );
+			payload_size += byte;
+		} while( byte == 0xff && reader.overrun == false );
+
+		// recovery_point
+		if( payload_type == 6 && reader.overrun == false )
+		{
+			return true;
+		}
+
+		while( payload_size-- > 0 && reader.overrun == false )
+		{
+			bit_reader_read( &reader, 8 );
+		}
+	}
+
+	return false;
+}
+
+nal_picture_kind_t nal_classify_picture( nal_codec_t codec, const uint8_t* data, size_t size )
+{
+	bool recovery_point = false;
+	nal_iterator_t it;
+	nal_unit_t nal;
+
+	nal_iterator_init( &it, codec, data, size );
+
+	while( nal_iterator_next( &it, &nal ) == true )
+	{
+		if( codec == NAL_CODEC_AVC && nal.type == AVC_NAL_SEI )
+		{
+			recovery_point |= has_avc_recovery_point( &nal );
+			continue;
+		}
+
+		if( nal_is_vcl( codec, nal.type ) == false )
+		{
+			continue;
+		}
+
+		if( codec == NAL_CODEC_HEVC )
+		{
+			// BLA, IDR and CRA pictures are IRAP pictures, the even types up to 14 are sub-layer non-reference pictures
+			if( nal.type >= 16 && nal.type <= 23 )
+			{
+				return NAL_PICTURE_KEY;
+			}
+
+			return ( nal.type <= 14 && ( nal.type & 1 ) == 0 ) ? NAL_PICTURE_NON_REFERENCE : NAL_PICTURE_REFERENCE;
+		}
+
+		if( nal.type == AVC_NAL_IDR_SLICE || recovery_point == true )
+		{
+			return NAL_PICTURE_KEY;
+		}
+
+		// nal_ref_idc
+		return ( ( nal.data[ 0 ] >> 5 ) & 3 ) == 0 ? NAL_PICTURE_NON_REFERENCE : NAL_PICTURE_REFERENCE;
+	}
+
+	return NAL_PICTURE_NONE;
+}
@@ -0,0 +1,172 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief Annex-B NAL unit helpers of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_nal.h
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_NAL_H_
+#define __FFMPEG_VID_DEC_NAL_H_
+
+#include <stddef.h>
+#include "dvpd_vid_dec_plugin.h"
+
+#define HEVC_NAL_RADL_N 6
+#define HEVC_NAL_RADL_R 7
+#define HEVC_NAL_RASL_N 8
+#define HEVC_NAL_RASL_R 9
+#define HEVC_NAL_BLA_W_LP 16
+#define HEVC_NAL_IDR_N_LP 20
+#define HEVC_NAL_CRA 21
+#define HEVC_NAL_VPS 32
+#define HEVC_NAL_SPS 33
+#define HEVC_NAL_PPS 34
+#define HEVC_NAL_AUD 35
+#define HEVC_NAL_SEI_PREFIX 39
+
+#define AVC_NAL_SLICE 1
+#define AVC_NAL_IDR_SLICE 5
+#define AVC_NAL_SEI 6
+#define AVC_NAL_SPS 7
+#define AVC_NAL_PPS 8
+#define AVC_NAL_AUD 9
+
+typedef enum
+{
+	NAL_CODEC_AVC = 0,
+	NAL_CODEC_HEVC
+} nal_codec_t;
+
+typedef enum
+{
+	NAL_PICTURE_NONE = 0,               /**< @details no slice data */
+	NAL_PICTURE_NON_REFERENCE,          /**< @details not used for reference by other pictures */
+	NAL_PICTURE_REFERENCE,
+	NAL_PICTURE_KEY                     /**< @details random access point: HEVC IRAP, AVC IDR or recovery point */
+} nal_picture_kind_t;
+
+typedef struct
+{
+	const uint8_t *data;                /**< @details first byte of the NAL unit header */
+	size_t size;                        /**< @details size of the NAL unit without trailing zero bytes */
+	int32_t type;                       /**< @details nal_unit_type */
+} nal_unit_t;
+
+typedef struct
+{
+	const uint8_t *pos;
+	const uint8_t *end;
+	nal_codec_t codec;
+} nal_iterator_t;
+
+typedef struct
+{
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	int32_t bit;
+	int32_t zeros;
+	bool overrun;
+} bit_reader_t;
+
+typedef struct
+{
+	int32_t slices;                     /**< @details VCL NAL units of the first picture */
+	bool wpp;                           /**< @details entropy coding sync (wavefront parallel processing) enabled */
+	bool tiles;                         /**< @details tiles enabled */
+} nal_layout_t;
+
+/*!
+	nal_find_start_code
+	@brief returns a pointer to the next 00 00 01 start code prefix in [p, end) or end if there is none.\n
+*/
+const uint8_t* nal_find_start_code( const uint8_t* p, const uint8_t* end );
+
+void nal_iterator_init( nal_iterator_t* it, nal_codec_t codec, const uint8_t* data, size_t size );
+
+/*!
+	nal_iterator_next
+	@brief returns the next NAL unit of an Annex-B byte stream.\n
+	@return false if there are no more NAL units
+*/
+bool nal_iterator_next( nal_iterator_t* it, nal_unit_t* nal );
+
+/*!
+	nal_is_vcl
+	@brief returns true for NAL units carrying slice data.\n
+*/
+bool nal_is_vcl( nal_codec_t codec, int32_t type );
+
+/*!
+	nal_is_parameter_set
+	@brief returns true for video, sequence and picture parameter sets.\n
+*/
+bool nal_is_parameter_set( nal_codec_t codec, int32_t type );
+
+/*!
+	nal_is_idr
+	@brief returns true for the slices of IDR pictures and, for HEVC, BLA pictures. Unlike at a CRA picture or an AVC
+	recovery point, a decoder starting at such a picture decodes every picture the decoder of the whole stream outputs.\n
+*/
+bool nal_is_idr( nal_codec_t codec, int32_t type );
+
+/*!
+	nal_first_vcl_type
+	@brief returns the nal_unit_type of the first VCL NAL unit of an access unit, -1 if there is none.\n
+*/
+int32_t nal_first_vcl_type( nal_codec_t codec, const uint8_t* data, size_t size );
+
+/*!
+	bit_reader_init
+	@brief initializes a reader of the RBSP of a NAL unit, emulation prevention bytes are skipped.\n
+	@param [in]  header_size size of the NAL unit header to skip (1 for AVC, 2 for HEVC)
+*/
+void bit_reader_init( bit_reader_t* reader, const nal_unit_t* nal, size_t header_size );
+uint32_t bit_reader_read( bit_reader_t* reader, int32_t bits );
+uint32_t bit_reader_read_ue( bit_reader_t* reader );
+int32_t bit_reader_read_se( bit_reader_t* reader );
+
+/*!
+	nal_parse_layout
+	@brief determines the slice, tile and wavefront layout of the first picture of an access unit.\n
+*/
+void nal_parse_layout( nal_codec_t codec, const uint8_t* data, size_t size, nal_layout_t* layout );
+
+/*!
+	nal_classify_picture
+	@brief classifies the first picture of an access unit by its first slice and, for AVC, a preceding recovery point SEI.\n
+*/
+nal_picture_kind_t nal_classify_picture( nal_codec_t codec, const uint8_t* data, size_t size );
+
+#endif // __FFMPEG_VID_DEC_NAL_H_
@@ -0,0 +1,139 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_parameter_sets.h"
+#include <libavcodec/avcodec.h>
+
+void parameter_sets_store( parameter_sets_t* parameter_sets, const nal_unit_t* nal )
+{
+	parameter_set_t parameter_set = { NULL, 0 };
+	int32_t i;
+
+	for( i = 0; i < parameter_sets->count; i++ )
+	{
+		if( parameter_sets->sets[ i ].size == nal->size && memcmp( parameter_sets->sets[ i ].data, nal->data, nal->size ) == 0 )
+		{
+			parameter_set = parameter_sets->sets[ i ];
+			break;
+		}
+	}
+
+	if( parameter_set.data == NULL )
+	{
+		parameter_set.data = ( uint8_t* )malloc( nal->size );
+		if( parameter_set.data == NULL )
+		{
+			return;
+		}
+		memcpy( parameter_set.data, nal->data, nal->size );
+		parameter_set.size = nal->size;
+
+		// the oldest parameter set makes room
+		if( parameter_sets->count == MAX_PARAMETER_SETS )
+		{
+			free( parameter_sets->sets[ 0 ].data );
+			i = 0;
+		}
+		else
+		{
+			i = parameter_sets->count++;
+		}
+	}
+
+	memmove( &parameter_sets->sets[ i ], &parameter_sets->sets[ i + 1 ], ( parameter_sets->count - 1 - i ) * sizeof( parameter_set_t ) );
+	parameter_sets->sets[ parameter_sets->count - 1 ] = parameter_set;
+}
+
+void parameter_sets_store_access_unit( parameter_sets_t* parameter_sets, nal_codec_t codec, const uint8_t* data, size_t size )
+{
+	nal_iterator_t it;
+	nal_unit_t nal;
+
+	nal_iterator_init( &it, codec, data, size );
+
+	while( nal_iterator_next( &it, &nal ) == true && nal_is_vcl( codec, nal.type ) == false )
+	{
+		if( nal_is_parameter_set( codec, nal.type ) == true )
+		{
+			parameter_sets_store( parameter_sets, &nal );
+		}
+	}
+}
+
+uint8_t* parameter_sets_write( const parameter_sets_t* parameter_sets, int32_t* size )
+{
+	static const uint8_t start_code[ 4 ] = { 0, 0, 0, 1 };
+	uint8_t* data;
+	uint8_t* p;
+
+	*size = 0;
+
+	if( parameter_sets->count == 0 )
+	{
+		return NULL;
+	}
+
+	for( int32_t i = 0; i < parameter_sets->count; i++ )
+	{
+		*size += ( int32_t )( sizeof( start_code ) + parameter_sets->sets[ i ].size );
+	}
+
+	data = ( uint8_t* )av_malloc( *size + AV_INPUT_BUFFER_PADDING_SIZE );
+	if( data == NULL )
+	{
+		return NULL;
+	}
+
+	p = data;
+	for( int32_t i = 0; i < parameter_sets->count; i++ )
+	{
+		memcpy( p, start_code, sizeof( start_code ) );
+		memcpy( p + sizeof( start_code ), parameter_sets->sets[ i ].data, parameter_sets->sets[ i ].size );
+		p += sizeof( start_code ) + parameter_sets->sets[ i ].size;
+	}
+	memset( p, 0, AV_INPUT_BUFFER_PADDING_SIZE );
+
+	return data;
+}
+
+void parameter_sets_clear( parameter_sets_t* parameter_sets )
+{
+	for( int32_t i = 0; i < parameter_sets->count; i++ )
+	{
+		free( parameter_sets->sets[ i ].data );
+	}
+
+	parameter_sets->count = 0;
+}
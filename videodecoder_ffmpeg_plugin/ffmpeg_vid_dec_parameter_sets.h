@@ -0,0 +1,87 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief parameter set store of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_parameter_sets.h
+*
+* A decoder opened in the middle of a stream only knows the parameter sets that follow. The store keeps the latest
+* version of every parameter set in stream order, so replaying it restores the state of a decoder that saw the whole
+* stream.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_PARAMETER_SETS_H_
+#define __FFMPEG_VID_DEC_PARAMETER_SETS_H_
+
+#include "ffmpeg_vid_dec_nal.h"
+
+#define MAX_PARAMETER_SETS 32
+
+typedef struct
+{
+	uint8_t *data;
+	size_t size;
+} parameter_set_t;
+
+typedef struct
+{
+	parameter_set_t sets[ MAX_PARAMETER_SETS ];
+	int32_t count;
+} parameter_sets_t;
+
+/*!
+	parameter_sets_store
+	@brief stores a parameter set NAL unit as the latest one, the oldest one makes room when the store is full.\n
+*/
+void parameter_sets_store( parameter_sets_t* parameter_sets, const nal_unit_t* nal );
+
+/*!
+	parameter_sets_store_access_unit
+	@brief stores the parameter sets ahead of the first slice of an access unit.\n
+*/
+void parameter_sets_store_access_unit( parameter_sets_t* parameter_sets, nal_codec_t codec, const uint8_t* data, size_t size );
+
+/*!
+	parameter_sets_write
+	@brief returns the stored parameter sets as Annex-B byte stream with padding, allocated with av_malloc.\n
+	@return NULL if the store is empty or on allocation failure
+*/
+uint8_t* parameter_sets_write( const parameter_sets_t* parameter_sets, int32_t* size );
+
+/*!
+	parameter_sets_clear
+	@brief frees the stored parameter sets.\n
+*/
+void parameter_sets_clear( parameter_sets_t* parameter_sets );
+
+#endif // __FFMPEG_VID_DEC_PARAMETER_SETS_H_
@@ -0,0 +1,268 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_picture_info.h"
+
+#define HDR_SIDE_DATA_SUPPORTED ( LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(55,60,100) )
+#define DOVI_RPU_SUPPORTED ( LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57,11,100) )
+
+#if HDR_SIDE_DATA_SUPPORTED
+#include <libavutil/mastering_display_metadata.h>
+#endif
+
+struct picture_info_pool_s_
+{
+	vid_dec_mutex_t mutex;
+	volatile int32_t refs;
+
+	picture_info_t *unused;
+};
+
+static void picture_info_pool_unref( picture_info_pool_t* pool )
+{
+	picture_info_t* info;
+
+	if( vid_dec_atomic_add32( &pool->refs, -1 ) != 0 )
+	{
+		return;
+	}
+
+	while( ( info = pool->unused ) != NULL )
+	{
+		pool->unused = info->next;
+		av_frame_free( &info->frame );
+		free( info );
+	}
+
+	vid_dec_mutex_destroy( &pool->mutex );
+	free( pool );
+}
+
+#if HDR_SIDE_DATA_SUPPORTED
+static uint32_t scale_rational( AVRational value, int32_t scale )
+{
+	if( value.num <= 0 || value.den <= 0 )
+	{
+		return 0;
+	}
+
+	return ( uint32_t )( ( ( int64_t )value.num * scale + value.den / 2 ) / value.den );
+}
+
+static void read_side_data( ffmpeg_vid_dec_picture_info_t* info, const AVFrame* frame )
+{
+	const AVFrameSideData* side_data;
+
+	side_data = av_frame_get_side_data( frame, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA );
+	if( side_data != NULL )
+	{
+		const AVMasteringDisplayMetadata* mastering = ( const AVMasteringDisplayMetadata* )side_data->data;
+
+		if( mastering->has_primaries != 0 && mastering->has_luminance != 0 )
+		{
+			for( int32_t i = 0; i < 3; i++ )
+			{
+				info->display_primaries[ i ][ 0 ] = ( uint16_t )scale_rational( mastering->display_primaries[ i ][ 0 ], 50000 );
+				info->display_primaries[ i ][ 1 ] = ( uint16_t )scale_rational( mastering->display_primaries[ i ][ 1 ], 50000 );
+			}
+			info->white_point[ 0 ] = ( uint16_t )scale_rational( mastering->white_point[ 0 ], 50000 );
+			info->white_point[ 1 ] = ( uint16_t )scale_rational( mastering->white_point[ 1 ], 50000 );
+			info->max_display_mastering_luminance = scale_rational( mastering->max_luminance, 10000 );
+			info->min_display_mastering_luminance = scale_rational( mastering->min_luminance, 10000 );
+			info->flags |= FFMPEG_VID_DEC_PICTURE_INFO_MASTERING_DISPLAY;
+		}
+	}
+
+	side_data = av_frame_get_side_data( frame, AV_FRAME_DATA_CONTENT_LIGHT_LEVEL );
+	if( side_data != NULL )
+	{
+		const AVContentLightMetadata* light = ( const AVContentLightMetadata* )side_data->data;
+
+		info->max_content_light_level = ( uint16_t )light->MaxCLL;
+		info->max_pic_average_light_level = ( uint16_t )light->MaxFALL;
+		info->flags |= FFMPEG_VID_DEC_PICTURE_INFO_CONTENT_LIGHT;
+	}
+
+#if DOVI_RPU_SUPPORTED
+	side_data = av_frame_get_side_data( frame, AV_FRAME_DATA_DOVI_RPU_BUFFER );
+	if( side_data != NULL && side_data->size > 0 )
+	{
+		info->rpu = side_data->data;
+		info->rpu_size = ( uint32_t )side_data->size;
+		info->flags |= FFMPEG_VID_DEC_PICTURE_INFO_RPU;
+	}
+#endif
+}
+#endif
+
+static void read_sequence( ffmpeg_vid_dec_picture_info_t* info, const AVFrame* frame, const picture_sequence_t* sequence )
+{
+	info->profile = sequence->profile;
+	info->level = sequence->level;
+	info->coded_width = sequence->coded_width;
+	info->coded_height = sequence->coded_height;
+
+	if( frame->sample_aspect_ratio.num > 0 && frame->sample_aspect_ratio.den > 0 )
+	{
+		info->sar_width = frame->sample_aspect_ratio.num;
+		info->sar_height = frame->sample_aspect_ratio.den;
+	}
+
+	// the colour enumerations of libavutil use the code points of H.273
+	info->colour_primaries = ( uint8_t )frame->color_primaries;
+	info->transfer_characteristics = ( uint8_t )frame->color_trc;
+	info->matrix_coeffs = ( uint8_t )frame->colorspace;
+	info->video_full_range_flag = ( frame->color_range == AVCOL_RANGE_JPEG ) ? 1 : 0;
+	info->chroma_sample_loc_type = ( int8_t )( ( int32_t )frame->chroma_location - 1 );
+
+#if ( LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(58,7,100) )
+	info->key_picture = ( frame->flags & AV_FRAME_FLAG_KEY ) != 0 ? 1 : 0;
+#else
+	info->key_picture = frame->key_frame != 0 ? 1 : 0;
+#endif
+}
+
+void picture_sequence_read( picture_sequence_t* sequence, const AVCodecContext* av_codec_ctx )
+{
+	sequence->profile = av_codec_ctx->profile >= 0 ? av_codec_ctx->profile : -1;
+	sequence->level = av_codec_ctx->level >= 0 ? av_codec_ctx->level : -1;
+	sequence->coded_width = av_codec_ctx->coded_width;
+	sequence->coded_height = av_codec_ctx->coded_height;
+}
+
+picture_info_pool_t* picture_info_pool_create( void )
+{
+	picture_info_pool_t* pool;
+
+	pool = ( picture_info_pool_t* )malloc( sizeof( picture_info_pool_t ) );
+	if( pool == NULL )
+	{
+		return NULL;
+	}
+
+	memset( pool, 0, sizeof( picture_info_pool_t ) );
+
+	vid_dec_mutex_init( &pool->mutex );
+	pool->refs = 1;
+
+	return pool;
+}
+
+void picture_info_pool_release( picture_info_pool_t** pool )
+{
+	if( pool == NULL || *pool == NULL )
+	{
+		return;
+	}
+
+	picture_info_pool_unref( *pool );
+	*pool = NULL;
+}
+
+picture_info_t* picture_info_take( picture_info_pool_t* pool, const AVFrame* frame, const picture_sequence_t* sequence )
+{
+	picture_info_t* info;
+
+	vid_dec_mutex_lock( &pool->mutex );
+	info = pool->unused;
+	if( info != NULL )
+	{
+		pool->unused = info->next;
+	}
+	vid_dec_mutex_unlock( &pool->mutex );
+
+	if( info == NULL )
+	{
+		info = ( picture_info_t* )malloc( sizeof( picture_info_t ) );
+		if( info == NULL )
+		{
+			return NULL;
+		}
+
+		info->frame = NULL;
+		info->pool = pool;
+	}
+
+	memset( &info->info, 0, sizeof( ffmpeg_vid_dec_picture_info_t ) );
+	info->info.size = sizeof( ffmpeg_vid_dec_picture_info_t );
+	info->next = NULL;
+	info->holds_frame = false;
+	info->owned = false;
+
+	read_sequence( &info->info, frame, sequence );
+#if HDR_SIDE_DATA_SUPPORTED
+	read_side_data( &info->info, frame );
+#endif
+
+	vid_dec_atomic_add32( &pool->refs, 1 );
+
+	return info;
+}
+
+bool picture_info_hold( picture_info_t* info, AVFrame* frame )
+{
+	if( info->frame == NULL )
+	{
+		info->frame = av_frame_alloc( );
+		if( info->frame == NULL )
+		{
+			return false;
+		}
+	}
+
+	// side data moves along, pointers into it stay valid
+	av_frame_move_ref( info->frame, frame );
+	info->holds_frame = true;
+
+	return true;
+}
+
+void picture_info_release( picture_info_t* info )
+{
+	picture_info_pool_t* pool = info->pool;
+
+	if( info->holds_frame == true )
+	{
+		av_frame_unref( info->frame );
+		info->holds_frame = false;
+	}
+
+	vid_dec_mutex_lock( &pool->mutex );
+	info->next = pool->unused;
+	pool->unused = info;
+	vid_dec_mutex_unlock( &pool->mutex );
+
+	picture_info_pool_unref( pool );
+}
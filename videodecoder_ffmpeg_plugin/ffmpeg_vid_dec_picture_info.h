@@ -0,0 +1,123 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief pooled per picture metadata of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_picture_info.h
+*
+* Every decoded picture carries a picture info (see ffmpeg_vid_dec_picture_info_t) as app_specific_data. Released
+* infos return to the pool of their instance together with the frame structure that holds the picture data, so no
+* memory is allocated per picture once the pool covers the pictures in flight. The pool lives until the instance
+* released it and all of its infos have been released, which may happen on any thread.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_PICTURE_INFO_H_
+#define __FFMPEG_VID_DEC_PICTURE_INFO_H_
+
+#include "ffmpeg_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_thread.h"
+#include <libavcodec/avcodec.h>
+
+typedef struct picture_info_pool_s_ picture_info_pool_t;
+
+/*!
+	picture_sequence_t
+	@brief sequence properties of the decoder context at the time a picture was output.\n
+*/
+typedef struct
+{
+	int32_t profile;
+	int32_t level;
+	int32_t coded_width;
+	int32_t coded_height;
+} picture_sequence_t;
+
+typedef struct picture_info_s_
+{
+	ffmpeg_vid_dec_picture_info_t info; /**< @details public part, must be the first member */
+
+	struct picture_info_s_ *next;
+	picture_info_pool_t *pool;
+	AVFrame *frame;                     /**< @details frame holding the picture data and the side data, allocated once */
+	bool holds_frame;
+	bool owned;                         /**< @details handed over to the host, which returns it with release_picture */
+} picture_info_t;
+
+/*!
+	picture_info_pool_create
+	@brief creates a picture info pool.\n
+*/
+picture_info_pool_t* picture_info_pool_create( void );
+
+/*!
+	picture_info_pool_release
+	@brief releases the pool. Infos still in use are freed when they are released.\n
+*/
+void picture_info_pool_release( picture_info_pool_t** pool );
+
+/*!
+	picture_sequence_read
+	@brief captures the sequence properties of a decoder context.\n
+*/
+void picture_sequence_read( picture_sequence_t* sequence, const AVCodecContext* av_codec_ctx );
+
+/*!
+	picture_info_take
+	@brief returns an info filled from the decoded frame and the sequence properties of its decoder, NULL if the
+	allocation failed. Pointers into side data of frame stay valid as long as frame, or the info after picture_info_hold.\n
+*/
+picture_info_t* picture_info_take( picture_info_pool_t* pool, const AVFrame* frame, const picture_sequence_t* sequence );
+
+/*!
+	picture_info_hold
+	@brief moves the reference of frame into the info, so that the picture data lives as long as the info. Returns
+	false if the frame structure could not be allocated.\n
+*/
+bool picture_info_hold( picture_info_t* info, AVFrame* frame );
+
+/*!
+	picture_info_release
+	@brief drops the frame reference held by the info and returns the info to its pool. Thread safe.\n
+*/
+void picture_info_release( picture_info_t* info );
+
+/*!
+	picture_info_from_app_data
+	@brief returns the info passed as dvpd_input_dec_picture_t::app_specific_data.\n
+*/
+static inline picture_info_t* picture_info_from_app_data( void* app_specific_data )
+{
+	return ( picture_info_t* )app_specific_data;
+}
+
+#endif // __FFMPEG_VID_DEC_PICTURE_INFO_H_
@@ -0,0 +1,264 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_picture_queue.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+typedef struct
+{
+	dvpd_input_dec_picture_t picture;
+	bool end;
+} picture_entry_t;
+
+struct picture_queue_s_
+{
+	picture_entry_t* entries;
+	int32_t capacity;
+	int32_t head;
+	int32_t count;
+	bool discarding;
+
+	picture_queue_release_func_t release;
+	void* opaque;
+
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t not_full;
+	vid_dec_cond_t not_empty;
+};
+
+picture_queue_t* picture_queue_create( int32_t capacity, picture_queue_release_func_t release, void* opaque )
+{
+	picture_queue_t* queue;
+
+	if( capacity < 1 )
+	{
+		return NULL;
+	}
+
+	queue = ( picture_queue_t* )calloc( 1, sizeof( picture_queue_t ) );
+	if( queue == NULL )
+	{
+		return NULL;
+	}
+
+	queue->entries = ( picture_entry_t* )calloc( capacity, sizeof( picture_entry_t ) );
+	if( queue->entries == NULL )
+	{
+		free( queue );
+		return NULL;
+	}
+
+	queue->capacity = capacity;
+	queue->release = release;
+	queue->opaque = opaque;
+
+	vid_dec_mutex_init( &queue->mutex );
+	vid_dec_cond_init( &queue->not_full );
+	vid_dec_cond_init( &queue->not_empty );
+
+	return queue;
+}
+
+/*
+ * drops the queued pictures, the end markers stay. Called with the mutex held.
+ */
+static void drop_pictures( picture_queue_t* queue )
+{
+	int32_t count = 0;
+
+	for( int32_t i = 0; i < queue->count; i++ )
+	{
+		picture_entry_t* entry = &queue->entries[ ( queue->head + i ) % queue->capacity ];
+
+		if( entry->end == true )
+		{
+			queue->entries[ ( queue->head + count++ ) % queue->capacity ] = *entry;
+		}
+		else
+		{
+			queue->release( queue->opaque, &entry->picture );
+		}
+	}
+
+	queue->count = count;
+}
+
+void picture_queue_release( picture_queue_t** queue )
+{
+	if( *queue == NULL )
+	{
+		return;
+	}
+
+	drop_pictures( *queue );
+
+	vid_dec_cond_destroy( &( *queue )->not_empty );
+	vid_dec_cond_destroy( &( *queue )->not_full );
+	vid_dec_mutex_destroy( &( *queue )->mutex );
+
+	free( ( *queue )->entries );
+	free( *queue );
+	*queue = NULL;
+}
+
+/*
+ * waits for a free entry, returns false if discarding started meanwhile. Called with the mutex held.
+ */
+static bool wait_not_full( picture_queue_t* queue, bool picture )
+{
+	while( queue->count == queue->capacity && ( picture == false || queue->discarding == false ) )
+	{
+		vid_dec_cond_wait( &queue->not_full, &queue->mutex );
+	}
+
+	return picture == false || queue->discarding == false;
+}
+
+static void append( picture_queue_t* queue, const dvpd_input_dec_picture_t* picture )
+{
+	picture_entry_t* entry = &queue->entries[ ( queue->head + queue->count ) % queue->capacity ];
+
+	if( picture != NULL )
+	{
+		entry->picture = *picture;
+	}
+	entry->end = ( picture == NULL );
+
+	queue->count++;
+	vid_dec_cond_signal( &queue->not_empty );
+}
+
+bool picture_queue_push( picture_queue_t* queue, const dvpd_input_dec_picture_t* picture )
+{
+	dvpd_input_dec_picture_t dropped;
+
+	vid_dec_mutex_lock( &queue->mutex );
+
+	if( wait_not_full( queue, true ) == true )
+	{
+		append( queue, picture );
+		vid_dec_mutex_unlock( &queue->mutex );
+		return true;
+	}
+
+	vid_dec_mutex_unlock( &queue->mutex );
+
+	dropped = *picture;
+	queue->release( queue->opaque, &dropped );
+
+	return false;
+}
+
+void picture_queue_end( picture_queue_t* queue )
+{
+	vid_dec_mutex_lock( &queue->mutex );
+
+	wait_not_full( queue, false );
+	append( queue, NULL );
+
+	vid_dec_mutex_unlock( &queue->mutex );
+}
+
+int32_t picture_queue_pop( picture_queue_t* queue, int32_t timeout_ms, dvpd_input_dec_picture_t* picture )
+{
+	picture_entry_t* entry;
+	int32_t result;
+
+	vid_dec_mutex_lock( &queue->mutex );
+
+	while( queue->count == 0 )
+	{
+		if( timeout_ms == 0 )
+		{
+			vid_dec_mutex_unlock( &queue->mutex );
+			return DVPD_INPUT_DEC_RECEIVE_AGAIN;
+		}
+
+		if( timeout_ms < 0 )
+		{
+			vid_dec_cond_wait( &queue->not_empty, &queue->mutex );
+		}
+		else if( vid_dec_cond_timedwait( &queue->not_empty, &queue->mutex, timeout_ms ) == false && queue->count == 0 )
+		{
+			vid_dec_mutex_unlock( &queue->mutex );
+			return DVPD_INPUT_DEC_RECEIVE_AGAIN;
+		}
+	}
+
+	entry = &queue->entries[ queue->head ];
+	if( entry->end == true )
+	{
+		result = DVPD_INPUT_DEC_RECEIVE_EOF;
+	}
+	else
+	{
+		*picture = entry->picture;
+		result = DVPD_INPUT_DEC_RECEIVE_OK;
+	}
+
+	queue->head = ( queue->head + 1 ) % queue->capacity;
+	queue->count--;
+	vid_dec_cond_signal( &queue->not_full );
+
+	vid_dec_mutex_unlock( &queue->mutex );
+
+	return result;
+}
+
+void picture_queue_discard( picture_queue_t* queue, bool discard )
+{
+	vid_dec_mutex_lock( &queue->mutex );
+
+	queue->discarding = discard;
+	if( discard == true )
+	{
+		drop_pictures( queue );
+		vid_dec_cond_broadcast( &queue->not_full );
+	}
+
+	vid_dec_mutex_unlock( &queue->mutex );
+}
+
+int32_t picture_queue_size( picture_queue_t* queue )
+{
+	int32_t count;
+
+	vid_dec_mutex_lock( &queue->mutex );
+	count = queue->count;
+	vid_dec_mutex_unlock( &queue->mutex );
+
+	return count;
+}
@@ -0,0 +1,101 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief bounded queue of decoded pictures of the FFmpeg video decoder plugin, read by dvpd_input_dec_if_t::receive_picture.
+* @file ffmpeg_vid_dec_picture_queue.h
+*
+* The decoding thread appends pictures and blocks while the queue is full, which holds back the decoding until the
+* consumer catches up. End markers separate the pictures of a flush from the pictures of the stream continuing after
+* it. While discarding, the queue drops all pictures, which lets a flush return without a consumer.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_PICTURE_QUEUE_H_
+#define __FFMPEG_VID_DEC_PICTURE_QUEUE_H_
+
+#include "dvpd_vid_dec_plugin.h"
+
+typedef struct picture_queue_s_ picture_queue_t;
+
+/*!
+	picture_queue_release_func_t
+	@brief releases a picture the queue drops.\n
+*/
+typedef void( *picture_queue_release_func_t )( void* opaque, dvpd_input_dec_picture_t* picture );
+
+/*!
+	picture_queue_create
+	@brief creates a queue holding up to capacity pictures and end markers.\n
+*/
+picture_queue_t* picture_queue_create( int32_t capacity, picture_queue_release_func_t release, void* opaque );
+
+/*!
+	picture_queue_release
+	@brief drops the queued pictures and frees the queue. No thread may wait on the queue.\n
+*/
+void picture_queue_release( picture_queue_t** queue );
+
+/*!
+	picture_queue_push
+	@brief appends a picture, blocks while the queue is full. Returns false if the picture was dropped by discarding.\n
+*/
+bool picture_queue_push( picture_queue_t* queue, const dvpd_input_dec_picture_t* picture );
+
+/*!
+	picture_queue_end
+	@brief appends an end marker, blocks while the queue is full.\n
+*/
+void picture_queue_end( picture_queue_t* queue );
+
+/*!
+	picture_queue_pop
+	@brief removes the oldest entry. Waits up to timeout_ms milliseconds while the queue is empty, without limit if
+	timeout_ms is negative. Returns DVPD_INPUT_DEC_RECEIVE_OK with the picture, DVPD_INPUT_DEC_RECEIVE_EOF for an end
+	marker or DVPD_INPUT_DEC_RECEIVE_AGAIN if the queue stayed empty.\n
+*/
+int32_t picture_queue_pop( picture_queue_t* queue, int32_t timeout_ms, dvpd_input_dec_picture_t* picture );
+
+/*!
+	picture_queue_discard
+	@brief starts or stops discarding. Starting drops the queued pictures and wakes a blocked producer, which drops
+	its picture as well.\n
+*/
+void picture_queue_discard( picture_queue_t* queue, bool discard );
+
+/*!
+	picture_queue_size
+	@brief returns the number of queued pictures and end markers.\n
+*/
+int32_t picture_queue_size( picture_queue_t* queue );
+
+#endif // __FFMPEG_VID_DEC_PICTURE_QUEUE_H_
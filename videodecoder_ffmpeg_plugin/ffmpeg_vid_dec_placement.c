@@ -0,0 +1,317 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_placement.h"
+
+#if PLACEMENT_SUPPORTED
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// from linux/mempolicy.h, libnuma is not required
+#define PLACEMENT_MPOL_PREFERRED 1
+#endif
+
+void placement_init( placement_t* placement )
+{
+	memset( placement, 0, sizeof( placement_t ) );
+	placement->numa_node = -1;
+}
+
+bool placement_has_cpus( const placement_t* placement )
+{
+	for( size_t i = 0; i < PLACEMENT_MAX_CPUS / 64; i++ )
+	{
+		if( placement->cpus[ i ] != 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32_t placement_cpu_count( const placement_t* placement )
+{
+	int32_t count = 0;
+
+	for( size_t i = 0; i < PLACEMENT_MAX_CPUS / 64; i++ )
+	{
+		for( uint64_t mask = placement->cpus[ i ]; mask != 0; mask &= mask - 1 )
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+bool placement_parse_cpus( const char* list, placement_t* placement )
+{
+	const char* p = list;
+
+	memset( placement->cpus, 0, sizeof( placement->cpus ) );
+
+	while( *p != '\0' && *p != '\n' )
+	{
+		char* end;
+		long first = strtol( p, &end, 10 );
+		long last = first;
+
+		if( end == p || first < 0 || first >= PLACEMENT_MAX_CPUS )
+		{
+			return false;
+		}
+		p = end;
+
+		if( *p == '-' )
+		{
+			p++;
+			last = strtol( p, &end, 10 );
+			if( end == p || last < first || last >= PLACEMENT_MAX_CPUS )
+			{
+				return false;
+			}
+			p = end;
+		}
+
+		for( long cpu = first; cpu <= last; cpu++ )
+		{
+			placement->cpus[ cpu / 64 ] |= 1ull << ( cpu % 64 );
+		}
+
+		if( *p == ',' )
+		{
+			p++;
+		}
+		else if( *p != '\0' && *p != '\n' )
+		{
+			return false;
+		}
+	}
+
+	return placement_has_cpus( placement );
+}
+
+static bool has_cpu( const placement_t* placement, int32_t cpu )
+{
+	return ( placement->cpus[ cpu / 64 ] >> ( cpu % 64 ) & 1 ) != 0;
+}
+
+void placement_format_cpus( const placement_t* placement, char* list, size_t size )
+{
+	size_t length = 0;
+
+	if( size == 0 )
+	{
+		return;
+	}
+
+	list[ 0 ] = '\0';
+
+	for( int32_t cpu = 0; cpu < PLACEMENT_MAX_CPUS && length < size; cpu++ )
+	{
+		int32_t last = cpu;
+		int written;
+
+		if( has_cpu( placement, cpu ) == false )
+		{
+			continue;
+		}
+
+		while( last + 1 < PLACEMENT_MAX_CPUS && has_cpu( placement, last + 1 ) == true )
+		{
+			last++;
+		}
+
+		if( last == cpu )
+		{
+			written = snprintf( list + length, size - length, "%s%d", length > 0 ? "," : "", cpu );
+		}
+		else
+		{
+			written = snprintf( list + length, size - length, "%s%d-%d", length > 0 ? "," : "", cpu, last );
+		}
+
+		if( written < 0 )
+		{
+			break;
+		}
+
+		length += ( size_t )written;
+		cpu = last;
+	}
+}
+
+bool placement_set_numa_node( int32_t node, placement_t* placement )
+{
+#if PLACEMENT_SUPPORTED
+	char path[ 64 ];
+	char list[ 1024 ];
+	placement_t node_placement;
+	FILE* file;
+	bool valid;
+
+	if( node < 0 || node >= PLACEMENT_MAX_NODES )
+	{
+		return false;
+	}
+
+	snprintf( path, sizeof( path ), "/sys/devices/system/node/node%d/cpulist", node );
+
+	file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		return false;
+	}
+
+	valid = fgets( list, sizeof( list ), file ) != NULL;
+	fclose( file );
+
+	// nodes without CPUs (memory only) have an empty list
+	if( valid == true && placement_has_cpus( placement ) == false && placement_parse_cpus( list, &node_placement ) == true )
+	{
+		memcpy( placement->cpus, node_placement.cpus, sizeof( placement->cpus ) );
+	}
+
+	if( valid == true )
+	{
+		placement->numa_node = node;
+	}
+
+	return valid;
+#else
+	( void )node;
+	( void )placement;
+
+	return false;
+#endif
+}
+
+#if PLACEMENT_SUPPORTED
+static void to_cpu_set( const placement_t* placement, cpu_set_t* set )
+{
+	CPU_ZERO( set );
+
+	for( int32_t cpu = 0; cpu < PLACEMENT_MAX_CPUS && cpu < CPU_SETSIZE; cpu++ )
+	{
+		if( has_cpu( placement, cpu ) == true )
+		{
+			CPU_SET( cpu, set );
+		}
+	}
+}
+
+static void from_cpu_set( const cpu_set_t* set, placement_t* placement )
+{
+	placement_init( placement );
+
+	for( int32_t cpu = 0; cpu < PLACEMENT_MAX_CPUS && cpu < CPU_SETSIZE; cpu++ )
+	{
+		if( CPU_ISSET( cpu, set ) )
+		{
+			placement->cpus[ cpu / 64 ] |= 1ull << ( cpu % 64 );
+		}
+	}
+}
+#endif
+
+bool placement_bind_thread( const placement_t* placement, placement_t* previous )
+{
+#if PLACEMENT_SUPPORTED
+	cpu_set_t set;
+
+	if( previous != NULL && placement_get_thread( previous ) == false )
+	{
+		return false;
+	}
+
+	to_cpu_set( placement, &set );
+
+	return pthread_setaffinity_np( pthread_self( ), sizeof( cpu_set_t ), &set ) == 0;
+#else
+	( void )placement;
+	( void )previous;
+
+	return false;
+#endif
+}
+
+bool placement_get_thread( placement_t* placement )
+{
+#if PLACEMENT_SUPPORTED
+	cpu_set_t set;
+
+	if( pthread_getaffinity_np( pthread_self( ), sizeof( cpu_set_t ), &set ) != 0 )
+	{
+		return false;
+	}
+
+	from_cpu_set( &set, placement );
+
+	return true;
+#else
+	placement_init( placement );
+
+	return false;
+#endif
+}
+
+bool placement_bind_memory( void* data, size_t size, int32_t node )
+{
+#if PLACEMENT_SUPPORTED && defined(SYS_mbind)
+	unsigned long mask = 1ul << node;
+
+	if( node < 0 || node >= PLACEMENT_MAX_NODES )
+	{
+		return false;
+	}
+
+	// preferred instead of bound, a full node falls back to the others instead of failing
+	return syscall( SYS_mbind, data, size, PLACEMENT_MPOL_PREFERRED, &mask, ( unsigned long )PLACEMENT_MAX_NODES + 1, 0 ) == 0;
+#else
+	( void )data;
+	( void )size;
+	( void )node;
+
+	return false;
+#endif
+}
@@ -0,0 +1,105 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief CPU and NUMA node placement of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_placement.h
+*
+* Threads created by libavcodec inherit the CPU affinity of the thread opening the decoder, which is bound to the
+* placement of the instance while it opens the decoder. Memory is bound to a node with mbind (Linux only).
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_PLACEMENT_H_
+#define __FFMPEG_VID_DEC_PLACEMENT_H_
+
+#include <stddef.h>
+#include "dvpd_vid_dec_plugin.h"
+
+#if defined(__linux__)
+#define PLACEMENT_SUPPORTED 1
+#else
+#define PLACEMENT_SUPPORTED 0
+#endif
+
+#define PLACEMENT_MAX_CPUS 1024
+#define PLACEMENT_MAX_NODES 64
+
+typedef struct
+{
+	uint64_t cpus[ PLACEMENT_MAX_CPUS / 64 ]; /**< @details CPU bit mask, empty for no CPU binding */
+	int32_t numa_node;                  /**< @details memory node, -1 for no memory binding */
+} placement_t;
+
+void placement_init( placement_t* placement );
+bool placement_has_cpus( const placement_t* placement );
+int32_t placement_cpu_count( const placement_t* placement );
+
+/*!
+	placement_parse_cpus
+	@brief parses a CPU list like "0-7,16,18-19" into the CPU mask of placement.\n
+*/
+bool placement_parse_cpus( const char* list, placement_t* placement );
+
+/*!
+	placement_format_cpus
+	@brief writes the CPU mask of placement as CPU list, which is truncated to size.\n
+*/
+void placement_format_cpus( const placement_t* placement, char* list, size_t size );
+
+/*!
+	placement_set_numa_node
+	@brief sets the memory node of placement, and its CPUs to those of the node if it has none yet.\n
+	@return false if the node does not exist
+*/
+bool placement_set_numa_node( int32_t node, placement_t* placement );
+
+/*!
+	placement_bind_thread
+	@brief binds the calling thread to the CPUs of placement.\n
+	@param [out] previous receives the previous CPUs of the thread if not NULL.
+*/
+bool placement_bind_thread( const placement_t* placement, placement_t* previous );
+
+/*!
+	placement_get_thread
+	@brief returns the CPUs the calling thread may run on.\n
+*/
+bool placement_get_thread( placement_t* placement );
+
+/*!
+	placement_bind_memory
+	@brief prefers the pages of a page aligned range, which has not been touched yet, on the given node.\n
+*/
+bool placement_bind_memory( void* data, size_t size, int32_t node );
+
+#endif // __FFMPEG_VID_DEC_PLACEMENT_H_
@@ -32,6 +32,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -40,11 +42,108 @@
 #include <unistd.h>
 #endif
 
-#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_au_splitter.h"
+#include "ffmpeg_vid_dec_context_pool.h"
+#include "ffmpeg_vid_dec_placement.h"
+#include "ffmpeg_vid_dec_stats.h"
+#include "ffmpeg_vid_dec_format.h"
+#include "ffmpeg_vid_dec_frame_pool.h"
+#include "ffmpeg_vid_dec_gop_decoder.h"
+#include "ffmpeg_vid_dec_hash.h"
+#include "ffmpeg_vid_dec_input_arena.h"
+#include "ffmpeg_vid_dec_layer_group.h"
+#include "ffmpeg_vid_dec_memory_budget.h"
+#include "ffmpeg_vid_dec_nal.h"
+#include "ffmpeg_vid_dec_parameter_sets.h"
+#include "ffmpeg_vid_dec_picture_info.h"
+#include "ffmpeg_vid_dec_picture_queue.h"
+#include "ffmpeg_vid_dec_queue.h"
+#include "ffmpeg_vid_dec_thread_pool.h"
 #include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/time.h>
+
+#define OPTION_ENV_PREFIX "DVPD_FFMPEG_"
+
+#ifdef AVC_CODEC
+#define PLUGIN_NAL_CODEC NAL_CODEC_AVC
+#else
+#define PLUGIN_NAL_CODEC NAL_CODEC_HEVC
+#endif
+
+#ifndef AV_CODEC_FLAG2_FAST
+#define AV_CODEC_FLAG2_FAST CODEC_FLAG2_FAST
+#endif
+
+#ifndef AV_CODEC_FLAG_LOW_DELAY
+#define AV_CODEC_FLAG_LOW_DELAY CODEC_FLAG_LOW_DELAY
+#endif
+
+#define ASYNC_SUPPORTED ( LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101) )
+
+#define MAX_HOST_INPUT_BUFFERS 8
+
+#define MAX_BATCH_PACKETS 16
+
+#define MAX_LAYER_GROUP_KEY 64
+
+#define MAX_HASH_LOG_PATH 1024
+
+// longest an access unit is held back for the process memory budget
+#define MEMORY_BUDGET_WAIT_MS 200
+
+// decoded picture buffer of a picture of the maximum size of its level, assumed when the decoder does not report one
+#define ESTIMATED_DPB_PICTURES 6
+
+// the decoding speed is measured over at least a second of the stream
+#define SPEED_WINDOW_SECONDS 1
+#define SPEED_WINDOW_MIN_FRAMES 8
 
 typedef void* ffmpeg_vid_dec_handle;
 
+typedef enum
+{
+	PICTURE_OWNERSHIP_BORROWED = 0,
+	PICTURE_OWNERSHIP_OWNED
+} picture_ownership_t;
+
+typedef enum
+{
+	INPUT_ACCESS_UNIT = 0,
+	INPUT_STREAM
+} input_t;
+
+typedef enum
+{
+	THREAD_TYPE_DEFAULT = 0,
+	THREAD_TYPE_FRAME,
+	THREAD_TYPE_SLICE,
+	THREAD_TYPE_AUTO
+} thread_type_t;
+
+// ordered by the number of skipped pictures
+typedef enum
+{
+	DECODE_MODE_ALL = 0,
+	DECODE_MODE_REFERENCE,
+	DECODE_MODE_KEY
+} decode_mode_t;
+
+typedef enum
+{
+	QUALITY_FULL = 0,
+	QUALITY_PREVIEW,
+	QUALITY_DRAFT
+} quality_t;
+
+typedef enum
+{
+	RESYNC_OFF = 0,
+	RESYNC_KEY
+} resync_t;
+
 typedef struct ffmpeg_vid_dec_ctx_s_
 {
 	const AVCodec *codec;
@@ -53,335 +152,3297 @@ typedef struct ffmpeg_vid_dec_ctx_s_
 	AVFrame *frame;
 
 	bool init;
+	bool codec_open;
+	codec_config_t codec_config;
+	parameter_sets_t parameter_sets;
+	int32_t context_pool_size;
+	int64_t init_time;
+	bool first_picture;
 
 	on_decoded_picture_cb_func_t on_decoded_picture;
 	void* app_data;
 	int32_t layer;
+	int32_t receive_queue_depth;
+	picture_queue_t *picture_queue;
+
+	picture_ownership_t picture_ownership;
+	input_t input;
+	au_splitter_t *au_splitter;
+
+	thread_type_t thread_type;
+	int32_t threads;
+	bool thread_pool_shared;
+	thread_pool_t *thread_pool;
+	bool low_latency;
+	volatile int32_t latency_frames;
+	int32_t memory_limit;
+	int32_t memory_budget;
+	memory_budget_client_t *memory_budget_client;
+	int32_t memory_frame_threads;
+	int32_t memory_frame_threads_applied;
+	bool memory_warned;
+	bool memory_giving_way;
+
+	bool adaptive_threads;
+	int32_t headroom;
+	AVRational frame_rate;
+	int32_t adaptive_thread_count;
+	int32_t adaptive_thread_count_applied;
+	int64_t speed_frames;
+	int64_t speed_time;
+	volatile int32_t speed_percent;
+	volatile int32_t threads_in_effect;
+	bool pacing;
+	int64_t pacing_start;
+	int64_t pacing_units;
+
+	placement_t placement;
+	placement_t placement_resolved;
+	placement_t placement_applied;
+
+	bool frame_pool_enabled;
+	int32_t frame_pool_alignment;
+	frame_pool_hugepages_t frame_pool_hugepages;
+	frame_pool_t *frame_pool;
+
+	bool input_arena_enabled;
+	input_arena_t *input_arena;
+	AVBufferRef *host_input_buffers[ MAX_HOST_INPUT_BUFFERS ];
+
+	bool async;
+	int32_t async_queue_depth;
+	bool worker_running;
+	vid_dec_thread_t worker;
+	work_queue_t queue;
+	volatile int32_t discarding;
+	vid_dec_mutex_t control_mutex;
+	vid_dec_cond_t control_done;
+	int64_t control_requested;
+	int64_t control_completed;
+
+	int32_t gop_parallel;
+	gop_decoder_t *gop_decoder;
+
+	bool dual_layer;
+	char layer_group_key[ MAX_LAYER_GROUP_KEY ];
+	int32_t layer_window;
+	layer_group_t *layer_group;
+
+	convert_isa_t simd;
+	format_converter_t *format_converter;
+	AVFrame *converted_frame;
+	picture_info_pool_t *picture_info_pool;
+	int32_t dropped_format;
+	int32_t picture_format;
+	int32_t picture_width;
+	int32_t picture_height;
+	uint32_t format_generation;
+	bool format_change;
+
+	bool hash;
+	char hash_log_path[ MAX_HASH_LOG_PATH ];
+	const hash_kernels_t *hash_kernels;
+	FILE *hash_log;
+	int64_t hash_pictures;
+	int64_t hash_time;
+
+	dec_stats_t stats;
+	int64_t callback_time;
+
+	volatile int32_t decode_mode_requested;
+	decode_mode_t decode_mode;
+	volatile int32_t quality_requested;
+	quality_t quality;
+
+	volatile int32_t resync;
+	bool decode_error;
+	bool resyncing;
+	bool resync_key;
+	bool resync_recovered;
+	int64_t resync_start;
+	int64_t resync_dropped;
 } ffmpeg_vid_dec_ctx_t;
 
-static int get_cpu_count() {
-	int i_num_cores = 1;
-#if defined(_WIN32)
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo( &sysinfo );
-	i_num_cores = sysinfo.dwNumberOfProcessors;
-#else
-	i_num_cores = (int)sysconf( _SC_NPROCESSORS_ONLN );
+typedef struct
+{
+	const char *name;
+	int32_t value;
+} option_value_t;
+
+typedef struct
+{
+	const char *name;
+	bool runtime;
+	bool( *set ) ( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value );
+} option_t;
+
+static const option_value_t bool_values[] =
+{
+	{ "on", 1 },
+	{ "off", 0 },
+	{ "true", 1 },
+	{ "false", 0 },
+	{ "1", 1 },
+	{ "0", 0 },
+	{ NULL, 0 }
+};
+
+static const option_value_t picture_ownership_values[] =
+{
+	{ "borrowed", PICTURE_OWNERSHIP_BORROWED },
+	{ "owned", PICTURE_OWNERSHIP_OWNED },
+	{ NULL, 0 }
+};
+
+static const option_value_t input_values[] =
+{
+	{ "access_unit", INPUT_ACCESS_UNIT },
+	{ "stream", INPUT_STREAM },
+	{ NULL, 0 }
+};
+
+static const option_value_t thread_type_values[] =
+{
+	{ "default", THREAD_TYPE_DEFAULT },
+	{ "frame", THREAD_TYPE_FRAME },
+	{ "slice", THREAD_TYPE_SLICE },
+	{ "auto", THREAD_TYPE_AUTO },
+	{ NULL, 0 }
+};
+
+static const option_value_t thread_pool_values[] =
+{
+	{ "instance", 0 },
+	{ "shared", 1 },
+	{ NULL, 0 }
+};
+
+static const option_value_t frame_pool_hugepages_values[] =
+{
+	{ "off", FRAME_POOL_HUGEPAGES_OFF },
+	{ "thp", FRAME_POOL_HUGEPAGES_THP },
+	{ "hugetlb", FRAME_POOL_HUGEPAGES_HUGETLB },
+	{ NULL, 0 }
+};
+
+static const option_value_t decode_mode_values[] =
+{
+	{ "all", DECODE_MODE_ALL },
+	{ "reference", DECODE_MODE_REFERENCE },
+	{ "key", DECODE_MODE_KEY },
+	{ NULL, 0 }
+};
+
+static const enum AVDiscard decode_mode_discard[] =
+{
+	AVDISCARD_DEFAULT,
+	AVDISCARD_NONREF,
+	AVDISCARD_NONKEY
+};
+
+static const option_value_t quality_values[] =
+{
+	{ "full", QUALITY_FULL },
+	{ "preview", QUALITY_PREVIEW },
+	{ "draft", QUALITY_DRAFT },
+	{ NULL, 0 }
+};
+
+static const option_value_t resync_values[] =
+{
+	{ "off", RESYNC_OFF },
+	{ "key", RESYNC_KEY },
+	{ NULL, 0 }
+};
+
+// CONVERT_ISA_COUNT selects the best instruction set of the CPU
+static const option_value_t simd_values[] =
+{
+	{ "auto", CONVERT_ISA_COUNT },
+	{ "avx512", CONVERT_ISA_AVX512 },
+	{ "avx2", CONVERT_ISA_AVX2 },
+	{ "sse4", CONVERT_ISA_SSE41 },
+	{ "c", CONVERT_ISA_C },
+	{ NULL, 0 }
+};
+
+static bool parse_option_value( const option_value_t* values, const char* value, int32_t* result )
+{
+	for( ; values->name != NULL; values++ )
+	{
+		if( strcmp( values->name, value ) == 0 )
+		{
+			*result = values->value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool parse_int_value( const char* value, int32_t min, int32_t max, int32_t* result )
+{
+	char* end = NULL;
+	long parsed = strtol( value, &end, 10 );
+
+	if( end == value || *end != '\0' || parsed < min || parsed > max )
+	{
+		return false;
+	}
+
+	*result = ( int32_t )parsed;
+
+	return true;
+}
+
+static bool set_picture_ownership( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t ownership;
+
+	if( parse_option_value( picture_ownership_values, value, &ownership ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->picture_ownership = ( picture_ownership_t )ownership;
+
+	return true;
+}
+
+static bool set_thread_type( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t thread_type;
+
+	if( parse_option_value( thread_type_values, value, &thread_type ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->thread_type = ( thread_type_t )thread_type;
+
+	return true;
+}
+
+static bool set_threads( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 0, 1024, &ffmpeg_vid_dec_ctx->threads );
+}
+
+static bool set_thread_pool( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t shared;
+
+	if( parse_option_value( thread_pool_values, value, &shared ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->thread_pool_shared = ( shared != 0 );
+
+	return true;
+}
+
+static bool set_low_latency( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->low_latency = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_cpuset( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	placement_t placement;
+
+	if( PLACEMENT_SUPPORTED == 0 || placement_parse_cpus( value, &placement ) == false )
+	{
+		return false;
+	}
+
+	memcpy( ffmpeg_vid_dec_ctx->placement.cpus, placement.cpus, sizeof( placement.cpus ) );
+
+	return true;
+}
+
+static bool set_numa_node( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	placement_t placement;
+	int32_t node;
+
+	if( parse_int_value( value, -1, PLACEMENT_MAX_NODES - 1, &node ) == false )
+	{
+		return false;
+	}
+
+	placement_init( &placement );
+	if( node >= 0 && placement_set_numa_node( node, &placement ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->placement.numa_node = node;
+
+	return true;
+}
+
+static bool set_input( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t input;
+
+	if( parse_option_value( input_values, value, &input ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->input = ( input_t )input;
+
+	return true;
+}
+
+static bool set_adaptive_threads( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->adaptive_threads = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_headroom( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 0, 1000, &ffmpeg_vid_dec_ctx->headroom );
+}
+
+static bool set_frame_rate( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	char* end = NULL;
+	long num = strtol( value, &end, 10 );
+	long den = 1;
+
+	if( end == value || num < 0 || num > INT32_MAX )
+	{
+		return false;
+	}
+
+	if( *end == '/' )
+	{
+		const char* start = end + 1;
+
+		den = strtol( start, &end, 10 );
+		if( end == start || den < 1 || den > INT32_MAX )
+		{
+			return false;
+		}
+	}
+
+	if( *end != '\0' )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->frame_rate.num = ( int )num;
+	ffmpeg_vid_dec_ctx->frame_rate.den = ( int )den;
+
+	return true;
+}
+
+static bool set_pacing( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->pacing = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_memory_limit( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 0, 1024 * 1024, &ffmpeg_vid_dec_ctx->memory_limit );
+}
+
+static bool set_memory_budget( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 0, 16 * 1024 * 1024, &ffmpeg_vid_dec_ctx->memory_budget );
+}
+
+static bool set_context_pool( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 0, 64, &ffmpeg_vid_dec_ctx->context_pool_size );
+}
+
+static bool set_async( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+#if !ASYNC_SUPPORTED
+	if( enabled != 0 )
+	{
+		return false;
+	}
 #endif
-	if (i_num_cores < 1)
+
+	ffmpeg_vid_dec_ctx->async = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_async_queue_depth( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 1, 1024, &ffmpeg_vid_dec_ctx->async_queue_depth );
+}
+
+static bool set_receive_queue_depth( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 1, 1024, &ffmpeg_vid_dec_ctx->receive_queue_depth );
+}
+
+static bool set_gop_parallel( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t segments;
+
+	if( parse_int_value( value, 0, 16, &segments ) == false )
 	{
-		i_num_cores = 1;
+		return false;
+	}
+
+#if !GOP_DECODER_SUPPORTED
+	if( segments != 0 )
+	{
+		return false;
+	}
+#endif
+
+	ffmpeg_vid_dec_ctx->gop_parallel = segments;
+
+	return true;
+}
+
+static bool set_dual_layer( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+#if !ASYNC_SUPPORTED
+	if( enabled != 0 )
+	{
+		return false;
+	}
+#endif
+
+	ffmpeg_vid_dec_ctx->dual_layer = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_layer_group( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	if( strlen( value ) >= MAX_LAYER_GROUP_KEY )
+	{
+		return false;
+	}
+
+	strcpy( ffmpeg_vid_dec_ctx->layer_group_key, value );
+
+	return true;
+}
+
+static bool set_layer_window( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	return parse_int_value( value, 1, 256, &ffmpeg_vid_dec_ctx->layer_window );
+}
+
+static bool set_input_arena( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->input_arena_enabled = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_frame_pool( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->frame_pool_enabled = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_frame_pool_alignment( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t alignment;
+
+	if( parse_int_value( value, 16, 1 << 21, &alignment ) == false || ( alignment & ( alignment - 1 ) ) != 0 )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->frame_pool_alignment = alignment;
+
+	return true;
+}
+
+static bool set_frame_pool_hugepages( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t hugepages;
+
+	if( parse_option_value( frame_pool_hugepages_values, value, &hugepages ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->frame_pool_hugepages = ( frame_pool_hugepages_t )hugepages;
+
+	return true;
+}
+
+static bool set_simd( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t simd;
+
+	if( parse_option_value( simd_values, value, &simd ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->simd = ( convert_isa_t )simd;
+
+	return true;
+}
+
+static bool set_decode_mode( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t decode_mode;
+
+	if( parse_option_value( decode_mode_values, value, &decode_mode ) == false )
+	{
+		return false;
+	}
+
+	// applied by the decoding thread
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->decode_mode_requested, decode_mode );
+
+	return true;
+}
+
+static bool set_hash( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t enabled;
+
+	if( parse_option_value( bool_values, value, &enabled ) == false )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->hash = ( enabled != 0 );
+
+	return true;
+}
+
+static bool set_hash_log( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	if( strlen( value ) >= MAX_HASH_LOG_PATH )
+	{
+		return false;
+	}
+
+	strcpy( ffmpeg_vid_dec_ctx->hash_log_path, value );
+
+	return true;
+}
+
+static bool set_resync( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t resync;
+
+	if( parse_option_value( resync_values, value, &resync ) == false )
+	{
+		return false;
+	}
+
+	// applied by the decoding thread
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->resync, resync );
+
+	return true;
+}
+
+static bool set_quality( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const char* value )
+{
+	int32_t quality;
+
+	if( parse_option_value( quality_values, value, &quality ) == false )
+	{
+		return false;
+	}
+
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->quality_requested, quality );
+
+	return true;
+}
+
+static const option_t options[] =
+{
+	{ FFMPEG_VID_DEC_OPT_PICTURE_OWNERSHIP, false, set_picture_ownership },
+	{ FFMPEG_VID_DEC_OPT_THREAD_TYPE, false, set_thread_type },
+	{ FFMPEG_VID_DEC_OPT_THREADS, false, set_threads },
+	{ FFMPEG_VID_DEC_OPT_THREAD_POOL, false, set_thread_pool },
+	{ FFMPEG_VID_DEC_OPT_CONTEXT_POOL, false, set_context_pool },
+	{ FFMPEG_VID_DEC_OPT_LOW_LATENCY, false, set_low_latency },
+	{ FFMPEG_VID_DEC_OPT_CPUSET, false, set_cpuset },
+	{ FFMPEG_VID_DEC_OPT_NUMA_NODE, false, set_numa_node },
+	{ FFMPEG_VID_DEC_OPT_MEMORY_LIMIT, false, set_memory_limit },
+	{ FFMPEG_VID_DEC_OPT_MEMORY_BUDGET, false, set_memory_budget },
+	{ FFMPEG_VID_DEC_OPT_ADAPTIVE_THREADS, false, set_adaptive_threads },
+	{ FFMPEG_VID_DEC_OPT_HEADROOM, false, set_headroom },
+	{ FFMPEG_VID_DEC_OPT_FRAME_RATE, false, set_frame_rate },
+	{ FFMPEG_VID_DEC_OPT_PACING, false, set_pacing },
+	{ FFMPEG_VID_DEC_OPT_ASYNC, false, set_async },
+	{ FFMPEG_VID_DEC_OPT_ASYNC_QUEUE_DEPTH, false, set_async_queue_depth },
+	{ FFMPEG_VID_DEC_OPT_RECEIVE_QUEUE_DEPTH, false, set_receive_queue_depth },
+	{ FFMPEG_VID_DEC_OPT_DUAL_LAYER, false, set_dual_layer },
+	{ FFMPEG_VID_DEC_OPT_LAYER_GROUP, false, set_layer_group },
+	{ FFMPEG_VID_DEC_OPT_LAYER_WINDOW, false, set_layer_window },
+	{ FFMPEG_VID_DEC_OPT_FRAME_POOL, false, set_frame_pool },
+	{ FFMPEG_VID_DEC_OPT_FRAME_POOL_ALIGNMENT, false, set_frame_pool_alignment },
+	{ FFMPEG_VID_DEC_OPT_FRAME_POOL_HUGEPAGES, false, set_frame_pool_hugepages },
+	{ FFMPEG_VID_DEC_OPT_INPUT_ARENA, false, set_input_arena },
+	{ FFMPEG_VID_DEC_OPT_SIMD, false, set_simd },
+	{ FFMPEG_VID_DEC_OPT_DECODE_MODE, true, set_decode_mode },
+	{ FFMPEG_VID_DEC_OPT_RESYNC, true, set_resync },
+	{ FFMPEG_VID_DEC_OPT_QUALITY, true, set_quality },
+	{ FFMPEG_VID_DEC_OPT_INPUT, false, set_input },
+	{ FFMPEG_VID_DEC_OPT_GOP_PARALLEL, false, set_gop_parallel },
+	{ FFMPEG_VID_DEC_OPT_HASH, false, set_hash },
+	{ FFMPEG_VID_DEC_OPT_HASH_LOG, false, set_hash_log },
+	{ NULL, false, NULL }
+};
+
+static void apply_env_options( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	for( const option_t* option = options; option->name != NULL; option++ )
+	{
+		char env_name[ 64 ] = OPTION_ENV_PREFIX;
+		size_t len = strlen( env_name );
+		const char* value;
+
+		for( const char* c = option->name; *c != '\0' && len < sizeof( env_name ) - 1; c++ )
+		{
+			env_name[ len++ ] = ( char )toupper( ( unsigned char )*c );
+		}
+		env_name[ len ] = '\0';
+
+		value = getenv( env_name );
+		if( value != NULL )
+		{
+			option->set( ffmpeg_vid_dec_ctx, value );
+		}
+	}
+}
+
+static int get_online_cpu_count() {
+	int i_num_cores = 1;
+#if defined(_WIN32)
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo( &sysinfo );
+	i_num_cores = sysinfo.dwNumberOfProcessors;
+#else
+	i_num_cores = (int)sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+	if (i_num_cores < 1)
+	{
+		i_num_cores = 1;
+	}
+
+	return i_num_cores;
+}
+
+static int get_cpu_count() {
+	int i_num_cores = get_online_cpu_count( );
+
+	if (i_num_cores > 16)
+	{
+		i_num_cores = 16;
+	}
+
+	return i_num_cores;
+}
+
+/*
+ * the host owns the pictures if it asked for it or receives them with receive_picture.
+ */
+static bool owns_pictures( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	return ffmpeg_vid_dec_ctx->picture_ownership == PICTURE_OWNERSHIP_OWNED || ffmpeg_vid_dec_ctx->picture_queue != NULL;
+}
+
+#if FRAME_POOL_SUPPORTED
+static int ffmpeg_vid_dec_get_buffer2( AVCodecContext* av_codec_ctx, AVFrame* frame, int flags )
+{
+	return frame_pool_get_buffer( ( frame_pool_t* )av_codec_ctx->opaque, av_codec_ctx, frame, flags );
+}
+#endif
+
+static void configure_codec( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const uint8_t* data, uint32_t size, codec_config_t* config )
+{
+	thread_type_t thread_type = ffmpeg_vid_dec_ctx->thread_type;
+	int32_t threads = ffmpeg_vid_dec_ctx->threads;
+	nal_layout_t layout;
+
+	memset( config, 0, sizeof( codec_config_t ) );
+	config->codec_id = ffmpeg_vid_dec_ctx->codec->id;
+
+	config->placement = ffmpeg_vid_dec_ctx->placement_resolved;
+
+	if( threads == 0 && placement_has_cpus( &config->placement ) == true )
+	{
+		threads = placement_cpu_count( &config->placement );
+		if( threads > 16 )
+		{
+			threads = 16;
+		}
+	}
+	else if( threads == 0 )
+	{
+		threads = get_cpu_count( );
+	}
+
+	ffmpeg_vid_dec_ctx->adaptive_thread_count_applied = ffmpeg_vid_dec_ctx->adaptive_thread_count;
+	if( ffmpeg_vid_dec_ctx->adaptive_thread_count > 0 )
+	{
+		threads = ffmpeg_vid_dec_ctx->adaptive_thread_count;
+	}
+
+	// frame threading delays the output by a picture per thread
+	if( ffmpeg_vid_dec_ctx->low_latency == true )
+	{
+		thread_type = THREAD_TYPE_SLICE;
+		config->flags |= AV_CODEC_FLAG_LOW_DELAY;
+	}
+
+	memset( &layout, 0, sizeof( nal_layout_t ) );
+	if( thread_type == THREAD_TYPE_AUTO || ffmpeg_vid_dec_ctx->thread_pool != NULL )
+	{
+		nal_parse_layout( PLUGIN_NAL_CODEC, data, size, &layout );
+		av_log( NULL, AV_LOG_VERBOSE, "stream layout: %d slices, wpp %d, tiles %d\n", layout.slices, layout.wpp, layout.tiles );
+	}
+
+	// only the jobs of slice threading go through the execute callbacks, a picture of a single slice is a single job
+	if( ffmpeg_vid_dec_ctx->thread_pool != NULL && ( layout.wpp == true || layout.tiles == true || layout.slices > 1 ) )
+	{
+		thread_type = THREAD_TYPE_SLICE;
+		config->thread_pool = 1;
+	}
+
+	if( thread_type == THREAD_TYPE_AUTO )
+	{
+		// slice threading pays off when every picture offers enough independent work for all threads
+		if( layout.wpp == true || layout.tiles == true || layout.slices >= threads )
+		{
+			thread_type = THREAD_TYPE_SLICE;
+		}
+		else
+		{
+			thread_type = THREAD_TYPE_FRAME;
+		}
+	}
+
+	// fewer frame threads hold fewer frames in flight, slice threading holds none
+	ffmpeg_vid_dec_ctx->memory_frame_threads_applied = ffmpeg_vid_dec_ctx->memory_frame_threads;
+	if( ffmpeg_vid_dec_ctx->memory_frame_threads == 1 )
+	{
+		thread_type = THREAD_TYPE_SLICE;
+	}
+	else if( ffmpeg_vid_dec_ctx->memory_frame_threads > 1 && thread_type != THREAD_TYPE_SLICE && threads > ffmpeg_vid_dec_ctx->memory_frame_threads )
+	{
+		threads = ffmpeg_vid_dec_ctx->memory_frame_threads;
+	}
+
+	config->thread_count = threads;
+
+	switch( thread_type )
+	{
+	case THREAD_TYPE_FRAME:
+		config->thread_type = FF_THREAD_FRAME;
+		break;
+	case THREAD_TYPE_SLICE:
+		config->thread_type = FF_THREAD_SLICE;
+		break;
+	default:
+		break;
+	}
+
+	if( vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->quality_requested ) == QUALITY_DRAFT && ffmpeg_vid_dec_ctx->codec->max_lowres > 0 )
+	{
+		config->lowres = 1;
+	}
+
+#if FRAME_POOL_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->frame_pool_enabled == true && ( ffmpeg_vid_dec_ctx->codec->capabilities & AV_CODEC_CAP_DR1 ) != 0 )
+	{
+		config->frame_pool_alignment = ffmpeg_vid_dec_ctx->frame_pool_alignment;
+		config->frame_pool_hugepages = ffmpeg_vid_dec_ctx->frame_pool_hugepages;
+	}
+#endif
+}
+
+static bool create_codec( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const codec_config_t* config, pooled_codec_t* codec )
+{
+	AVCodecContext* av_codec_ctx;
+
+	memset( codec, 0, sizeof( pooled_codec_t ) );
+
+	av_codec_ctx = avcodec_alloc_context3( ffmpeg_vid_dec_ctx->codec );
+	if( av_codec_ctx == NULL )
+	{
+		return false;
+	}
+	codec->av_codec_ctx = av_codec_ctx;
+
+	av_codec_ctx->thread_count = config->thread_count;
+	av_codec_ctx->lowres = config->lowres;
+	av_codec_ctx->flags |= config->flags;
+	if( config->thread_type != 0 )
+	{
+		av_codec_ctx->thread_type = config->thread_type;
+	}
+
+#if FRAME_POOL_SUPPORTED
+	if( config->frame_pool_alignment != 0 )
+	{
+		codec->frame_pool = frame_pool_create( config->frame_pool_alignment, ( frame_pool_hugepages_t )config->frame_pool_hugepages, config->placement.numa_node );
+		if( codec->frame_pool == NULL )
+		{
+			goto bail;
+		}
+
+		// the frame pool stays with the context when it is pooled
+		av_codec_ctx->opaque = codec->frame_pool;
+		av_codec_ctx->get_buffer2 = ffmpeg_vid_dec_get_buffer2;
+#if ( LIBAVCODEC_VERSION_MAJOR < 59 )
+		av_codec_ctx->thread_safe_callbacks = 1;
+#endif
+	}
+#endif
+
+	if( avcodec_open2( av_codec_ctx, ffmpeg_vid_dec_ctx->codec, NULL ) < 0 )
+	{
+		goto bail;
+	}
+
+	// the slice threads of libavcodec stay idle while the shared pool runs the jobs
+	if( config->thread_pool != 0 && ( av_codec_ctx->active_thread_type & FF_THREAD_SLICE ) != 0 )
+	{
+		av_codec_ctx->execute = thread_pool_execute;
+		av_codec_ctx->execute2 = thread_pool_execute2;
+	}
+
+	return true;
+
+bail:
+	avcodec_free_context( &codec->av_codec_ctx );
+#if FRAME_POOL_SUPPORTED
+	frame_pool_release( &codec->frame_pool );
+#endif
+
+	return false;
+}
+
+/*
+ * publishes the current output delay of the decoder for FFMPEG_VID_DEC_INFO_LATENCY_FRAMES.
+ */
+static void update_latency( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	AVCodecContext* av_codec_ctx = ffmpeg_vid_dec_ctx->av_codec_ctx;
+	int32_t latency = av_codec_ctx->has_b_frames;
+
+	if( ( av_codec_ctx->active_thread_type & FF_THREAD_FRAME ) != 0 && av_codec_ctx->thread_count > 1 )
+	{
+		latency += av_codec_ctx->thread_count - 1;
+	}
+
+	if( latency != ffmpeg_vid_dec_ctx->latency_frames )
+	{
+		vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->latency_frames, latency );
+	}
+}
+
+static bool open_codec( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const uint8_t* data, uint32_t size )
+{
+	int64_t start = av_gettime_relative( );
+	pooled_codec_t codec;
+	bool pooled = false;
+
+	placement_t previous;
+	bool bound = false;
+	bool opened;
+
+	configure_codec( ffmpeg_vid_dec_ctx, data, size, &ffmpeg_vid_dec_ctx->codec_config );
+
+	// the threads of libavcodec inherit the CPUs of the thread opening the decoder
+	placement_init( &ffmpeg_vid_dec_ctx->placement_applied );
+	if( placement_has_cpus( &ffmpeg_vid_dec_ctx->placement_resolved ) == true )
+	{
+		bound = placement_bind_thread( &ffmpeg_vid_dec_ctx->placement_resolved, &previous );
+		if( bound == true )
+		{
+			placement_get_thread( &ffmpeg_vid_dec_ctx->placement_applied );
+		}
+		else
+		{
+			av_log( NULL, AV_LOG_WARNING, "could not bind the decoding threads to the requested CPUs\n" );
+		}
+	}
+
+	if( ffmpeg_vid_dec_ctx->context_pool_size > 0 )
+	{
+		pooled = context_pool_take( &ffmpeg_vid_dec_ctx->codec_config, &codec );
+	}
+
+	opened = pooled || create_codec( ffmpeg_vid_dec_ctx, &ffmpeg_vid_dec_ctx->codec_config, &codec );
+
+	if( bound == true )
+	{
+		placement_bind_thread( &previous, NULL );
+	}
+
+	if( opened == false )
+	{
+		return false;
+	}
+
+#if FRAME_POOL_SUPPORTED
+	if( codec.frame_pool != NULL )
+	{
+		ffmpeg_vid_dec_ctx->placement_applied.numa_node = ffmpeg_vid_dec_ctx->placement_resolved.numa_node;
+	}
+#endif
+
+	ffmpeg_vid_dec_ctx->av_codec_ctx = codec.av_codec_ctx;
+	ffmpeg_vid_dec_ctx->frame_pool = codec.frame_pool;
+
+	// a pooled context keeps the decode mode, quality and frame rate of its previous instance
+	ffmpeg_vid_dec_ctx->av_codec_ctx->framerate.num = 0;
+	ffmpeg_vid_dec_ctx->av_codec_ctx->framerate.den = 1;
+	ffmpeg_vid_dec_ctx->av_codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+	ffmpeg_vid_dec_ctx->av_codec_ctx->skip_loop_filter = AVDISCARD_DEFAULT;
+	ffmpeg_vid_dec_ctx->av_codec_ctx->flags2 &= ~AV_CODEC_FLAG2_FAST;
+	ffmpeg_vid_dec_ctx->decode_mode = DECODE_MODE_ALL;
+	ffmpeg_vid_dec_ctx->quality = QUALITY_FULL;
+
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	ffmpeg_vid_dec_ctx->av_codec_ctx->refcounted_frames = owns_pictures( ffmpeg_vid_dec_ctx ) ? 1 : 0;
+#endif
+
+	av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "threading: %d threads, type %d\n",
+		ffmpeg_vid_dec_ctx->av_codec_ctx->thread_count, ffmpeg_vid_dec_ctx->av_codec_ctx->active_thread_type );
+	av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "decoder opened in %lld us (%s context)\n",
+		( long long )( av_gettime_relative( ) - start ), pooled ? "pooled" : "new" );
+
+	ffmpeg_vid_dec_ctx->codec_open = true;
+
+	update_latency( ffmpeg_vid_dec_ctx );
+
+	// the speed of the previous thread count does not apply
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->threads_in_effect, ffmpeg_vid_dec_ctx->av_codec_ctx->thread_count );
+	ffmpeg_vid_dec_ctx->speed_frames = 0;
+	ffmpeg_vid_dec_ctx->speed_time = 0;
+
+	return true;
+}
+
+/*
+ * returns the context to the pool or frees it.
+ */
+static void release_codec( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, bool reuse )
+{
+	if( ffmpeg_vid_dec_ctx->codec_open == true && ffmpeg_vid_dec_ctx->context_pool_size > 0 && reuse == true )
+	{
+		pooled_codec_t codec;
+
+		avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
+
+		codec.av_codec_ctx = ffmpeg_vid_dec_ctx->av_codec_ctx;
+		codec.frame_pool = ffmpeg_vid_dec_ctx->frame_pool;
+		ffmpeg_vid_dec_ctx->av_codec_ctx = NULL;
+		ffmpeg_vid_dec_ctx->frame_pool = NULL;
+
+		context_pool_put( &ffmpeg_vid_dec_ctx->codec_config, &codec, ffmpeg_vid_dec_ctx->context_pool_size );
+	}
+
+	avcodec_free_context( &ffmpeg_vid_dec_ctx->av_codec_ctx );
+#if FRAME_POOL_SUPPORTED
+	frame_pool_release( &ffmpeg_vid_dec_ctx->frame_pool );
+#endif
+	ffmpeg_vid_dec_ctx->codec_open = false;
+}
+
+#if FRAME_POOL_SUPPORTED
+static void log_frame_pool_stats( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	frame_pool_stats_t stats;
+
+	frame_pool_get_stats( ffmpeg_vid_dec_ctx->frame_pool, &stats );
+
+	av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "frame pool: %lld requests, %lld fallbacks, %lld allocations (%lld huge page backed, %lld node local), %lld bytes peak, %lld reconfigurations (%lld size classes reused)\n",
+		( long long )stats.requests, ( long long )stats.fallbacks, ( long long )stats.allocations, ( long long )stats.huge_page_allocations,
+		( long long )stats.node_allocations, ( long long )stats.peak_bytes, ( long long )stats.reconfigurations, ( long long )stats.reused_classes );
+}
+#endif
+
+static void log_context_pool_stats( void )
+{
+	context_pool_stats_t stats;
+
+	context_pool_get_stats( &stats );
+
+	av_log( NULL, AV_LOG_VERBOSE, "context pool: %lld hits, %lld misses, %lld evictions, %d idle\n",
+		( long long )stats.hits, ( long long )stats.misses, ( long long )stats.evictions, stats.idle );
+}
+
+static void decode( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVPacket* avpkt );
+static void drain( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx );
+
+/*
+ * the stream continues at a new position after a flush, which restarts the pacing schedule and ends a resync.
+ */
+static void restart_stream( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	ffmpeg_vid_dec_ctx->pacing_units = 0;
+	ffmpeg_vid_dec_ctx->decode_error = false;
+	ffmpeg_vid_dec_ctx->resyncing = false;
+	ffmpeg_vid_dec_ctx->resync_key = false;
+	ffmpeg_vid_dec_ctx->resync_recovered = false;
+}
+static void output_frame( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const picture_sequence_t* sequence );
+
+#if INPUT_ARENA_SUPPORTED
+static void release_host_input_buffers( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	for( int32_t i = 0; i < MAX_HOST_INPUT_BUFFERS; i++ )
+	{
+		av_buffer_unref( &ffmpeg_vid_dec_ctx->host_input_buffers[ i ] );
+	}
+}
+
+static AVBufferRef* take_host_input_buffer( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const uint8_t* data, uint32_t size )
+{
+	for( int32_t i = 0; i < MAX_HOST_INPUT_BUFFERS; i++ )
+	{
+		AVBufferRef* buffer = ffmpeg_vid_dec_ctx->host_input_buffers[ i ];
+
+		if( buffer != NULL && data >= buffer->data && data + size + AV_INPUT_BUFFER_PADDING_SIZE <= buffer->data + buffer->size )
+		{
+			ffmpeg_vid_dec_ctx->host_input_buffers[ i ] = NULL;
+			return buffer;
+		}
+	}
+
+	return NULL;
+}
+#endif
+
+/*
+ * fills pkt with the access unit. Returns false if pkt does not own a copy of the data.
+ */
+static bool prepare_packet( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVPacket* pkt, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	bool owned = false;
+
+	pkt->pts = pts;
+	pkt->dts = dts;
+	pkt->size = size;
+
+#if INPUT_ARENA_SUPPORTED
+	pkt->buf = take_host_input_buffer( ffmpeg_vid_dec_ctx, data, size );
+	if( pkt->buf == NULL && ffmpeg_vid_dec_ctx->input_arena != NULL )
+	{
+		pkt->buf = input_arena_get( ffmpeg_vid_dec_ctx->input_arena, size );
+		if( pkt->buf != NULL )
+		{
+			memcpy( pkt->buf->data, data, size );
+			data = pkt->buf->data;
+		}
+	}
+
+	if( pkt->buf != NULL )
+	{
+		memset( data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE );
+		owned = true;
+	}
+#endif
+
+	pkt->data = data;
+
+	return owned;
+}
+
+/*
+ * opens the decoder unless it is open, the first access unit selects the decoder configuration.
+ */
+static bool open_decoder( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const uint8_t* data, uint32_t size )
+{
+	if( ffmpeg_vid_dec_ctx->codec_open == false )
+	{
+		if( open_codec( ffmpeg_vid_dec_ctx, data, size ) == false )
+		{
+			av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_ERROR, "could not open the decoder\n" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#if ASYNC_SUPPORTED
+// queue items besides packets
+static uint8_t async_drain_marker;
+static uint8_t async_discard_marker;
+static uint8_t async_stop_marker;
+
+static void complete_control( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	vid_dec_mutex_lock( &ffmpeg_vid_dec_ctx->control_mutex );
+	ffmpeg_vid_dec_ctx->control_completed++;
+	vid_dec_cond_broadcast( &ffmpeg_vid_dec_ctx->control_done );
+	vid_dec_mutex_unlock( &ffmpeg_vid_dec_ctx->control_mutex );
+}
+
+static void run_control( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, void* marker )
+{
+	int64_t request = ++ffmpeg_vid_dec_ctx->control_requested;
+
+	work_queue_push( &ffmpeg_vid_dec_ctx->queue, marker );
+
+	vid_dec_mutex_lock( &ffmpeg_vid_dec_ctx->control_mutex );
+	while( ffmpeg_vid_dec_ctx->control_completed < request )
+	{
+		vid_dec_cond_wait( &ffmpeg_vid_dec_ctx->control_done, &ffmpeg_vid_dec_ctx->control_mutex );
+	}
+	vid_dec_mutex_unlock( &ffmpeg_vid_dec_ctx->control_mutex );
+}
+
+static VID_DEC_THREAD_FUNC( async_worker, arg )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )arg;
+
+	if( placement_has_cpus( &ffmpeg_vid_dec_ctx->placement_resolved ) == true )
+	{
+		placement_bind_thread( &ffmpeg_vid_dec_ctx->placement_resolved, NULL );
+	}
+
+	while( 1 )
+	{
+		void* item = work_queue_pop( &ffmpeg_vid_dec_ctx->queue );
+
+		if( item == &async_stop_marker )
+		{
+			break;
+		}
+		else if( item == &async_drain_marker )
+		{
+			drain( ffmpeg_vid_dec_ctx );
+			if( ffmpeg_vid_dec_ctx->codec_open == true )
+			{
+				avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
+			}
+			restart_stream( ffmpeg_vid_dec_ctx );
+			complete_control( ffmpeg_vid_dec_ctx );
+		}
+		else if( item == &async_discard_marker )
+		{
+			// the decoder may not have been opened yet when the worker is stopped
+			if( ffmpeg_vid_dec_ctx->codec_open == true )
+			{
+				avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
+			}
+			vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->discarding, 0 );
+			restart_stream( ffmpeg_vid_dec_ctx );
+			complete_control( ffmpeg_vid_dec_ctx );
+		}
+		else
+		{
+			AVPacket* pkt = ( AVPacket* )item;
+
+			// packets queued before a discarding flush are dropped without decoding
+			if( vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->discarding ) == 0 )
+			{
+				if( open_decoder( ffmpeg_vid_dec_ctx, pkt->data, pkt->size ) == true )
+				{
+					decode( ffmpeg_vid_dec_ctx, pkt );
+				}
+			}
+			else
+			{
+				dec_stats_add( &ffmpeg_vid_dec_ctx->stats.packets_discarded, 1 );
+			}
+			av_packet_free( &pkt );
+		}
+	}
+
+	return VID_DEC_THREAD_EXIT;
+}
+
+static bool start_async_worker( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	if( work_queue_init( &ffmpeg_vid_dec_ctx->queue, ffmpeg_vid_dec_ctx->async_queue_depth ) == false )
+	{
+		return false;
+	}
+
+	vid_dec_mutex_init( &ffmpeg_vid_dec_ctx->control_mutex );
+	vid_dec_cond_init( &ffmpeg_vid_dec_ctx->control_done );
+	ffmpeg_vid_dec_ctx->control_requested = 0;
+	ffmpeg_vid_dec_ctx->control_completed = 0;
+	ffmpeg_vid_dec_ctx->discarding = 0;
+
+	if( vid_dec_thread_create( &ffmpeg_vid_dec_ctx->worker, async_worker, ffmpeg_vid_dec_ctx ) == false )
+	{
+		vid_dec_cond_destroy( &ffmpeg_vid_dec_ctx->control_done );
+		vid_dec_mutex_destroy( &ffmpeg_vid_dec_ctx->control_mutex );
+		work_queue_uninit( &ffmpeg_vid_dec_ctx->queue );
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->worker_running = true;
+
+	return true;
+}
+
+static void stop_async_worker( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	if( ffmpeg_vid_dec_ctx->worker_running == false )
+	{
+		return;
+	}
+
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->discarding, 1 );
+	run_control( ffmpeg_vid_dec_ctx, &async_discard_marker );
+
+	work_queue_push( &ffmpeg_vid_dec_ctx->queue, &async_stop_marker );
+	vid_dec_thread_join( ffmpeg_vid_dec_ctx->worker );
+
+	vid_dec_cond_destroy( &ffmpeg_vid_dec_ctx->control_done );
+	vid_dec_mutex_destroy( &ffmpeg_vid_dec_ctx->control_mutex );
+	work_queue_uninit( &ffmpeg_vid_dec_ctx->queue );
+
+	ffmpeg_vid_dec_ctx->worker_running = false;
+}
+#endif
+
+#if GOP_DECODER_SUPPORTED
+static bool open_gop_codec( void* opaque, pooled_codec_t* codec )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )opaque;
+	codec_config_t config;
+	placement_t previous;
+	bool bound = false;
+	bool opened;
+
+	configure_codec( ffmpeg_vid_dec_ctx, NULL, 0, &config );
+
+	// the segments in flight share the threads of the instance
+	config.thread_count /= ffmpeg_vid_dec_ctx->gop_parallel;
+	if( config.thread_count < 1 )
+	{
+		config.thread_count = 1;
+	}
+
+	if( placement_has_cpus( &ffmpeg_vid_dec_ctx->placement_resolved ) == true )
+	{
+		bound = placement_bind_thread( &ffmpeg_vid_dec_ctx->placement_resolved, &previous );
+	}
+
+	opened = create_codec( ffmpeg_vid_dec_ctx, &config, codec );
+
+	if( bound == true )
+	{
+		placement_bind_thread( &previous, NULL );
+	}
+
+	return opened;
+}
+
+static void output_gop_frame( void* opaque, AVFrame* frame, const picture_sequence_t* sequence )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )opaque;
+
+	// a borrowed picture of the previous frame is returned
+	av_frame_unref( ffmpeg_vid_dec_ctx->frame );
+	av_frame_move_ref( ffmpeg_vid_dec_ctx->frame, frame );
+
+	output_frame( ffmpeg_vid_dec_ctx, sequence );
+}
+#endif
+
+static void close_hash_log( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	if( ffmpeg_vid_dec_ctx->hash_log != NULL )
+	{
+		fclose( ffmpeg_vid_dec_ctx->hash_log );
+		ffmpeg_vid_dec_ctx->hash_log = NULL;
+	}
+}
+
+static void release_queued_picture( void* opaque, dvpd_input_dec_picture_t* picture )
+{
+	picture_info_t* info = picture_info_from_app_data( picture->app_specific_data );
+
+	( void )opaque;
+
+	if( info != NULL )
+	{
+		picture_info_release( info );
+	}
+}
+
+static ffmpeg_vid_dec_handle ffmpeg_vid_dec_create( void )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )malloc( sizeof( ffmpeg_vid_dec_ctx_t ) );
+
+	if( ffmpeg_vid_dec_ctx == NULL )
+	{
+		return NULL;
+	}
+
+	memset( ffmpeg_vid_dec_ctx, 0, sizeof( ffmpeg_vid_dec_ctx_t ) );
+
+	ffmpeg_vid_dec_ctx->frame_pool_enabled = true;
+	ffmpeg_vid_dec_ctx->frame_pool_alignment = 64;
+	ffmpeg_vid_dec_ctx->frame_pool_hugepages = FRAME_POOL_HUGEPAGES_OFF;
+	ffmpeg_vid_dec_ctx->async_queue_depth = 8;
+	ffmpeg_vid_dec_ctx->receive_queue_depth = 8;
+	ffmpeg_vid_dec_ctx->context_pool_size = 0;
+	ffmpeg_vid_dec_ctx->headroom = 50;
+	ffmpeg_vid_dec_ctx->layer_window = 32;
+	ffmpeg_vid_dec_ctx->input_arena_enabled = true;
+	ffmpeg_vid_dec_ctx->simd = CONVERT_ISA_COUNT;
+	placement_init( &ffmpeg_vid_dec_ctx->placement );
+	placement_init( &ffmpeg_vid_dec_ctx->placement_resolved );
+	placement_init( &ffmpeg_vid_dec_ctx->placement_applied );
+	ffmpeg_vid_dec_ctx->dropped_format = AV_PIX_FMT_NONE;
+
+	apply_env_options( ffmpeg_vid_dec_ctx );
+
+	return ffmpeg_vid_dec_ctx;
+}
+
+static void ffmpeg_vid_dec_destroy( ffmpeg_vid_dec_handle* h_dec )
+{
+	ffmpeg_vid_dec_ctx_t* ctx = ( ffmpeg_vid_dec_ctx_t* )*h_dec;
+
+	free( ctx );
+	h_dec = NULL;
+}
+
+static bool ffmpeg_vid_dec_init( ffmpeg_vid_dec_handle h_dec, on_decoded_picture_cb_func_t on_decoded_picture, void* app_data, int32_t layer )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+	convert_isa_t isa;
+#if ASYNC_SUPPORTED
+	bool async;
+#endif
+
+	if( ffmpeg_vid_dec_ctx == NULL )
+	{
+		return false;
+	}
+
+	if( ffmpeg_vid_dec_ctx->init == true )
+	{
+		return false;
+	}
+
+	ffmpeg_vid_dec_ctx->on_decoded_picture = on_decoded_picture;
+	ffmpeg_vid_dec_ctx->app_data = app_data;
+	ffmpeg_vid_dec_ctx->layer = layer;
+	ffmpeg_vid_dec_ctx->init_time = av_gettime_relative( );
+
+	// a node without explicit CPUs provides the CPUs of the decoding threads
+	ffmpeg_vid_dec_ctx->placement_resolved = ffmpeg_vid_dec_ctx->placement;
+	if( ffmpeg_vid_dec_ctx->placement.numa_node >= 0 )
+	{
+		placement_set_numa_node( ffmpeg_vid_dec_ctx->placement.numa_node, &ffmpeg_vid_dec_ctx->placement_resolved );
+	}
+
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->latency_frames, 0 );
+	ffmpeg_vid_dec_ctx->memory_frame_threads = 0;
+	ffmpeg_vid_dec_ctx->memory_frame_threads_applied = 0;
+	ffmpeg_vid_dec_ctx->memory_warned = false;
+	ffmpeg_vid_dec_ctx->memory_giving_way = false;
+	ffmpeg_vid_dec_ctx->adaptive_thread_count = 0;
+	ffmpeg_vid_dec_ctx->adaptive_thread_count_applied = 0;
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->speed_percent, 0 );
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->threads_in_effect, 0 );
+	ffmpeg_vid_dec_ctx->first_picture = true;
+	ffmpeg_vid_dec_ctx->picture_format = AV_PIX_FMT_NONE;
+	ffmpeg_vid_dec_ctx->picture_width = 0;
+	ffmpeg_vid_dec_ctx->picture_height = 0;
+	ffmpeg_vid_dec_ctx->format_generation = 0;
+	ffmpeg_vid_dec_ctx->format_change = false;
+	restart_stream( ffmpeg_vid_dec_ctx );
+	dec_stats_reset( &ffmpeg_vid_dec_ctx->stats );
+
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58,9,100) )
+	avcodec_register_all( );
+#endif
+
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	ffmpeg_vid_dec_ctx->pkt = malloc( sizeof( AVPacket ) );
+	if( ffmpeg_vid_dec_ctx->pkt == NULL )
+	{
+		goto bail;
+	}
+#else
+	ffmpeg_vid_dec_ctx->pkt = av_packet_alloc( );
+	if( ffmpeg_vid_dec_ctx->pkt == NULL )
+	{
+		goto bail;
+	}
+#endif
+
+	// without picture callback the host receives the pictures with receive_picture
+	if( on_decoded_picture == NULL )
+	{
+		if( ffmpeg_vid_dec_ctx->dual_layer == true )
+		{
+			av_log( NULL, AV_LOG_ERROR, "dual-layer decoding requires a picture callback\n" );
+			goto bail;
+		}
+
+		ffmpeg_vid_dec_ctx->picture_queue = picture_queue_create( ffmpeg_vid_dec_ctx->receive_queue_depth, release_queued_picture, NULL );
+		if( ffmpeg_vid_dec_ctx->picture_queue == NULL )
+		{
+			goto bail;
+		}
+	}
+
+#ifdef AVC_CODEC
+	ffmpeg_vid_dec_ctx->codec = avcodec_find_decoder( AV_CODEC_ID_H264 );
+#else
+	ffmpeg_vid_dec_ctx->codec = avcodec_find_decoder( AV_CODEC_ID_H265 );
+#endif
+	if( ffmpeg_vid_dec_ctx->codec == NULL )
+	{
+		goto bail;
+	}
+
+	if( ffmpeg_vid_dec_ctx->thread_pool_shared == true )
+	{
+		ffmpeg_vid_dec_ctx->thread_pool = thread_pool_share( get_online_cpu_count( ) );
+		if( ffmpeg_vid_dec_ctx->thread_pool == NULL )
+		{
+			goto bail;
+		}
+	}
+
+	// the segments of the GOP decoder are not accounted
+	if( ffmpeg_vid_dec_ctx->memory_budget > 0 && ffmpeg_vid_dec_ctx->gop_parallel == 0 )
+	{
+		ffmpeg_vid_dec_ctx->memory_budget_client = memory_budget_join( ( int64_t )ffmpeg_vid_dec_ctx->memory_budget * 1024 * 1024 );
+		if( ffmpeg_vid_dec_ctx->memory_budget_client == NULL )
+		{
+			goto bail;
+		}
+	}
+
+	// the automatic thread type and the use of the shared pool depend on the stream layout, the decoder is opened with the first access unit
+	if( ffmpeg_vid_dec_ctx->thread_type != THREAD_TYPE_AUTO && ffmpeg_vid_dec_ctx->thread_pool == NULL && ffmpeg_vid_dec_ctx->gop_parallel == 0 )
+	{
+		if( open_codec( ffmpeg_vid_dec_ctx, NULL, 0 ) == false )
+		{
+			goto bail;
+		}
+	}
+
+	ffmpeg_vid_dec_ctx->frame = av_frame_alloc( );
+	if( ffmpeg_vid_dec_ctx->frame == NULL )
+	{
+		goto bail;
+	}
+
+	ffmpeg_vid_dec_ctx->converted_frame = av_frame_alloc( );
+	if( ffmpeg_vid_dec_ctx->converted_frame == NULL )
+	{
+		goto bail;
+	}
+
+	ffmpeg_vid_dec_ctx->picture_info_pool = picture_info_pool_create( );
+	if( ffmpeg_vid_dec_ctx->picture_info_pool == NULL )
+	{
+		goto bail;
+	}
+
+	if( ffmpeg_vid_dec_ctx->input == INPUT_STREAM )
+	{
+		ffmpeg_vid_dec_ctx->au_splitter = au_splitter_create( PLUGIN_NAL_CODEC );
+		if( ffmpeg_vid_dec_ctx->au_splitter == NULL )
+		{
+			goto bail;
+		}
+	}
+
+	isa = convert_detect_isa( );
+	if( ffmpeg_vid_dec_ctx->simd < isa )
+	{
+		isa = ffmpeg_vid_dec_ctx->simd;
+	}
+
+	ffmpeg_vid_dec_ctx->format_converter = format_converter_create( isa );
+	if( ffmpeg_vid_dec_ctx->format_converter == NULL )
+	{
+		goto bail;
+	}
+
+	av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "format conversion: %s\n", convert_isa_name( isa ) );
+
+	ffmpeg_vid_dec_ctx->hash_kernels = NULL;
+	ffmpeg_vid_dec_ctx->hash_pictures = 0;
+	ffmpeg_vid_dec_ctx->hash_time = 0;
+	if( ffmpeg_vid_dec_ctx->hash == true || ffmpeg_vid_dec_ctx->hash_log_path[ 0 ] != '\0' )
+	{
+		ffmpeg_vid_dec_ctx->hash_kernels = hash_get_kernels( isa );
+	}
+
+	if( ffmpeg_vid_dec_ctx->hash_log_path[ 0 ] != '\0' )
+	{
+		ffmpeg_vid_dec_ctx->hash_log = fopen( ffmpeg_vid_dec_ctx->hash_log_path, "w" );
+		if( ffmpeg_vid_dec_ctx->hash_log == NULL )
+		{
+			av_log( NULL, AV_LOG_ERROR, "cannot create the hash log %s\n", ffmpeg_vid_dec_ctx->hash_log_path );
+			goto bail;
+		}
+
+		fprintf( ffmpeg_vid_dec_ctx->hash_log, "# index pts size format xxh3 per plane\n" );
+	}
+
+#if INPUT_ARENA_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->input_arena_enabled == true )
+	{
+		ffmpeg_vid_dec_ctx->input_arena = input_arena_create( );
+		if( ffmpeg_vid_dec_ctx->input_arena == NULL )
+		{
+			goto bail;
+		}
+	}
+#endif
+
+#if ASYNC_SUPPORTED
+	// the option keeps the value the host set
+	async = ffmpeg_vid_dec_ctx->async;
+#endif
+
+#if GOP_DECODER_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->gop_parallel > 0 )
+	{
+		if( ffmpeg_vid_dec_ctx->dual_layer == true )
+		{
+			av_log( NULL, AV_LOG_ERROR, "GOP parallel decoding does not support dual-layer decoding\n" );
+			goto bail;
+		}
+
+		ffmpeg_vid_dec_ctx->gop_decoder = gop_decoder_create( PLUGIN_NAL_CODEC, ffmpeg_vid_dec_ctx->gop_parallel, open_gop_codec,
+			output_gop_frame, ffmpeg_vid_dec_ctx, &ffmpeg_vid_dec_ctx->stats );
+		if( ffmpeg_vid_dec_ctx->gop_decoder == NULL )
+		{
+			goto bail;
+		}
+
+		// the segments are decoded by the workers of the GOP decoder
+		async = false;
+	}
+#endif
+
+#if ASYNC_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->dual_layer == true )
+	{
+		char key[ MAX_LAYER_GROUP_KEY ];
+
+		// the instances of both layers are initialized with the same app_data unless a group is named
+		if( ffmpeg_vid_dec_ctx->layer_group_key[ 0 ] != '\0' )
+		{
+			strcpy( key, ffmpeg_vid_dec_ctx->layer_group_key );
+		}
+		else
+		{
+			snprintf( key, sizeof( key ), "%p", app_data );
+		}
+
+		ffmpeg_vid_dec_ctx->layer_group = layer_group_join( key, layer, on_decoded_picture, app_data,
+			ffmpeg_vid_dec_ctx->picture_ownership == PICTURE_OWNERSHIP_OWNED, ffmpeg_vid_dec_ctx->layer_window );
+		if( ffmpeg_vid_dec_ctx->layer_group == NULL )
+		{
+			av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_ERROR, "could not join layer %d of layer group %s\n", layer, key );
+			goto bail;
+		}
+
+		// each layer decodes on its own worker thread
+		async = true;
+	}
+
+	if( async == true )
+	{
+		if( start_async_worker( ffmpeg_vid_dec_ctx ) == false )
+		{
+			goto bail;
+		}
+	}
+#endif
+
+	ffmpeg_vid_dec_ctx->init = true;
+
+	return true;
+
+bail:
+	layer_group_leave( &ffmpeg_vid_dec_ctx->layer_group, layer, NULL );
+
+#if GOP_DECODER_SUPPORTED
+	gop_decoder_release( &ffmpeg_vid_dec_ctx->gop_decoder, NULL );
+#endif
+
+	release_codec( ffmpeg_vid_dec_ctx, true );
+	thread_pool_unshare( &ffmpeg_vid_dec_ctx->thread_pool );
+	memory_budget_leave( &ffmpeg_vid_dec_ctx->memory_budget_client );
+	picture_queue_release( &ffmpeg_vid_dec_ctx->picture_queue );
+
+	if( ffmpeg_vid_dec_ctx->frame != NULL )
+	{
+		av_frame_free( &ffmpeg_vid_dec_ctx->frame );
+	}
+
+	if( ffmpeg_vid_dec_ctx->converted_frame != NULL )
+	{
+		av_frame_free( &ffmpeg_vid_dec_ctx->converted_frame );
+	}
+
+	picture_info_pool_release( &ffmpeg_vid_dec_ctx->picture_info_pool );
+	au_splitter_release( &ffmpeg_vid_dec_ctx->au_splitter );
+
+	format_converter_release( &ffmpeg_vid_dec_ctx->format_converter );
+	close_hash_log( ffmpeg_vid_dec_ctx );
+
+#if INPUT_ARENA_SUPPORTED
+	input_arena_release( &ffmpeg_vid_dec_ctx->input_arena );
+#endif
+
+	if( ffmpeg_vid_dec_ctx->pkt != NULL )
+	{
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+		free( ffmpeg_vid_dec_ctx->pkt );
+#else
+		av_packet_free( &ffmpeg_vid_dec_ctx->pkt );
+#endif
+	}
+
+	return false;
+}
+
+static bool ffmpeg_vid_dec_deinit( ffmpeg_vid_dec_handle h_dec )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+
+	if( ffmpeg_vid_dec_ctx == NULL )
+	{
+		return false;
+	}
+
+	if( ffmpeg_vid_dec_ctx->init == false )
+	{
+		return false;
+	}
+
+	// the decoding must not wait for pictures nobody receives anymore
+	if( ffmpeg_vid_dec_ctx->picture_queue != NULL )
+	{
+		picture_queue_discard( ffmpeg_vid_dec_ctx->picture_queue, true );
+	}
+
+#if ASYNC_SUPPORTED
+	stop_async_worker( ffmpeg_vid_dec_ctx );
+#endif
+
+#if GOP_DECODER_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->gop_decoder != NULL )
+	{
+		gop_decoder_stats_t stats;
+
+		gop_decoder_release( &ffmpeg_vid_dec_ctx->gop_decoder, &stats );
+		av_log( NULL, AV_LOG_VERBOSE, "GOP parallel decoding: %lld segments, %lld CRA pictures continuing a segment\n",
+			( long long )stats.segments, ( long long )stats.merged );
+	}
+#endif
+
+	if( ffmpeg_vid_dec_ctx->layer_group != NULL )
+	{
+		layer_group_stats_t stats;
+
+		layer_group_leave( &ffmpeg_vid_dec_ctx->layer_group, ffmpeg_vid_dec_ctx->layer, &stats );
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "layer %d: %lld pictures paired, %lld unpaired\n",
+			ffmpeg_vid_dec_ctx->layer, ( long long )stats.paired, ( long long )stats.unpaired );
+	}
+
+#if FRAME_POOL_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->frame_pool != NULL )
+	{
+		log_frame_pool_stats( ffmpeg_vid_dec_ctx );
+	}
+#endif
+
+	if( ffmpeg_vid_dec_ctx->hash_pictures > 0 )
+	{
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "%lld pictures hashed, %lld us per picture\n",
+			( long long )ffmpeg_vid_dec_ctx->hash_pictures, ( long long )( ffmpeg_vid_dec_ctx->hash_time / ffmpeg_vid_dec_ctx->hash_pictures ) );
+	}
+
+	if( ffmpeg_vid_dec_ctx->stats.frames_skipped > 0 )
+	{
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "%lld pictures skipped by the decode mode, the resync policy or the memory budget\n",
+			( long long )ffmpeg_vid_dec_ctx->stats.frames_skipped );
+	}
+
+	if( ffmpeg_vid_dec_ctx->stats.frames_dropped[ DVPD_INPUT_DEC_DROP_FORMAT ] > 0 )
+	{
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_WARNING, "%lld pictures dropped, output format not supported\n",
+			( long long )ffmpeg_vid_dec_ctx->stats.frames_dropped[ DVPD_INPUT_DEC_DROP_FORMAT ] );
+	}
+
+	release_codec( ffmpeg_vid_dec_ctx, true );
+	thread_pool_unshare( &ffmpeg_vid_dec_ctx->thread_pool );
+	memory_budget_leave( &ffmpeg_vid_dec_ctx->memory_budget_client );
+	picture_queue_release( &ffmpeg_vid_dec_ctx->picture_queue );
+	log_context_pool_stats( );
+	av_frame_free( &ffmpeg_vid_dec_ctx->frame );
+	av_frame_free( &ffmpeg_vid_dec_ctx->converted_frame );
+	picture_info_pool_release( &ffmpeg_vid_dec_ctx->picture_info_pool );
+	au_splitter_release( &ffmpeg_vid_dec_ctx->au_splitter );
+	parameter_sets_clear( &ffmpeg_vid_dec_ctx->parameter_sets );
+	format_converter_release( &ffmpeg_vid_dec_ctx->format_converter );
+	close_hash_log( ffmpeg_vid_dec_ctx );
+#if INPUT_ARENA_SUPPORTED
+	release_host_input_buffers( ffmpeg_vid_dec_ctx );
+	input_arena_release( &ffmpeg_vid_dec_ctx->input_arena );
+#endif
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+		free( ffmpeg_vid_dec_ctx->pkt );
+#else
+		av_packet_free( &ffmpeg_vid_dec_ctx->pkt );
+#endif
+
+	ffmpeg_vid_dec_ctx->init = false;
+
+	return true;
+}
+
+static void drop_picture( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVFrame* frame )
+{
+	if( frame->format != ffmpeg_vid_dec_ctx->dropped_format )
+	{
+		const char* name = av_get_pix_fmt_name( ( enum AVPixelFormat )frame->format );
+
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_WARNING, "output format %s not supported, dropping pictures\n", name ? name : "unknown" );
+		ffmpeg_vid_dec_ctx->dropped_format = frame->format;
+	}
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_dropped[ DVPD_INPUT_DEC_DROP_FORMAT ], 1 );
+	av_frame_unref( frame );
+}
+
+static void deliver_picture( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, dvpd_input_dec_picture_t* picture, picture_info_t* info )
+{
+	int64_t start = av_gettime_relative( );
+	int64_t time;
+
+	if( ffmpeg_vid_dec_ctx->layer_group != NULL )
+	{
+		layer_group_push( ffmpeg_vid_dec_ctx->layer_group, ffmpeg_vid_dec_ctx->layer, picture, info );
+	}
+	else if( ffmpeg_vid_dec_ctx->picture_queue != NULL )
+	{
+		// blocks while the queue is full, a discarding flush drops the picture
+		if( picture_queue_push( ffmpeg_vid_dec_ctx->picture_queue, picture ) == false )
+		{
+			ffmpeg_vid_dec_ctx->callback_time += av_gettime_relative( ) - start;
+			return;
+		}
+	}
+	else
+	{
+		ffmpeg_vid_dec_ctx->on_decoded_picture( picture, ffmpeg_vid_dec_ctx->app_data, ffmpeg_vid_dec_ctx->layer );
+
+		if( ffmpeg_vid_dec_ctx->picture_ownership == PICTURE_OWNERSHIP_BORROWED )
+		{
+			picture_info_release( info );
+		}
+	}
+
+	time = av_gettime_relative( ) - start;
+	ffmpeg_vid_dec_ctx->callback_time += time;
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_out, 1 );
+	dec_stats_add_time( &ffmpeg_vid_dec_ctx->stats.callback_time_us, ffmpeg_vid_dec_ctx->stats.callback_latency, time );
+}
+
+/*
+ * a new sequence parameter set changed the size or pixel format of the decoded pictures. The frame pool and the format
+ * converter adapt on the next buffer, the change is signalled with the next picture delivered.
+ */
+static void check_format( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVFrame* frame )
+{
+	if( frame->format == ffmpeg_vid_dec_ctx->picture_format && frame->width == ffmpeg_vid_dec_ctx->picture_width &&
+		frame->height == ffmpeg_vid_dec_ctx->picture_height )
+	{
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->picture_format != AV_PIX_FMT_NONE )
+	{
+		const char* from = av_get_pix_fmt_name( ( enum AVPixelFormat )ffmpeg_vid_dec_ctx->picture_format );
+		const char* to = av_get_pix_fmt_name( ( enum AVPixelFormat )frame->format );
+
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "format change from %dx%d %s to %dx%d %s\n",
+			ffmpeg_vid_dec_ctx->picture_width, ffmpeg_vid_dec_ctx->picture_height, from != NULL ? from : "unknown",
+			frame->width, frame->height, to != NULL ? to : "unknown" );
+
+		ffmpeg_vid_dec_ctx->format_generation++;
+		ffmpeg_vid_dec_ctx->format_change = true;
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.format_changes, 1 );
+	}
+
+	ffmpeg_vid_dec_ctx->picture_format = frame->format;
+	ffmpeg_vid_dec_ctx->picture_width = frame->width;
+	ffmpeg_vid_dec_ctx->picture_height = frame->height;
+}
+
+/*
+ * hashes the visible rows of every plane of the decoded frame and writes the hashes to the hash log. Returns the
+ * number of planes, 0 for formats without planes in memory.
+ */
+static int32_t hash_frame( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVFrame* frame, uint64_t plane_hash[ 4 ] )
+{
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get( ( enum AVPixelFormat )frame->format );
+	int64_t start = av_gettime_relative( );
+	int linesize[ 4 ];
+	int32_t planes = 0;
+
+	if( desc == NULL || ( desc->flags & ( AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL ) ) != 0 ||
+		av_image_fill_linesizes( linesize, ( enum AVPixelFormat )frame->format, frame->width ) < 0 )
+	{
+		return 0;
+	}
+
+	for( int32_t i = 0; i < desc->nb_components; i++ )
+	{
+		planes = FFMAX( planes, desc->comp[ i ].plane + 1 );
+	}
+
+	// linesize is the size of the visible part of a row
+	for( int32_t i = 0; i < planes; i++ )
+	{
+		int32_t log2_chroma_h = ( i == 1 || i == 2 ) ? desc->log2_chroma_h : 0;
+		int32_t rows = ( frame->height + ( 1 << log2_chroma_h ) - 1 ) >> log2_chroma_h;
+
+		plane_hash[ i ] = hash_plane( ffmpeg_vid_dec_ctx->hash_kernels, frame->data[ i ], frame->linesize[ i ], ( size_t )linesize[ i ], rows );
+	}
+
+	if( ffmpeg_vid_dec_ctx->hash_log != NULL )
+	{
+		fprintf( ffmpeg_vid_dec_ctx->hash_log, "%lld %lld %dx%d %s", ( long long )ffmpeg_vid_dec_ctx->hash_pictures,
+			( long long )frame->best_effort_timestamp, frame->width, frame->height, desc->name );
+		for( int32_t i = 0; i < planes; i++ )
+		{
+			fprintf( ffmpeg_vid_dec_ctx->hash_log, " %016llx", ( unsigned long long )plane_hash[ i ] );
+		}
+		fprintf( ffmpeg_vid_dec_ctx->hash_log, "\n" );
+	}
+
+	ffmpeg_vid_dec_ctx->hash_pictures++;
+	ffmpeg_vid_dec_ctx->hash_time += av_gettime_relative( ) - start;
+
+	return planes;
+}
+
+/*
+ * converts the decoded frame of the instance and delivers it as picture.
+ */
+static void output_frame( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const picture_sequence_t* sequence )
+{
+	dvpd_input_dec_picture_t output_picture = {0};
+	AVFrame* frame;
+	picture_info_t* info;
+	uint64_t plane_hash[ 4 ];
+	int32_t hash_planes = 0;
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_decoded, 1 );
+
+	check_format( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->frame );
+
+	if( ffmpeg_vid_dec_ctx->hash_kernels != NULL )
+	{
+		hash_planes = hash_frame( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->frame, plane_hash );
+	}
+
+	frame = format_converter_map( ffmpeg_vid_dec_ctx->format_converter, ffmpeg_vid_dec_ctx->frame, ffmpeg_vid_dec_ctx->converted_frame, &output_picture.bit_depth );
+	if( frame == NULL )
+	{
+		// later frames must still be received from the decoder
+		drop_picture( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->frame );
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->first_picture == true )
+	{
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "first picture %lld us after init\n",
+			( long long )( av_gettime_relative( ) - ffmpeg_vid_dec_ctx->init_time ) );
+		ffmpeg_vid_dec_ctx->first_picture = false;
+	}
+
+	for( int32_t i = 0; i < 3; i++ )
+	{
+		output_picture.data[ i ] = frame->data[ i ];
+		output_picture.stride[ i ] = frame->linesize[ i ];
+	}
+	output_picture.width = frame->width;
+	output_picture.height = frame->height;
+	output_picture.dts = frame->pkt_dts;
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	output_picture.pts = frame->pkt_pts;
+#else
+	output_picture.pts = frame->pts;
+
+	// access units split from a stream may have no presentation timestamp
+	if( ffmpeg_vid_dec_ctx->au_splitter != NULL && frame->pts == AV_NOPTS_VALUE )
+	{
+		output_picture.pts = frame->best_effort_timestamp;
+	}
+#endif
+
+	info = picture_info_take( ffmpeg_vid_dec_ctx->picture_info_pool, frame, sequence );
+	if( info == NULL )
+	{
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_dropped[ DVPD_INPUT_DEC_DROP_MEMORY ], 1 );
+		av_frame_unref( frame );
+		return;
+	}
+	output_picture.app_specific_data = &info->info;
+	info->info.format_change = ffmpeg_vid_dec_ctx->format_change == true ? 1 : 0;
+	info->info.format_generation = ffmpeg_vid_dec_ctx->format_generation;
+	ffmpeg_vid_dec_ctx->format_change = false;
+
+	if( hash_planes > 0 )
+	{
+		memcpy( info->info.plane_hash, plane_hash, hash_planes * sizeof( uint64_t ) );
+		info->info.hash_planes = ( uint32_t )hash_planes;
+		info->info.flags |= FFMPEG_VID_DEC_PICTURE_INFO_HASH;
+	}
+
+	// the picture keeps the reference of the decoded frame, the plane pointers stay the same
+	if( owns_pictures( ffmpeg_vid_dec_ctx ) == true || ffmpeg_vid_dec_ctx->layer_group != NULL )
+	{
+		if( picture_info_hold( info, frame ) == false )
+		{
+			dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_dropped[ DVPD_INPUT_DEC_DROP_MEMORY ], 1 );
+			av_frame_unref( frame );
+			picture_info_release( info );
+			return;
+		}
+	}
+
+	// decided per picture, release_picture may be called after the instance was deinitialized
+	info->owned = owns_pictures( ffmpeg_vid_dec_ctx );
+
+	deliver_picture( ffmpeg_vid_dec_ctx, &output_picture, info );
+}
+
+/*
+ * a picture with concealed errors or missing references.
+ */
+static bool is_corrupt( const AVFrame* frame )
+{
+#ifdef AV_FRAME_FLAG_CORRUPT
+	if( ( frame->flags & AV_FRAME_FLAG_CORRUPT ) != 0 )
+	{
+		return true;
+	}
+#endif
+
+	return frame->decode_error_flags != 0;
+}
+
+static void decode_packet( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVPacket* avpkt )
+{
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	while( 1 )
+	{
+		picture_sequence_t sequence;
+		int got_picture = 0;
+
+		int32_t ret = avcodec_decode_video2( ffmpeg_vid_dec_ctx->av_codec_ctx, ffmpeg_vid_dec_ctx->frame, &got_picture, avpkt );
+		if( ret < 0 )
+		{
+			dec_stats_add( &ffmpeg_vid_dec_ctx->stats.send_errors, 1 );
+			av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "error decoding a packet: %s\n", av_err2str( ret ) );
+			ffmpeg_vid_dec_ctx->decode_error = true;
+			return;
+		}
+
+		avpkt->size -= ret;
+		avpkt->data += ret;
+
+		if( ret > 0 )
+		{
+			dec_stats_add( &ffmpeg_vid_dec_ctx->stats.bytes_decoded, ret );
+			if( avpkt->size == 0 )
+			{
+				dec_stats_add( &ffmpeg_vid_dec_ctx->stats.packets_decoded, 1 );
+			}
+		}
+
+		if( avpkt->size == 0 && got_picture == 0 )
+		{
+			return;
+		}
+
+		if( got_picture == 0 )
+		{
+			continue;
+		}
+#else
+	int32_t ret = avcodec_send_packet( ffmpeg_vid_dec_ctx->av_codec_ctx, avpkt );
+	if( ret < 0 )
+	{
+		// a repeated drain is answered with AVERROR_EOF
+		if( avpkt != NULL )
+		{
+			dec_stats_add( &ffmpeg_vid_dec_ctx->stats.send_errors, 1 );
+			av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "error sending a packet for decoding: %s\n", av_err2str( ret ) );
+			ffmpeg_vid_dec_ctx->decode_error = true;
+		}
+		return;
+	}
+
+	if( avpkt != NULL )
+	{
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.packets_decoded, 1 );
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.bytes_decoded, avpkt->size );
+	}
+
+	while( ret >= 0 )
+	{
+		picture_sequence_t sequence;
+
+		ret = avcodec_receive_frame( ffmpeg_vid_dec_ctx->av_codec_ctx, ffmpeg_vid_dec_ctx->frame );
+		if( ret == AVERROR( EAGAIN ) || ret == AVERROR_EOF )
+		{
+			return;
+		}
+		else if( ret < 0 )
+		{
+			dec_stats_add( &ffmpeg_vid_dec_ctx->stats.receive_errors, 1 );
+			av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_VERBOSE, "error during decoding: %s\n", av_err2str( ret ) );
+			ffmpeg_vid_dec_ctx->decode_error = true;
+			return;
+		}
+#endif
+
+		if( is_corrupt( ffmpeg_vid_dec_ctx->frame ) == true )
+		{
+			// pictures after an AVC recovery point are corrupt until the recovery is complete
+			if( ffmpeg_vid_dec_ctx->resync_key == false )
+			{
+				ffmpeg_vid_dec_ctx->decode_error = true;
+			}
+
+			// the resync policy does not output concealed pictures
+			if( vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->resync ) != RESYNC_OFF )
+			{
+				dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_decoded, 1 );
+				dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_skipped, 1 );
+				av_frame_unref( ffmpeg_vid_dec_ctx->frame );
+				continue;
+			}
+		}
+		else if( ffmpeg_vid_dec_ctx->resync_key == true )
+		{
+			ffmpeg_vid_dec_ctx->resync_recovered = true;
+		}
+
+		picture_sequence_read( &sequence, ffmpeg_vid_dec_ctx->av_codec_ctx );
+		output_frame( ffmpeg_vid_dec_ctx, &sequence );
+	}
+
+	return;
+}
+
+static void apply_quality( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, quality_t quality )
+{
+	AVCodecContext* av_codec_ctx = ffmpeg_vid_dec_ctx->av_codec_ctx;
+
+	if( quality == QUALITY_FULL )
+	{
+		av_codec_ctx->skip_loop_filter = AVDISCARD_DEFAULT;
+		av_codec_ctx->flags2 &= ~AV_CODEC_FLAG2_FAST;
+	}
+	else
+	{
+		av_codec_ctx->skip_loop_filter = AVDISCARD_ALL;
+		av_codec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+	}
+
+	ffmpeg_vid_dec_ctx->quality = quality;
+
+	av_log( av_codec_ctx, AV_LOG_VERBOSE, "quality %s%s\n", quality_values[ quality ].name, av_codec_ctx->lowres > 0 ? ", lowres" : "" );
+}
+
+static int32_t get_frame_threads( AVCodecContext* av_codec_ctx )
+{
+	if( ( av_codec_ctx->active_thread_type & FF_THREAD_FRAME ) != 0 && av_codec_ctx->thread_count > 1 )
+	{
+		return av_codec_ctx->thread_count;
+	}
+
+	return 1;
+}
+
+/*
+ * estimates the frame buffers of the decoder without the frame pool: the decoded picture buffer and a picture in
+ * flight per frame thread.
+ */
+static int64_t estimate_frame_memory( const AVCodecContext* av_codec_ctx, int32_t frame_threads )
+{
+	int64_t pictures = ESTIMATED_DPB_PICTURES;
+	int32_t picture_bytes;
+
+	if( av_codec_ctx->pix_fmt == AV_PIX_FMT_NONE )
+	{
+		return 0;
+	}
+
+	picture_bytes = av_image_get_buffer_size( av_codec_ctx->pix_fmt, av_codec_ctx->width, av_codec_ctx->height, 1 );
+	if( picture_bytes <= 0 )
+	{
+		return 0;
+	}
+
+	if( av_codec_ctx->refs > 0 )
+	{
+		pictures = av_codec_ctx->refs + av_codec_ctx->has_b_frames;
+	}
+
+	return ( pictures + frame_threads ) * picture_bytes;
+}
+
+/*
+ * accounts the memory of the instance and plans fewer frame threads if it exceeds the memory limit, or the process
+ * exceeds the memory budget and the instance has to give way.
+ */
+static void update_memory( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	AVCodecContext* av_codec_ctx = ffmpeg_vid_dec_ctx->av_codec_ctx;
+	int32_t frame_threads = get_frame_threads( av_codec_ctx );
+	int64_t frames = -1;
+	int64_t packets = 0;
+	int64_t threads;
+	int64_t total;
+	int64_t limit;
+	const char* exceeded = NULL;
+
+#if FRAME_POOL_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->frame_pool != NULL )
+	{
+		frame_pool_stats_t stats;
+
+		frame_pool_get_stats( ffmpeg_vid_dec_ctx->frame_pool, &stats );
+		frames = stats.bytes;
+	}
+#endif
+
+	if( frames < 0 )
+	{
+		frames = estimate_frame_memory( av_codec_ctx, frame_threads );
+	}
+
+#if INPUT_ARENA_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->input_arena != NULL )
+	{
+		input_arena_stats_t stats;
+
+		input_arena_get_stats( ffmpeg_vid_dec_ctx->input_arena, &stats );
+		packets = stats.bytes;
+	}
+#endif
+
+	// every frame thread owns a copy of the per picture tables of the decoder
+	threads = ( int64_t )frame_threads * av_codec_ctx->width * av_codec_ctx->height;
+	total = frames + packets + threads;
+
+	vid_dec_atomic_store64( &ffmpeg_vid_dec_ctx->stats.memory_frames, frames );
+	vid_dec_atomic_store64( &ffmpeg_vid_dec_ctx->stats.memory_packets, packets );
+	vid_dec_atomic_store64( &ffmpeg_vid_dec_ctx->stats.memory_threads, threads );
+	if( total > ffmpeg_vid_dec_ctx->stats.memory_peak_bytes )
+	{
+		vid_dec_atomic_store64( &ffmpeg_vid_dec_ctx->stats.memory_peak_bytes, total );
+	}
+
+	limit = ( int64_t )ffmpeg_vid_dec_ctx->memory_limit * 1024 * 1024;
+	if( limit > 0 && total > limit )
+	{
+		exceeded = "the memory limit";
+	}
+
+	if( ffmpeg_vid_dec_ctx->memory_budget_client != NULL )
+	{
+		memory_budget_update( ffmpeg_vid_dec_ctx->memory_budget_client, total,
+			vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->quality_requested ) != QUALITY_FULL );
+
+		if( memory_budget_exceeded( ffmpeg_vid_dec_ctx->memory_budget_client ) == true )
+		{
+			int64_t share = memory_budget_share( ffmpeg_vid_dec_ctx->memory_budget_client );
+
+			// the instance gives way down to its share of the budget unless its own limit is lower
+			if( limit == 0 || share < limit )
+			{
+				limit = share;
+			}
+			if( exceeded == NULL )
+			{
+				exceeded = "the memory budget of the process";
+			}
+		}
+	}
+
+	if( exceeded == NULL || ffmpeg_vid_dec_ctx->memory_frame_threads != ffmpeg_vid_dec_ctx->memory_frame_threads_applied )
+	{
+		return;
+	}
+
+	if( frame_threads > 1 )
+	{
+		int32_t reduced = ( int32_t )( frame_threads * limit / total );
+
+		if( reduced >= frame_threads )
+		{
+			reduced = frame_threads - 1;
+		}
+		if( reduced < 1 )
+		{
+			reduced = 1;
+		}
+
+		ffmpeg_vid_dec_ctx->memory_frame_threads = reduced;
+
+		av_log( av_codec_ctx, AV_LOG_INFO, "%lld bytes exceed %s, %s at the next IDR picture\n", ( long long )total, exceeded,
+			reduced > 1 ? "reducing the frame threads" : "switching to slice threading" );
+	}
+	else if( ffmpeg_vid_dec_ctx->memory_warned == false )
+	{
+		av_log( av_codec_ctx, AV_LOG_WARNING, "%lld bytes exceed %s, no further reduction possible\n", ( long long )total, exceeded );
+		ffmpeg_vid_dec_ctx->memory_warned = true;
+	}
+}
+
+/*
+ * feeds the parameter sets of the stream so far to a reopened decoder, the stream may not repeat them.
+ */
+static void replay_parameter_sets( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	int32_t size;
+	uint8_t* data = parameter_sets_write( &ffmpeg_vid_dec_ctx->parameter_sets, &size );
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	AVPacket pkt;
+	int got_picture = 0;
+
+	if( data == NULL )
+	{
+		return;
+	}
+
+	av_init_packet( &pkt );
+	pkt.data = data;
+	pkt.size = size;
+	avcodec_decode_video2( ffmpeg_vid_dec_ctx->av_codec_ctx, ffmpeg_vid_dec_ctx->frame, &got_picture, &pkt );
+	av_free( data );
+#else
+	AVPacket* pkt;
+
+	if( data == NULL )
+	{
+		return;
+	}
+
+	pkt = av_packet_alloc( );
+	if( pkt == NULL || av_packet_from_data( pkt, data, size ) < 0 )
+	{
+		av_packet_free( &pkt );
+		av_free( data );
+		return;
+	}
+
+	avcodec_send_packet( ffmpeg_vid_dec_ctx->av_codec_ctx, pkt );
+	av_packet_free( &pkt );
+#endif
+}
+
+/*
+ * outputs the pictures of the current decoder and opens a new one for the IDR or BLA picture in avpkt.
+ */
+static bool reopen_codec( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVPacket* avpkt )
+{
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	AVPacket flush_pkt;
+
+	// the packet of the instance may be the one being decoded
+	av_init_packet( &flush_pkt );
+	flush_pkt.data = NULL;
+	flush_pkt.size = 0;
+	decode_packet( ffmpeg_vid_dec_ctx, &flush_pkt );
+#else
+	decode_packet( ffmpeg_vid_dec_ctx, NULL );
+#endif
+
+	// a context of the abandoned configuration is not worth pooling, its frame pool is released with it
+	release_codec( ffmpeg_vid_dec_ctx, false );
+
+	if( open_codec( ffmpeg_vid_dec_ctx, avpkt->data, avpkt->size ) == false )
+	{
+		av_log( NULL, AV_LOG_ERROR, "could not reopen the decoder\n" );
+		return false;
+	}
+
+	replay_parameter_sets( ffmpeg_vid_dec_ctx );
+
+	return true;
+}
+
+/*
+ * applies a requested decode mode and quality, and counts the access units the decoder is going to skip.
+ */
+static void update_decode_settings( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVPacket* avpkt )
+{
+	decode_mode_t requested = ( decode_mode_t )vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->decode_mode_requested );
+	quality_t quality = ( quality_t )vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->quality_requested );
+	nal_picture_kind_t kind;
+
+	// the decoder is only reopened with a memory ceiling or adaptive threads
+	if( ffmpeg_vid_dec_ctx->memory_limit > 0 || ffmpeg_vid_dec_ctx->memory_budget_client != NULL || ffmpeg_vid_dec_ctx->adaptive_threads == true )
+	{
+		parameter_sets_store_access_unit( &ffmpeg_vid_dec_ctx->parameter_sets, PLUGIN_NAL_CODEC, avpkt->data, avpkt->size );
+	}
+
+	if( requested == DECODE_MODE_ALL && ffmpeg_vid_dec_ctx->decode_mode == DECODE_MODE_ALL && quality == ffmpeg_vid_dec_ctx->quality &&
+		ffmpeg_vid_dec_ctx->memory_frame_threads == ffmpeg_vid_dec_ctx->memory_frame_threads_applied &&
+		ffmpeg_vid_dec_ctx->adaptive_thread_count == ffmpeg_vid_dec_ctx->adaptive_thread_count_applied )
+	{
+		return;
+	}
+
+	kind = nal_classify_picture( PLUGIN_NAL_CODEC, avpkt->data, avpkt->size );
+
+	// a new decoder starts with default decode mode and quality, which are applied below. it would drop the leading
+	// pictures of a CRA picture and output the pictures after an AVC recovery point before they are correct
+	if( ( ffmpeg_vid_dec_ctx->memory_frame_threads != ffmpeg_vid_dec_ctx->memory_frame_threads_applied ||
+		ffmpeg_vid_dec_ctx->adaptive_thread_count != ffmpeg_vid_dec_ctx->adaptive_thread_count_applied ) && kind == NAL_PICTURE_KEY &&
+		nal_is_idr( PLUGIN_NAL_CODEC, nal_first_vcl_type( PLUGIN_NAL_CODEC, avpkt->data, avpkt->size ) ) == true )
+	{
+		// without a decoder, decode drops the packet
+		if( reopen_codec( ffmpeg_vid_dec_ctx, avpkt ) == false )
+		{
+			return;
+		}
+	}
+
+	// a quality change in the middle of a GOP would leave a mix of filtered and unfiltered references
+	if( quality != ffmpeg_vid_dec_ctx->quality && kind == NAL_PICTURE_KEY )
+	{
+		apply_quality( ffmpeg_vid_dec_ctx, quality );
+	}
+
+	// skipped pictures may be references of the following ones, so decoding more pictures has to start at a key picture
+	if( requested != ffmpeg_vid_dec_ctx->decode_mode && ( requested > ffmpeg_vid_dec_ctx->decode_mode || kind == NAL_PICTURE_KEY ) )
+	{
+		ffmpeg_vid_dec_ctx->decode_mode = requested;
+		ffmpeg_vid_dec_ctx->av_codec_ctx->skip_frame = decode_mode_discard[ requested ];
+	}
+
+	if( ( ffmpeg_vid_dec_ctx->decode_mode == DECODE_MODE_KEY && ( kind == NAL_PICTURE_REFERENCE || kind == NAL_PICTURE_NON_REFERENCE ) ) ||
+		( ffmpeg_vid_dec_ctx->decode_mode == DECODE_MODE_REFERENCE && kind == NAL_PICTURE_NON_REFERENCE ) )
+	{
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_skipped, 1 );
+	}
+}
+
+static bool get_frame_rate( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVRational* rate )
+{
+	*rate = ffmpeg_vid_dec_ctx->frame_rate;
+
+	// the timing information of the stream, unless the frame rate is set
+	if( rate->num <= 0 && ffmpeg_vid_dec_ctx->codec_open == true )
+	{
+		*rate = ffmpeg_vid_dec_ctx->av_codec_ctx->framerate;
+	}
+
+	return rate->num > 0 && rate->den > 0;
+}
+
+/*
+ * measures the decoding speed relative to real time and plans the thread count that keeps the headroom.
+ */
+static void update_speed( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, int64_t frames, int64_t time )
+{
+	int64_t target = 100 + ffmpeg_vid_dec_ctx->headroom;
+	int32_t max_threads = get_cpu_count( );
+	int32_t threads;
+	int32_t wanted;
+	AVRational rate;
+	int64_t speed;
+
+	ffmpeg_vid_dec_ctx->speed_frames += frames;
+	ffmpeg_vid_dec_ctx->speed_time += time;
+
+	if( ffmpeg_vid_dec_ctx->codec_open == false || get_frame_rate( ffmpeg_vid_dec_ctx, &rate ) == false ||
+		ffmpeg_vid_dec_ctx->speed_frames < SPEED_WINDOW_MIN_FRAMES ||
+		ffmpeg_vid_dec_ctx->speed_frames * rate.den < ( int64_t )SPEED_WINDOW_SECONDS * rate.num || ffmpeg_vid_dec_ctx->speed_time <= 0 )
+	{
+		return;
+	}
+
+	// pictures per second of decoding time in percent of the pictures per second of the stream
+	speed = ffmpeg_vid_dec_ctx->speed_frames * 100 * 1000000LL * rate.den / ( ffmpeg_vid_dec_ctx->speed_time * rate.num );
+	if( speed < 1 )
+	{
+		speed = 1;
+	}
+	else if( speed > INT32_MAX )
+	{
+		speed = INT32_MAX;
+	}
+
+	vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->speed_percent, ( int32_t )speed );
+	ffmpeg_vid_dec_ctx->speed_frames = 0;
+	ffmpeg_vid_dec_ctx->speed_time = 0;
+
+	if( ffmpeg_vid_dec_ctx->adaptive_threads == false || ffmpeg_vid_dec_ctx->adaptive_thread_count != ffmpeg_vid_dec_ctx->adaptive_thread_count_applied )
+	{
+		return;
+	}
+
+	threads = ffmpeg_vid_dec_ctx->av_codec_ctx->thread_count;
+	if( ffmpeg_vid_dec_ctx->threads > max_threads )
+	{
+		max_threads = ffmpeg_vid_dec_ctx->threads;
+	}
+
+	// assumes the speed scales with the threads
+	wanted = ( int32_t )( ( threads * target + speed - 1 ) / speed );
+	if( wanted < 1 )
+	{
+		wanted = 1;
+	}
+	else if( wanted > max_threads )
+	{
+		wanted = max_threads;
+	}
+
+	// fewer threads only if the decoder is more than twice as fast as needed, which keeps it from oscillating
+	if( ( speed < target && wanted > threads ) || ( speed > 2 * target && wanted < threads ) )
+	{
+		ffmpeg_vid_dec_ctx->adaptive_thread_count = wanted;
+
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_INFO, "decoding at %lld%% of real time with %d threads, %d threads from the next IDR picture\n",
+			( long long )speed, threads, wanted );
+	}
+}
+
+/*
+ * holds the access unit back until its picture is due in real time, less the pictures the decoder holds.
+ */
+static void pace( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	int64_t now = av_gettime_relative( );
+	AVRational rate;
+	int64_t due;
+
+	if( get_frame_rate( ffmpeg_vid_dec_ctx, &rate ) == false )
+	{
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->pacing_units == 0 )
+	{
+		ffmpeg_vid_dec_ctx->pacing_start = now;
+	}
+
+	due = ffmpeg_vid_dec_ctx->pacing_start +
+		( ffmpeg_vid_dec_ctx->pacing_units - ffmpeg_vid_dec_ctx->latency_frames - 1 ) * 1000000LL * rate.den / rate.num;
+	ffmpeg_vid_dec_ctx->pacing_units++;
+
+	if( due > now )
+	{
+		av_usleep( ( unsigned )( due - now ) );
+	}
+	else if( now - due > 1000000 )
+	{
+		// a decoder falling behind by more than a second restarts the schedule instead of catching up
+		ffmpeg_vid_dec_ctx->pacing_start += now - due;
+	}
+}
+
+/*
+ * flushes the decoder after a decoding error, the access units up to the next key picture are dropped.
+ */
+static void start_resync( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	ffmpeg_vid_dec_ctx->decode_error = false;
+
+	if( vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->resync ) == RESYNC_OFF )
+	{
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->resyncing == false )
+	{
+		av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_WARNING, "decoding error, resynchronizing at the next key picture\n" );
+		ffmpeg_vid_dec_ctx->resyncing = true;
+		ffmpeg_vid_dec_ctx->resync_start = av_gettime_relative( );
+		ffmpeg_vid_dec_ctx->resync_dropped = 0;
+	}
+
+	// an error at the key picture waits for the next one
+	ffmpeg_vid_dec_ctx->resync_key = false;
+	ffmpeg_vid_dec_ctx->resync_recovered = false;
+	avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
+}
+
+static void finish_resync( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+	int64_t time = av_gettime_relative( ) - ffmpeg_vid_dec_ctx->resync_start;
+
+	ffmpeg_vid_dec_ctx->resyncing = false;
+	ffmpeg_vid_dec_ctx->resync_key = false;
+	ffmpeg_vid_dec_ctx->resync_recovered = false;
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.resyncs, 1 );
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.resync_time_us, time );
+
+	av_log( ffmpeg_vid_dec_ctx->av_codec_ctx, AV_LOG_WARNING, "resynchronized after %lld us, %lld access units dropped\n",
+		( long long )time, ( long long )ffmpeg_vid_dec_ctx->resync_dropped );
+}
+
+/*
+ * returns true if the access unit is dropped while resynchronizing. Parameter sets pass.
+ */
+static bool skip_to_key( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVPacket* avpkt )
+{
+	nal_picture_kind_t kind;
+
+	if( ffmpeg_vid_dec_ctx->resyncing == false || ffmpeg_vid_dec_ctx->resync_key == true )
+	{
+		return false;
+	}
+
+	kind = nal_classify_picture( PLUGIN_NAL_CODEC, avpkt->data, avpkt->size );
+	if( kind == NAL_PICTURE_KEY )
+	{
+		ffmpeg_vid_dec_ctx->resync_key = true;
+	}
+	else if( kind != NAL_PICTURE_NONE )
+	{
+		ffmpeg_vid_dec_ctx->resync_dropped++;
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.resync_packets_dropped, 1 );
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * reacts to an exceeded memory budget of the process before an access unit. The instance frees its idle frame buffers
+ * once, waits for the other instances while its decoder is going to be reduced, and a preview instance drops the
+ * non-reference pictures otherwise. Returns true if the access unit is dropped.
+ */
+static bool give_way( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const AVPacket* avpkt )
+{
+	if( memory_budget_exceeded( ffmpeg_vid_dec_ctx->memory_budget_client ) == false )
+	{
+		ffmpeg_vid_dec_ctx->memory_giving_way = false;
+		return false;
+	}
+
+#if FRAME_POOL_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->memory_giving_way == false && ffmpeg_vid_dec_ctx->frame_pool != NULL )
+	{
+		frame_pool_trim( ffmpeg_vid_dec_ctx->frame_pool );
+	}
+#endif
+	ffmpeg_vid_dec_ctx->memory_giving_way = true;
+
+	// without a pending reduction, waiting would slow the instance down without freeing memory
+	if( ffmpeg_vid_dec_ctx->memory_frame_threads != ffmpeg_vid_dec_ctx->memory_frame_threads_applied )
+	{
+		memory_budget_wait( ffmpeg_vid_dec_ctx->memory_budget_client, MEMORY_BUDGET_WAIT_MS );
+		return false;
+	}
+
+	if( vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->quality_requested ) != QUALITY_FULL &&
+		nal_classify_picture( PLUGIN_NAL_CODEC, avpkt->data, avpkt->size ) == NAL_PICTURE_NON_REFERENCE )
+	{
+		dec_stats_add( &ffmpeg_vid_dec_ctx->stats.frames_skipped, 1 );
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * decodes a packet and accounts the time spent in the decoder, without the time of the picture callbacks.
+ */
+static void decode( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVPacket* avpkt )
+{
+	int64_t frames = ffmpeg_vid_dec_ctx->stats.frames_decoded;
+	int64_t start;
+	int64_t time;
+
+	if( ffmpeg_vid_dec_ctx->pacing == true && ffmpeg_vid_dec_ctx->codec_open == true && avpkt != NULL && avpkt->size > 0 )
+	{
+		pace( ffmpeg_vid_dec_ctx );
+	}
+
+	if( avpkt != NULL && avpkt->size > 0 && skip_to_key( ffmpeg_vid_dec_ctx, avpkt ) == true )
+	{
+		return;
+	}
+
+	// a drain releases memory itself
+	if( ffmpeg_vid_dec_ctx->memory_budget_client != NULL && avpkt != NULL && avpkt->size > 0 && give_way( ffmpeg_vid_dec_ctx, avpkt ) == true )
+	{
+		return;
+	}
+
+	start = av_gettime_relative( );
+	ffmpeg_vid_dec_ctx->callback_time = 0;
+
+	// a drain is no access unit
+	if( avpkt != NULL && avpkt->size > 0 )
+	{
+		update_decode_settings( ffmpeg_vid_dec_ctx, avpkt );
+	}
+
+	if( ffmpeg_vid_dec_ctx->codec_open == false )
+	{
+		return;
+	}
+
+	decode_packet( ffmpeg_vid_dec_ctx, avpkt );
+
+	if( ffmpeg_vid_dec_ctx->decode_error == true )
+	{
+		start_resync( ffmpeg_vid_dec_ctx );
+	}
+	else if( ffmpeg_vid_dec_ctx->resync_recovered == true )
+	{
+		finish_resync( ffmpeg_vid_dec_ctx );
+	}
+
+	update_memory( ffmpeg_vid_dec_ctx );
+
+	// the reorder delay is known after the first sequence parameter set
+	update_latency( ffmpeg_vid_dec_ctx );
+
+	time = av_gettime_relative( ) - start - ffmpeg_vid_dec_ctx->callback_time;
+	dec_stats_add_time( &ffmpeg_vid_dec_ctx->stats.decode_time_us, ffmpeg_vid_dec_ctx->stats.decode_latency, time );
+
+	update_speed( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->stats.frames_decoded - frames, time );
+}
+
+static void drain( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx )
+{
+#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
+	av_init_packet( ffmpeg_vid_dec_ctx->pkt );
+	ffmpeg_vid_dec_ctx->pkt->data = NULL;
+	ffmpeg_vid_dec_ctx->pkt->size = 0;
+	decode( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->pkt );
+#else
+	decode( ffmpeg_vid_dec_ctx, NULL );
+#endif
+}
+
+/*
+ * prepares the instance for decoding, the first chunk selects the decoder configuration.
+ */
+static bool begin_decode( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, const uint8_t* data, uint32_t size )
+{
+	if( ffmpeg_vid_dec_ctx->layer_group != NULL )
+	{
+		layer_group_resume( ffmpeg_vid_dec_ctx->layer_group, ffmpeg_vid_dec_ctx->layer );
+	}
+
+#if ASYNC_SUPPORTED
+	// the worker opens and reopens the decoder, see async_worker
+	if( ffmpeg_vid_dec_ctx->worker_running == true )
+	{
+		return true;
+	}
+#endif
+
+	return open_decoder( ffmpeg_vid_dec_ctx, data, size );
+}
+
+#if ASYNC_SUPPORTED
+static AVPacket* create_async_packet( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	AVPacket* pkt = av_packet_alloc( );
+	if( pkt == NULL )
+	{
+		return NULL;
+	}
+
+	// the caller's buffer is only valid during this call
+	if( prepare_packet( ffmpeg_vid_dec_ctx, pkt, data, size, pts, dts ) == false )
+	{
+		if( av_new_packet( pkt, size ) < 0 )
+		{
+			av_packet_free( &pkt );
+			return NULL;
+		}
+
+		memcpy( pkt->data, data, size );
+		pkt->pts = pts;
+		pkt->dts = dts;
+	}
+
+	return pkt;
+}
+#endif
+
+static void decode_chunk( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	av_init_packet( ffmpeg_vid_dec_ctx->pkt );
+
+	prepare_packet( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->pkt, data, size, pts, dts );
+
+	decode( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->pkt );
+
+#if ( LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101) )
+	av_packet_unref( ffmpeg_vid_dec_ctx->pkt );
+#endif
+}
+
+static void decode_access_unit( void* opaque, uint8_t* data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )opaque;
+
+#if GOP_DECODER_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->gop_decoder != NULL )
+	{
+		AVPacket* pkt = create_async_packet( ffmpeg_vid_dec_ctx, data, size, pts, dts );
+		if( pkt != NULL )
+		{
+			gop_decoder_push( ffmpeg_vid_dec_ctx->gop_decoder, pkt );
+		}
+		return;
+	}
+#endif
+
+	if( begin_decode( ffmpeg_vid_dec_ctx, data, size ) == false )
+	{
+		return;
+	}
+
+#if ASYNC_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->worker_running == true )
+	{
+		AVPacket* pkt = create_async_packet( ffmpeg_vid_dec_ctx, data, size, pts, dts );
+		if( pkt != NULL )
+		{
+			work_queue_push( &ffmpeg_vid_dec_ctx->queue, pkt );
+		}
+		return;
+	}
+#endif
+
+	decode_chunk( ffmpeg_vid_dec_ctx, data, size, pts, dts );
+}
+
+static void ffmpeg_vid_dec_decode( ffmpeg_vid_dec_handle h_dec, uint8_t *data, uint32_t size, uint64_t pts, uint64_t dts )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+
+	if( ffmpeg_vid_dec_ctx == NULL )
+	{
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->init == false )
+	{
+		return;
+	}
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.packets_in, 1 );
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.bytes_in, size );
+
+	if( ffmpeg_vid_dec_ctx->au_splitter != NULL )
+	{
+		au_splitter_push( ffmpeg_vid_dec_ctx->au_splitter, data, size, pts, dts, decode_access_unit, ffmpeg_vid_dec_ctx );
+		return;
+	}
+
+	decode_access_unit( ffmpeg_vid_dec_ctx, data, size, pts, dts );
+}
+
+static void ffmpeg_vid_dec_decode_batch( dvpd_input_dec_handle_t h_dec, const dvpd_input_dec_chunk_t *chunks, uint32_t count )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+	int64_t bytes = 0;
+
+	if( ffmpeg_vid_dec_ctx == NULL || chunks == NULL || count == 0 )
+	{
+		return;
+	}
+
+	if( ffmpeg_vid_dec_ctx->init == false )
+	{
+		return;
+	}
+
+	for( uint32_t i = 0; i < count; i++ )
+	{
+		bytes += chunks[ i ].size;
+	}
+
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.packets_in, count );
+	dec_stats_add( &ffmpeg_vid_dec_ctx->stats.bytes_in, bytes );
+
+	if( ffmpeg_vid_dec_ctx->au_splitter != NULL )
+	{
+		for( uint32_t i = 0; i < count; i++ )
+		{
+			au_splitter_push( ffmpeg_vid_dec_ctx->au_splitter, chunks[ i ].data, chunks[ i ].size, chunks[ i ].pts, chunks[ i ].dts,
+				decode_access_unit, ffmpeg_vid_dec_ctx );
+		}
+		return;
+	}
+
+#if GOP_DECODER_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->gop_decoder != NULL )
+	{
+		for( uint32_t i = 0; i < count; i++ )
+		{
+			decode_access_unit( ffmpeg_vid_dec_ctx, chunks[ i ].data, chunks[ i ].size, chunks[ i ].pts, chunks[ i ].dts );
+		}
+		return;
+	}
+#endif
+
+	if( begin_decode( ffmpeg_vid_dec_ctx, chunks[ 0 ].data, chunks[ 0 ].size ) == false )
+	{
+		return;
+	}
+
+#if ASYNC_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->worker_running == true )
+	{
+		void* packets[ MAX_BATCH_PACKETS ];
+		int32_t queued = 0;
+
+		// packets are published in groups, the worker wakes up once per group instead of once per packet
+		for( uint32_t i = 0; i < count; i++ )
+		{
+			AVPacket* pkt = create_async_packet( ffmpeg_vid_dec_ctx, chunks[ i ].data, chunks[ i ].size, chunks[ i ].pts, chunks[ i ].dts );
+			if( pkt != NULL )
+			{
+				packets[ queued++ ] = pkt;
+			}
+
+			if( queued == MAX_BATCH_PACKETS || ( i == count - 1 && queued > 0 ) )
+			{
+				work_queue_push_n( &ffmpeg_vid_dec_ctx->queue, packets, queued );
+				queued = 0;
+			}
+		}
+		return;
+	}
+#endif
+
+	for( uint32_t i = 0; i < count; i++ )
+	{
+		decode_chunk( ffmpeg_vid_dec_ctx, chunks[ i ].data, chunks[ i ].size, chunks[ i ].pts, chunks[ i ].dts );
+	}
+}
+
+static void flush_decoder( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, bool discard )
+{
+	// the last access unit of the stream is complete now
+	if( ffmpeg_vid_dec_ctx->au_splitter != NULL )
+	{
+		if( discard == true )
+		{
+			au_splitter_reset( ffmpeg_vid_dec_ctx->au_splitter );
+		}
+		else
+		{
+			au_splitter_flush( ffmpeg_vid_dec_ctx->au_splitter, decode_access_unit, ffmpeg_vid_dec_ctx );
+		}
 	}
 
-	if (i_num_cores > 16)
+#if GOP_DECODER_SUPPORTED
+	if( ffmpeg_vid_dec_ctx->gop_decoder != NULL )
 	{
-		i_num_cores = 16;
+		if( discard == true )
+		{
+			gop_decoder_discard( ffmpeg_vid_dec_ctx->gop_decoder );
+		}
+		else
+		{
+			gop_decoder_drain( ffmpeg_vid_dec_ctx->gop_decoder );
+		}
+		return;
 	}
+#endif
 
-	return i_num_cores;
-}
+#if ASYNC_SUPPORTED
+	// the worker opens the decoder, it may not have been opened for the queued packets yet
+	if( ffmpeg_vid_dec_ctx->worker_running == true )
+	{
+		if( discard == true )
+		{
+			vid_dec_atomic_store32( &ffmpeg_vid_dec_ctx->discarding, 1 );
+		}
 
-static ffmpeg_vid_dec_handle ffmpeg_vid_dec_create( void )
-{
-	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )malloc( sizeof( ffmpeg_vid_dec_ctx_t ) );
+		// returns after the worker has processed everything queued before
+		run_control( ffmpeg_vid_dec_ctx, discard ? &async_discard_marker : &async_drain_marker );
 
-	if( ffmpeg_vid_dec_ctx == NULL )
-	{
-		return NULL;
+		if( ffmpeg_vid_dec_ctx->layer_group != NULL )
+		{
+			if( discard == true )
+			{
+				layer_group_discard( ffmpeg_vid_dec_ctx->layer_group, ffmpeg_vid_dec_ctx->layer );
+			}
+			else
+			{
+				layer_group_drained( ffmpeg_vid_dec_ctx->layer_group, ffmpeg_vid_dec_ctx->layer );
+			}
+		}
+		return;
 	}
+#endif
 
-	memset( ffmpeg_vid_dec_ctx, 0, sizeof( ffmpeg_vid_dec_ctx_t ) );
+	if( ffmpeg_vid_dec_ctx->codec_open == false )
+	{
+		return;
+	}
 
-	return ffmpeg_vid_dec_ctx;
-}
+	if( discard == false )
+	{
+		drain( ffmpeg_vid_dec_ctx );
+	}
 
-static void ffmpeg_vid_dec_destroy( ffmpeg_vid_dec_handle* h_dec )
-{
-	ffmpeg_vid_dec_ctx_t* ctx = ( ffmpeg_vid_dec_ctx_t* )*h_dec;
+	avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
+	restart_stream( ffmpeg_vid_dec_ctx );
 
-	free( ctx );
-	h_dec = NULL;
+	return;
 }
 
-static bool ffmpeg_vid_dec_init( ffmpeg_vid_dec_handle h_dec, on_decoded_picture_cb_func_t on_decoded_picture, void* app_data, int32_t layer )
+static void ffmpeg_vid_dec_flush( ffmpeg_vid_dec_handle h_dec, bool discard )
 {
 	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
 
 	if( ffmpeg_vid_dec_ctx == NULL )
 	{
-		return false;
+		return;
 	}
 
-	if( ffmpeg_vid_dec_ctx->init == true )
+	if( ffmpeg_vid_dec_ctx->init == false )
 	{
-		return false;
+		return;
 	}
 
-	ffmpeg_vid_dec_ctx->on_decoded_picture = on_decoded_picture;
-	ffmpeg_vid_dec_ctx->app_data = app_data;
-	ffmpeg_vid_dec_ctx->layer = layer;
-
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58,9,100) )
-	avcodec_register_all( );
-#endif
-
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-	ffmpeg_vid_dec_ctx->pkt = malloc( sizeof( AVPacket ) );
-	if( ffmpeg_vid_dec_ctx->pkt == NULL )
+	if( ffmpeg_vid_dec_ctx->picture_queue == NULL )
 	{
-		goto bail;
+		flush_decoder( ffmpeg_vid_dec_ctx, discard );
+		return;
 	}
-#else
-	ffmpeg_vid_dec_ctx->pkt = av_packet_alloc( );
-	if( ffmpeg_vid_dec_ctx->pkt == NULL )
+
+	// a decoder blocked on the full queue drops its picture and continues
+	if( discard == true )
 	{
-		goto bail;
+		picture_queue_discard( ffmpeg_vid_dec_ctx->picture_queue, true );
 	}
-#endif
 
-#ifdef AVC_CODEC
-	ffmpeg_vid_dec_ctx->codec = avcodec_find_decoder( AV_CODEC_ID_H264 );
-#else
-	ffmpeg_vid_dec_ctx->codec = avcodec_find_decoder( AV_CODEC_ID_H265 );
-#endif
-	if( ffmpeg_vid_dec_ctx->codec == NULL )
+	flush_decoder( ffmpeg_vid_dec_ctx, discard );
+
+	if( discard == true )
 	{
-		goto bail;
+		picture_queue_discard( ffmpeg_vid_dec_ctx->picture_queue, false );
 	}
 
-	ffmpeg_vid_dec_ctx->av_codec_ctx = avcodec_alloc_context3( ffmpeg_vid_dec_ctx->codec );
-	if( ffmpeg_vid_dec_ctx->av_codec_ctx == NULL )
+	picture_queue_end( ffmpeg_vid_dec_ctx->picture_queue );
+}
+
+static bool ffmpeg_vid_dec_is_init(dvpd_input_dec_handle_t h_dec )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+
+	if( ffmpeg_vid_dec_ctx == NULL )
 	{
-		goto bail;
+		return false;
 	}
 
-	ffmpeg_vid_dec_ctx->av_codec_ctx->thread_count = get_cpu_count();
+	return ffmpeg_vid_dec_ctx->init;
+}
+
+static bool ffmpeg_vid_dec_set_option( dvpd_input_dec_handle_t h_dec, const char *name, const char *value )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
 
-	if( avcodec_open2( ffmpeg_vid_dec_ctx->av_codec_ctx, ffmpeg_vid_dec_ctx->codec, NULL ) < 0 )
+	if( ffmpeg_vid_dec_ctx == NULL || name == NULL || value == NULL )
 	{
-		goto bail;
+		return false;
 	}
 
-	ffmpeg_vid_dec_ctx->frame = av_frame_alloc( );
-	if( ffmpeg_vid_dec_ctx->frame == NULL )
+	for( const option_t* option = options; option->name != NULL; option++ )
 	{
-		goto bail;
+		if( strcmp( option->name, name ) != 0 )
+		{
+			continue;
+		}
+
+		if( ffmpeg_vid_dec_ctx->init == true && option->runtime == false )
+		{
+			return false;
+		}
+
+		return option->set( ffmpeg_vid_dec_ctx, value );
 	}
 
-	ffmpeg_vid_dec_ctx->init = true;
+	return false;
+}
 
-	return true;
+static bool copy_value( const char* source, char* value, uint32_t size )
+{
+	size_t length = strlen( source );
 
-bail:
-	if( ffmpeg_vid_dec_ctx->av_codec_ctx != NULL )
+	if( length >= size )
 	{
-		avcodec_free_context( &ffmpeg_vid_dec_ctx->av_codec_ctx );
+		return false;
 	}
 
-	if( ffmpeg_vid_dec_ctx->frame != NULL )
-	{
-		av_frame_free( &ffmpeg_vid_dec_ctx->frame );
-	}
+	memcpy( value, source, length + 1 );
 
-	if( ffmpeg_vid_dec_ctx->pkt != NULL )
+	return true;
+}
+
+static const char* value_name( const option_value_t* values, int32_t value )
+{
+	for( ; values->name != NULL; values++ )
 	{
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-		free( ffmpeg_vid_dec_ctx->pkt );
-#else
-		av_packet_free( &ffmpeg_vid_dec_ctx->pkt );
-#endif
+		if( values->value == value )
+		{
+			return values->name;
+		}
 	}
 
-	return false;
+	return "";
 }
 
-static bool ffmpeg_vid_dec_deinit( ffmpeg_vid_dec_handle h_dec )
+static bool ffmpeg_vid_dec_get_option( dvpd_input_dec_handle_t h_dec, const char *name, char *value, uint32_t size )
 {
 	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+	char number[ 32 ];
 
-	if( ffmpeg_vid_dec_ctx == NULL )
+	if( ffmpeg_vid_dec_ctx == NULL || name == NULL || value == NULL || size == 0 )
 	{
 		return false;
 	}
 
-	if( ffmpeg_vid_dec_ctx->init == false )
+	if( strcmp( name, FFMPEG_VID_DEC_INFO_LATENCY_FRAMES ) == 0 )
 	{
-		return false;
+		snprintf( number, sizeof( number ), "%d", vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->latency_frames ) );
+		return copy_value( number, value, size );
 	}
 
-	avcodec_free_context( &ffmpeg_vid_dec_ctx->av_codec_ctx );
-	av_frame_free( &ffmpeg_vid_dec_ctx->frame );
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-		free( ffmpeg_vid_dec_ctx->pkt );
-#else
-		av_packet_free( &ffmpeg_vid_dec_ctx->pkt );
-#endif
-
-	ffmpeg_vid_dec_ctx->init = false;
+	// the values in effect, which follow a requested change at the next access unit or key picture
+	if( strcmp( name, FFMPEG_VID_DEC_OPT_DECODE_MODE ) == 0 )
+	{
+		return copy_value( value_name( decode_mode_values, ffmpeg_vid_dec_ctx->decode_mode ), value, size );
+	}
 
-	return true;
-}
+	if( strcmp( name, FFMPEG_VID_DEC_OPT_QUALITY ) == 0 )
+	{
+		return copy_value( value_name( quality_values, ffmpeg_vid_dec_ctx->quality ), value, size );
+	}
 
-static void decode( ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx, AVPacket* avpkt )
-{
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-	while( 1 )
+	if( strcmp( name, FFMPEG_VID_DEC_OPT_THREADS ) == 0 )
 	{
-		dvpd_input_dec_picture_t output_picture = {0};
-		AVFrame* output_frame = ffmpeg_vid_dec_ctx->frame;
-		int got_picture = 0;
+		snprintf( number, sizeof( number ), "%d", vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->threads_in_effect ) );
+		return copy_value( number, value, size );
+	}
 
-		int32_t ret = avcodec_decode_video2( ffmpeg_vid_dec_ctx->av_codec_ctx, output_frame, &got_picture, avpkt );
-		if( ret < 0 )
-		{
-			// fprintf( stderr, "Error sending a packet for decoding\n" );
-			return;
-		}
+	if( strcmp( name, FFMPEG_VID_DEC_INFO_SPEED ) == 0 )
+	{
+		snprintf( number, sizeof( number ), "%d", vid_dec_atomic_load32( &ffmpeg_vid_dec_ctx->speed_percent ) );
+		return copy_value( number, value, size );
+	}
 
-		avpkt->size -= ret;
-		avpkt->data += ret;
+	if( strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_FRAMES ) == 0 || strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_PACKETS ) == 0 ||
+		strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_THREADS ) == 0 )
+	{
+		volatile int64_t* bytes = &ffmpeg_vid_dec_ctx->stats.memory_threads;
 
-		if( avpkt->size == 0 && got_picture == 0 )
+		if( strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_FRAMES ) == 0 )
 		{
-			return;
+			bytes = &ffmpeg_vid_dec_ctx->stats.memory_frames;
 		}
-
-		if( got_picture == 0 )
+		else if( strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_PACKETS ) == 0 )
 		{
-			continue;
+			bytes = &ffmpeg_vid_dec_ctx->stats.memory_packets;
 		}
-#else
-	int32_t ret = avcodec_send_packet( ffmpeg_vid_dec_ctx->av_codec_ctx, avpkt );
-	if( ret < 0 )
-	{
-		// fprintf( stderr, "Error sending a packet for decoding\n" );
-		return;
+
+		snprintf( number, sizeof( number ), "%lld", ( long long )vid_dec_atomic_load64( bytes ) );
+		return copy_value( number, value, size );
 	}
 
-	while( ret >= 0 )
+	if( strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_PROCESS ) == 0 || strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_PROCESS_PEAK ) == 0 )
 	{
-		dvpd_input_dec_picture_t output_picture = {0};
-		AVFrame* output_frame = ffmpeg_vid_dec_ctx->frame;
+		memory_budget_stats_t stats;
 
-		ret = avcodec_receive_frame( ffmpeg_vid_dec_ctx->av_codec_ctx, output_frame );
-		if( ret == AVERROR( EAGAIN ) || ret == AVERROR_EOF )
-		{
-			return;
-		}
-		else if( ret < 0 )
-		{
-			// fprintf( stderr, "Error during decoding\n" );
-			return;
-		}
-#endif
+		memory_budget_get_stats( &stats );
+		snprintf( number, sizeof( number ), "%lld",
+			( long long )( strcmp( name, FFMPEG_VID_DEC_INFO_MEMORY_PROCESS ) == 0 ? stats.bytes : stats.peak_bytes ) );
+		return copy_value( number, value, size );
+	}
 
-		switch( ( enum AVPixelFormat )output_frame->format )
-		{
-		case AV_PIX_FMT_YUV420P:
-			output_picture.bit_depth = 8;
-			break;
-		case AV_PIX_FMT_YUV420P10LE:
-			output_picture.bit_depth = 10;
-			break;
-		default:
-			// fprintf( stderr, "Error! raw output format  not supported\n" );
-			return;
-		}
+	// the placement applied when the decoder was opened
+	if( strcmp( name, FFMPEG_VID_DEC_OPT_CPUSET ) == 0 )
+	{
+		char list[ 512 ];
 
-		for( int32_t i = 0; i < 3; i++ )
-		{
-			output_picture.data[ i ] = output_frame->data[ i ];
-			output_picture.stride[ i ] = output_frame->linesize[ i ];
-		}
-		output_picture.width = output_frame->width;
-		output_picture.height = output_frame->height;
-		output_picture.dts = output_frame->pkt_dts;
-		output_picture.app_specific_data = NULL;
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-		output_picture.pts = output_frame->pkt_pts;
-#else
-		output_picture.pts = output_frame->pts;
-#endif
+		placement_format_cpus( &ffmpeg_vid_dec_ctx->placement_applied, list, sizeof( list ) );
+		return copy_value( list, value, size );
+	}
 
-		ffmpeg_vid_dec_ctx->on_decoded_picture( &output_picture, ffmpeg_vid_dec_ctx->app_data, ffmpeg_vid_dec_ctx->layer );
+	if( strcmp( name, FFMPEG_VID_DEC_OPT_NUMA_NODE ) == 0 )
+	{
+		snprintf( number, sizeof( number ), "%d", ffmpeg_vid_dec_ctx->placement_applied.numa_node );
+		return copy_value( number, value, size );
 	}
 
-	return;
+	return false;
 }
 
-
-static void ffmpeg_vid_dec_decode( ffmpeg_vid_dec_handle h_dec, uint8_t *data, uint32_t size, uint64_t pts, uint64_t dts )
+static uint8_t* ffmpeg_vid_dec_get_input_buffer( dvpd_input_dec_handle_t h_dec, uint32_t size )
 {
+#if INPUT_ARENA_SUPPORTED
 	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
 
-	if( ffmpeg_vid_dec_ctx == NULL )
+	if( ffmpeg_vid_dec_ctx == NULL || ffmpeg_vid_dec_ctx->init == false || ffmpeg_vid_dec_ctx->input_arena == NULL )
 	{
-		return;
+		return NULL;
 	}
 
-	if( ffmpeg_vid_dec_ctx->init == false )
+	for( int32_t i = 0; i < MAX_HOST_INPUT_BUFFERS; i++ )
 	{
-		return;
-	}
-
-	av_init_packet( ffmpeg_vid_dec_ctx->pkt );
-
-	ffmpeg_vid_dec_ctx->pkt->data = data;
-	ffmpeg_vid_dec_ctx->pkt->size = size;
-	ffmpeg_vid_dec_ctx->pkt->dts = dts;
-	ffmpeg_vid_dec_ctx->pkt->pts = pts;
+		if( ffmpeg_vid_dec_ctx->host_input_buffers[ i ] == NULL )
+		{
+			ffmpeg_vid_dec_ctx->host_input_buffers[ i ] = input_arena_get( ffmpeg_vid_dec_ctx->input_arena, size );
+			if( ffmpeg_vid_dec_ctx->host_input_buffers[ i ] == NULL )
+			{
+				return NULL;
+			}
 
-	decode( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->pkt );
+			return ffmpeg_vid_dec_ctx->host_input_buffers[ i ]->data;
+		}
+	}
+#endif
 
-	return;
+	return NULL;
 }
 
-static void ffmpeg_vid_dec_flush( ffmpeg_vid_dec_handle h_dec, bool discard )
+static void ffmpeg_vid_dec_release_picture( dvpd_input_dec_handle_t h_dec, dvpd_input_dec_picture_t *dec_picture )
 {
 	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+	picture_info_t* info;
 
-	if( ffmpeg_vid_dec_ctx == NULL )
+	if( ffmpeg_vid_dec_ctx == NULL || dec_picture == NULL )
 	{
 		return;
 	}
 
-	if( ffmpeg_vid_dec_ctx->init == false )
+	// borrowed pictures returned their info when the picture callback returned
+	info = picture_info_from_app_data( dec_picture->app_specific_data );
+	if( info == NULL || info->owned == false )
 	{
 		return;
 	}
 
-	if( discard == false )
+	picture_info_release( info );
+
+	memset( dec_picture->data, 0, sizeof( dec_picture->data ) );
+	dec_picture->app_specific_data = NULL;
+}
+
+static int32_t ffmpeg_vid_dec_receive_picture( dvpd_input_dec_handle_t h_dec, dvpd_input_dec_picture_t *dec_picture, int32_t timeout_ms )
+{
+	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
+
+	if( ffmpeg_vid_dec_ctx == NULL || dec_picture == NULL || ffmpeg_vid_dec_ctx->init == false || ffmpeg_vid_dec_ctx->picture_queue == NULL )
 	{
-#if ( LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57,48,101) )
-		av_init_packet( ffmpeg_vid_dec_ctx->pkt );
-		ffmpeg_vid_dec_ctx->pkt->data = NULL;
-		ffmpeg_vid_dec_ctx->pkt->size = 0;
-		decode( ffmpeg_vid_dec_ctx, ffmpeg_vid_dec_ctx->pkt );
-#else
-		decode( ffmpeg_vid_dec_ctx, NULL );
-#endif
+		return DVPD_INPUT_DEC_RECEIVE_ERROR;
 	}
 
-	avcodec_flush_buffers( ffmpeg_vid_dec_ctx->av_codec_ctx );
-
-	return;
+	return picture_queue_pop( ffmpeg_vid_dec_ctx->picture_queue, timeout_ms, dec_picture );
 }
 
-static bool ffmpeg_vid_dec_is_init(dvpd_input_dec_handle_t h_dec )
+static bool ffmpeg_vid_dec_get_stats( dvpd_input_dec_handle_t h_dec, dvpd_input_dec_stats_t *stats )
 {
 	ffmpeg_vid_dec_ctx_t* ffmpeg_vid_dec_ctx = ( ffmpeg_vid_dec_ctx_t* )h_dec;
 
-	if( ffmpeg_vid_dec_ctx == NULL )
+	if( ffmpeg_vid_dec_ctx == NULL || stats == NULL )
 	{
 		return false;
 	}
 
-	return ffmpeg_vid_dec_ctx->init;
+	return dec_stats_read( &ffmpeg_vid_dec_ctx->stats, stats );
 }
 
-DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin )
+/*
+ * fills the fields of version 0, the structure of a version 0 caller ends after them.
+ */
+static void describe( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin )
 {
-	dv_dec_video_dec_plugin->dv_plugin_api_version = DV_PLUGIN_API_VERSION;
 #ifdef AVC_CODEC
 	dv_dec_video_dec_plugin->name = "FFmpeg AVC decoder";
 	dv_dec_video_dec_plugin->type = "AVC";
@@ -404,3 +3465,44 @@ DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe( dv_dec_video_dec_pl
 	dv_dec_video_dec_plugin->vid_dec_if.init = ffmpeg_vid_dec_init;
 	dv_dec_video_dec_plugin->vid_dec_if.is_init = ffmpeg_vid_dec_is_init;
 }
+
+DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin )
+{
+	dv_dec_video_dec_plugin->dv_plugin_api_version = 0;
+	describe( dv_dec_video_dec_plugin );
+}
+
+DVPD_VID_DEC_PLUGIN_API void dv_dec_vid_dec_plugin_describe_version( dv_dec_video_dec_plugin_t* dv_dec_video_dec_plugin, int32_t api_version )
+{
+	if( api_version < 0 )
+	{
+		api_version = 0;
+	}
+	else if( api_version > DV_PLUGIN_API_VERSION )
+	{
+		api_version = DV_PLUGIN_API_VERSION;
+	}
+
+	dv_dec_video_dec_plugin->dv_plugin_api_version = api_version;
+	describe( dv_dec_video_dec_plugin );
+
+	if( api_version >= 1 )
+	{
+		dv_dec_video_dec_plugin->vid_dec_if.set_option = ffmpeg_vid_dec_set_option;
+		dv_dec_video_dec_plugin->vid_dec_if.release_picture = ffmpeg_vid_dec_release_picture;
+		dv_dec_video_dec_plugin->vid_dec_if.get_input_buffer = ffmpeg_vid_dec_get_input_buffer;
+	}
+
+	if( api_version >= 2 )
+	{
+		dv_dec_video_dec_plugin->vid_dec_if.get_stats = ffmpeg_vid_dec_get_stats;
+		dv_dec_video_dec_plugin->vid_dec_if.decode_batch = ffmpeg_vid_dec_decode_batch;
+		dv_dec_video_dec_plugin->vid_dec_if.get_option = ffmpeg_vid_dec_get_option;
+		dv_dec_video_dec_plugin->vid_dec_if.receive_picture = ffmpeg_vid_dec_receive_picture;
+
+		dv_dec_video_dec_plugin->capabilities = DVPD_VID_DEC_CAP_DECODE_BATCH | DVPD_VID_DEC_CAP_STATS | DVPD_VID_DEC_CAP_RECEIVE_PICTURE;
+#if INPUT_ARENA_SUPPORTED
+		dv_dec_video_dec_plugin->capabilities |= DVPD_VID_DEC_CAP_INPUT_BUFFERS;
+#endif
+	}
+}
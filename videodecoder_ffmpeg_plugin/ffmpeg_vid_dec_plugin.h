@@ -0,0 +1,487 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief options of the FFmpeg based video decoder plugin.
+* @file ffmpeg_vid_dec_plugin.h
+*
+* Options are set per decoder instance with dvpd_input_dec_if_t::set_option. Every option can also be preset
+* for all instances of a process by an environment variable. The name of the variable is the option name in
+* upper case with the prefix 'DVPD_FFMPEG_', e.g. DVPD_FFMPEG_PICTURE_OWNERSHIP=owned.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_PLUGIN_H_
+#define __FFMPEG_VID_DEC_PLUGIN_H_
+
+#include "dvpd_vid_dec_plugin.h"
+
+/*!
+	FFMPEG_VID_DEC_OPT_PICTURE_OWNERSHIP
+	@brief ownership of the decoded pictures passed to the picture callback.\n
+	@li "borrowed"  (default) picture data is only valid while the picture callback runs.
+	@li "owned"     every picture holds its own reference to the decoded frame. The picture data stays valid until
+	                the picture is passed to dvpd_input_dec_if_t::release_picture, which must be done for every picture.
+	In both cases app_specific_data of the picture points to its ffmpeg_vid_dec_picture_info_t, which is valid as long as
+	the picture data and must not be modified.
+*/
+#define FFMPEG_VID_DEC_OPT_PICTURE_OWNERSHIP "picture_ownership"
+
+/*!
+	FFMPEG_VID_DEC_OPT_THREAD_TYPE
+	@brief threading model of libavcodec.\n
+	@li "default"   (default) libavcodec's choice, frame threading for HEVC and AVC.
+	@li "frame"     frame threading, best throughput at the cost of one frame of delay and one frame of memory per thread.
+	@li "slice"     slice threading, parallelism within a picture (slices, tiles or wavefront rows).
+	@li "auto"      chosen from the layout of the first access unit: slice threading if the stream uses wavefront parallel
+	                processing or tiles, or splits every picture into at least as many slices as there are threads,
+	                frame threading otherwise. The decoder is opened with the first call of decode().
+*/
+#define FFMPEG_VID_DEC_OPT_THREAD_TYPE "thread_type"
+
+/*!
+	FFMPEG_VID_DEC_OPT_THREADS
+	@brief number of decoding threads of the instance.\n
+	"0" (default) uses one thread per CPU core, at most 16. Any other value is used as is, which allows distributing
+	a fixed thread budget among several decoder instances.
+*/
+#define FFMPEG_VID_DEC_OPT_THREADS "threads"
+
+/*!
+	FFMPEG_VID_DEC_OPT_THREAD_POOL
+	@brief threads running the decoding jobs.\n
+	@li "instance"  (default) the threads libavcodec starts for the instance.
+	@li "shared"    one pool of a thread per CPU core for all instances of the process using this value. A stream split
+	                into several slices, tiles or wavefront rows decodes with slice threading, whose jobs run on the
+	                calling thread and on the pool, which divides its threads evenly among the instances decoding at the
+	                time. FFMPEG_VID_DEC_OPT_THREADS bounds the jobs of the instance running at the same time. Avoids
+	                oversubscribing the cores with many instances per process. The decoder is opened with the first
+	                access unit, whose layout selects the pool. Other streams decode with the threads of the instance
+	                as with "instance". libavcodec still starts its slice threads for the instance, they stay idle
+	                while the pool runs the jobs.
+*/
+#define FFMPEG_VID_DEC_OPT_THREAD_POOL "thread_pool"
+
+/*!
+	FFMPEG_VID_DEC_OPT_CONTEXT_POOL
+	@brief number of opened, idle decoder contexts kept for reuse by the process. Defaults to "0".\n
+	"0" frees the context of the instance at deinit() and never takes one from the pool. Otherwise deinit() flushes the
+	decoder context of the instance and returns it to a process wide pool instead of freeing it. Opening a decoder with
+	the same codec, threading and frame pool configuration takes a context from the pool, which saves the start of the
+	decoding threads. The idle buffers of its frame pool are freed, but a pooled context keeps its decoding threads and
+	their state, which is not accounted by FFMPEG_VID_DEC_OPT_MEMORY_LIMIT and FFMPEG_VID_DEC_OPT_MEMORY_BUDGET.
+	Contexts idle for more than 30 seconds are freed the next time a decoder is opened or deinitialized with a pool,
+	and, except on Windows, when the plugin is unloaded.
+*/
+#define FFMPEG_VID_DEC_OPT_CONTEXT_POOL "context_pool"
+
+/*!
+	FFMPEG_VID_DEC_OPT_LOW_LATENCY
+	@brief low latency decoding for live feeds.\n
+	@li "off"       (default) the threading of FFMPEG_VID_DEC_OPT_THREAD_TYPE, which for frame threading delays the output
+	                by one picture per thread.
+	@li "on"        slice threading regardless of FFMPEG_VID_DEC_OPT_THREAD_TYPE, and AV_CODEC_FLAG_LOW_DELAY. Pictures are
+	                output as soon as the reordering signalled by the stream allows. AVC streams which reorder pictures
+	                without signalling it (no VUI bitstream restriction) may be output in decoding order.
+	The resulting delay can be read with FFMPEG_VID_DEC_INFO_LATENCY_FRAMES.
+*/
+#define FFMPEG_VID_DEC_OPT_LOW_LATENCY "low_latency"
+
+/*!
+	FFMPEG_VID_DEC_OPT_CPUSET
+	@brief CPUs the decoding threads of the instance run on, as list like "0-7,16-23" (Linux only).\n
+	The threads of libavcodec and the asynchronous worker thread are bound to the CPUs. With "threads" set to "0" the
+	instance uses one thread per CPU of the list, at most 16. In synchronous mode the thread calling decode() is not bound.
+	get_option returns the CPUs the threads were actually bound to, which the CPU set of the process may restrict.
+*/
+#define FFMPEG_VID_DEC_OPT_CPUSET "cpuset"
+
+/*!
+	FFMPEG_VID_DEC_OPT_NUMA_NODE
+	@brief NUMA node of the instance (Linux only). Defaults to "-1", no node.\n
+	Pooled frames are allocated on the node. Without FFMPEG_VID_DEC_OPT_CPUSET the decoding threads are bound to the CPUs of
+	the node. get_option returns the node the frame pool binds its memory to.
+*/
+#define FFMPEG_VID_DEC_OPT_NUMA_NODE "numa_node"
+
+/*!
+	FFMPEG_VID_DEC_OPT_MEMORY_LIMIT
+	@brief memory ceiling of the instance in MB. Defaults to "0", no ceiling.\n
+	The instance accounts its frame buffers (frame pool), packet buffers (input arena) and an estimate of the thread
+	contexts of libavcodec of one byte per pixel and context (see FFMPEG_VID_DEC_INFO_MEMORY_FRAMES ...). Packets are
+	only accounted with FFMPEG_VID_DEC_OPT_INPUT_ARENA enabled. Without FFMPEG_VID_DEC_OPT_FRAME_POOL the frames are
+	estimated from the picture size, the reference and reorder pictures the decoder reports (6 pictures if it reports
+	none) and a picture per frame thread.
+	While the instance exceeds the ceiling with frame threading, the decoder is reopened with proportionally fewer frame
+	threads at the next IDR or BLA picture, and finally with slice threading, which trades throughput and delay for memory.
+	The pictures of the previous decoder are output before, the parameter sets of the stream are passed to the new one.
+	Streams with CRA pictures or AVC recovery points only keep their decoder, a new one would lose or corrupt pictures.
+*/
+#define FFMPEG_VID_DEC_OPT_MEMORY_LIMIT "memory_limit"
+
+/*!
+	FFMPEG_VID_DEC_OPT_MEMORY_BUDGET
+	@brief memory budget in MB shared by all instances of the process that set it. Defaults to "0", the instance does not
+	share a budget.\n
+	The instances sum up the memory they account (see FFMPEG_VID_DEC_OPT_MEMORY_LIMIT); the budget is the value of the
+	instance initialized last, so all instances should set the same value, e.g. with the environment variable
+	DVPD_FFMPEG_MEMORY_BUDGET. While the sum exceeds the budget, instances give way: instances with a reduced
+	FFMPEG_VID_DEC_OPT_QUALITY first, the others while they account more than the budget divided by the number of
+	instances with the full quality. An instance giving way frees its idle frame buffers and is reduced like by FFMPEG_VID_DEC_OPT_MEMORY_LIMIT,
+	with that share as the ceiling unless its own ceiling is lower. Until the reduction takes effect, decode() holds its
+	access units back for up to 200 ms each until the sum falls below the budget (asynchronous mode: the worker thread
+	waits). Once no further reduction is possible, instances with a reduced quality drop their non-reference pictures
+	(counted in frames_skipped of dvpd_input_dec_stats_t) instead. The sum and its peak are available as
+	FFMPEG_VID_DEC_INFO_MEMORY_PROCESS and FFMPEG_VID_DEC_INFO_MEMORY_PROCESS_PEAK, the memory of the instance in
+	dvpd_input_dec_stats_t.
+*/
+#define FFMPEG_VID_DEC_OPT_MEMORY_BUDGET "memory_budget"
+
+/*!
+	FFMPEG_VID_DEC_OPT_ADAPTIVE_THREADS
+	@brief adaptation of the thread count to the decoding speed.\n
+	@li "off"       (default) the thread count of FFMPEG_VID_DEC_OPT_THREADS for the life of the instance.
+	@li "on"        the instance measures its decoding speed (see FFMPEG_VID_DEC_INFO_SPEED) against the frame rate of the
+	                stream. Below the speed FFMPEG_VID_DEC_OPT_HEADROOM asks for, the decoder is reopened with
+	                proportionally more threads at the next IDR or BLA picture, up to one per CPU core (at most 16) or
+	                FFMPEG_VID_DEC_OPT_THREADS if higher. Above twice that speed, it is reopened with proportionally fewer
+	                threads. The pictures of the previous decoder are output before. Requires a frame rate, see
+	                FFMPEG_VID_DEC_OPT_FRAME_RATE. Ignored with FFMPEG_VID_DEC_OPT_GOP_PARALLEL.
+*/
+#define FFMPEG_VID_DEC_OPT_ADAPTIVE_THREADS "adaptive_threads"
+
+/*!
+	FFMPEG_VID_DEC_OPT_HEADROOM
+	@brief speed above real time in percent that FFMPEG_VID_DEC_OPT_ADAPTIVE_THREADS keeps. Defaults to "50", decoding
+	at 1.5 times the frame rate.\n
+*/
+#define FFMPEG_VID_DEC_OPT_HEADROOM "headroom"
+
+/*!
+	FFMPEG_VID_DEC_OPT_FRAME_RATE
+	@brief frame rate of the stream as "num/den" or "num", e.g. "24000/1001". Defaults to "0", the frame rate of the
+	timing information of the stream (VUI), if any.\n
+*/
+#define FFMPEG_VID_DEC_OPT_FRAME_RATE "frame_rate"
+
+/*!
+	FFMPEG_VID_DEC_OPT_PACING
+	@brief pacing of the decoding to real time.\n
+	@li "off"       (default) access units are decoded as fast as they are passed.
+	@li "on"        an access unit is decoded when its picture is due at the frame rate of the stream (see
+	                FFMPEG_VID_DEC_OPT_FRAME_RATE), less the pictures the decoder holds, counted from the first access unit
+	                after init() or flush(). decode() blocks until then (asynchronous mode: the worker thread waits),
+	                which leaves the CPU to other instances. A decoder falling behind by more than a second continues
+	                from the current time instead of catching up. Ignored with FFMPEG_VID_DEC_OPT_GOP_PARALLEL.
+*/
+#define FFMPEG_VID_DEC_OPT_PACING "pacing"
+
+/*!
+	FFMPEG_VID_DEC_OPT_INPUT_ARENA
+	@brief buffering of the access units passed to decode().\n
+	@li "on"        (default) access units are copied into padded, reference counted buffers of a pool owned by the instance,
+	                which libavcodec references without a further copy. Buffers obtained with
+	                dvpd_input_dec_if_t::get_input_buffer are passed to libavcodec without any copy.
+	@li "off"       libavcodec copies every access unit internally (asynchronous mode: into a newly allocated packet).
+*/
+#define FFMPEG_VID_DEC_OPT_INPUT_ARENA "input_arena"
+
+/*!
+	FFMPEG_VID_DEC_OPT_ASYNC
+	@brief asynchronous decoding.\n
+	@li "off"       (default) decode() decodes the access unit and calls the picture callback before it returns.
+	@li "on"        decode() copies the access unit into a bounded queue and returns. A worker thread of the instance
+	                decodes the queued access units and calls the picture callback. decode() blocks while the queue is full.
+	                flush() returns after all access units queued before have been decoded and output (discard = false)
+	                or dropped (discard = true). deinit() drops all queued access units.
+	decode(), flush() and deinit() of an instance must be called from one thread at a time.
+*/
+#define FFMPEG_VID_DEC_OPT_ASYNC "async"
+
+/*!
+	FFMPEG_VID_DEC_OPT_ASYNC_QUEUE_DEPTH
+	@brief number of access units the asynchronous queue holds before decode() blocks. Defaults to "8".\n
+*/
+#define FFMPEG_VID_DEC_OPT_ASYNC_QUEUE_DEPTH "async_queue_depth"
+
+/*!
+	FFMPEG_VID_DEC_OPT_RECEIVE_QUEUE_DEPTH
+	@brief number of pictures and end markers an instance without picture callback queues for
+	dvpd_input_dec_if_t::receive_picture before the decoding blocks. Defaults to "8".\n
+	Such an instance always hands over the ownership of its pictures, as with FFMPEG_VID_DEC_OPT_PICTURE_OWNERSHIP
+	"owned". The time the decoding is blocked counts as callback time in the statistics. A discarding flush and deinit
+	drop the queued pictures. Not available with FFMPEG_VID_DEC_OPT_DUAL_LAYER.
+*/
+#define FFMPEG_VID_DEC_OPT_RECEIVE_QUEUE_DEPTH "receive_queue_depth"
+
+/*!
+	FFMPEG_VID_DEC_OPT_DUAL_LAYER
+	@brief parallel decoding of dual-layer (profile 7) streams.\n
+	@li "off"       (default) the instance delivers its pictures on its own.
+	@li "on"        the instances of the base layer (layer 0) and the enhancement layer (layer 1) form a layer group.
+	                Both decode asynchronously (see FFMPEG_VID_DEC_OPT_ASYNC) on their own worker threads. Pictures of
+	                both layers with equal PTS are delivered as pairs, the base layer picture first, and the picture
+	                callbacks of both instances are never called concurrently. A picture without a partner is delivered
+	                alone once the other layer has output a later picture, was flushed or deinitialized. flush() with
+	                discard = false returns after the pictures of both layers that can be paired have been delivered.
+*/
+#define FFMPEG_VID_DEC_OPT_DUAL_LAYER "dual_layer"
+
+/*!
+	FFMPEG_VID_DEC_OPT_LAYER_GROUP
+	@brief name of the layer group of the instance, at most 63 characters.\n
+	By default the instances initialized with the same app_data form a group. Both instances of a group must set the
+	same name.
+*/
+#define FFMPEG_VID_DEC_OPT_LAYER_GROUP "layer_group"
+
+/*!
+	FFMPEG_VID_DEC_OPT_LAYER_WINDOW
+	@brief number of pictures a layer may run ahead of the other layer. Defaults to "32".\n
+	The worker of a layer that is further ahead waits for the other layer. If the other layer outputs no picture
+	within 250 ms, the pictures beyond the window are delivered alone until it outputs again. The window should
+	exceed async_queue_depth plus the number of frame threads of the slower layer.
+*/
+#define FFMPEG_VID_DEC_OPT_LAYER_WINDOW "layer_window"
+
+/*!
+	FFMPEG_VID_DEC_OPT_FRAME_POOL
+	@brief allocation of the decoded frames.\n
+	@li "on"        (default) frames are allocated from a pool owned by the decoder instance. Plane buffers are recycled
+	                by size class, also across changes of the picture size or format within the stream.
+	@li "off"       frames are allocated by the default allocator of libavcodec.
+*/
+#define FFMPEG_VID_DEC_OPT_FRAME_POOL "frame_pool"
+
+/*!
+	FFMPEG_VID_DEC_OPT_FRAME_POOL_ALIGNMENT
+	@brief alignment of plane pointers and strides of pooled frames in bytes.\n
+	Power of two, at least 16. Defaults to "64" (cache line). The alignment required by libavcodec is always honored.
+*/
+#define FFMPEG_VID_DEC_OPT_FRAME_POOL_ALIGNMENT "frame_pool_alignment"
+
+/*!
+	FFMPEG_VID_DEC_OPT_FRAME_POOL_HUGEPAGES
+	@brief huge page backing of pooled frames (Linux only).\n
+	@li "off"       (default) regular pages.
+	@li "thp"       2 MB aligned buffers advised for transparent huge pages.
+	@li "hugetlb"   buffers from the reserved huge page pool (MAP_HUGETLB), transparent huge pages if none are available.
+*/
+#define FFMPEG_VID_DEC_OPT_FRAME_POOL_HUGEPAGES "frame_pool_hugepages"
+
+/*!
+	FFMPEG_VID_DEC_OPT_SIMD
+	@brief instruction set of the output format conversion.\n
+	Pictures are delivered as planar 4:2:0 with 8, 10 or 12 bits. NV12 and P010 output is deinterleaved, 4:2:2 and
+	4:4:4 output is downsampled to 4:2:0 chroma by averaging. Pictures of any other format are dropped.
+	@li "auto"      (default) the best instruction set of the CPU.
+	@li "avx512", "avx2", "sse4"
+	                at most the given instruction set.
+	@li "c"         scalar code only.
+*/
+#define FFMPEG_VID_DEC_OPT_SIMD "simd"
+
+/*!
+	FFMPEG_VID_DEC_OPT_DECODE_MODE
+	@brief pictures decoded for trick play, can be changed at any time.\n
+	Skipped pictures are counted in dvpd_input_dec_stats_t::frames_skipped, the timestamps of the decoded pictures are
+	passed through unchanged. Skipping more pictures takes effect with the next access unit, decoding more pictures
+	with the next key picture, so that every decoded picture has its references.
+	@li "all"       (default) every picture.
+	@li "reference" pictures used for reference only, non-reference pictures are skipped.
+	@li "key"       key pictures only (HEVC IRAP, AVC IDR and recovery point pictures).
+*/
+#define FFMPEG_VID_DEC_OPT_DECODE_MODE "decode_mode"
+
+/*!
+	FFMPEG_VID_DEC_OPT_QUALITY
+	@brief decoding quality tier, can be changed at any time. A change takes effect with the next key picture.\n
+	The reduced tiers are not bit exact, errors of skipped filtering propagate until the next key picture.
+	@li "full"      (default) bit exact decoding.
+	@li "preview"   in-loop filters (deblocking and SAO) are skipped, non spec compliant speedups are allowed (AV_CODEC_FLAG2_FAST).
+	@li "draft"     like "preview", additionally decodes at half resolution if libavcodec supports a reduced resolution for the
+	                codec (lowres). As this is chosen when the decoder is opened, it only applies if "draft" is set before.
+*/
+#define FFMPEG_VID_DEC_OPT_QUALITY "quality"
+
+/*!
+	FFMPEG_VID_DEC_OPT_RESYNC
+	@brief error policy, can be changed at any time.\n
+	@li "off"       (default) libavcodec conceals errors and continues with the next access unit, errors may propagate
+	                through references until the decoder recovers by itself.
+	@li "key"       after a decoding error or a picture with concealed errors or missing references, the decoder is
+	                flushed, its pending pictures and access units up to the next key picture (HEVC IRAP, AVC IDR and
+	                recovery point pictures) are dropped, parameter sets are still decoded. Pictures with concealed errors
+	                are not output. The event is logged with its duration when the first picture after the key picture is
+	                decoded, and counted in dvpd_input_dec_stats_t::resyncs, resync_packets_dropped and resync_time_us.
+	Not applied with FFMPEG_VID_DEC_OPT_GOP_PARALLEL.
+*/
+#define FFMPEG_VID_DEC_OPT_RESYNC "resync"
+
+/*!
+	FFMPEG_VID_DEC_OPT_INPUT
+	@brief unit of the bitstream data passed to dvpd_input_dec_if_t::decode and decode_batch.\n
+	@li "access_unit"  (default) every call passes exactly one access unit.
+	@li "stream"       calls pass Annex-B byte stream chunks of any size, e.g. plain file reads, which the plugin splits
+	                   into access units. The timestamps of a chunk belong to the first access unit starting in it. The
+	                   other access units get an interpolated decoding timestamp and no presentation timestamp, their
+	                   pictures are output with the best effort timestamp of libavcodec. Chunks without timestamps
+	                   pass AV_NOPTS_VALUE. dvpd_input_dec_if_t::flush passes on the last access unit.
+*/
+#define FFMPEG_VID_DEC_OPT_INPUT "input"
+
+/*!
+	FFMPEG_VID_DEC_OPT_GOP_PARALLEL
+	@brief number of GOPs decoded at the same time, for offline decoding of files. Defaults to "0", off.\n
+	The access units are split into segments at key pictures (HEVC: IDR, BLA and CRA pictures, AVC: IDR pictures). Up
+	to the given number of segments are decoded on independent decoders, each with its share of
+	FFMPEG_VID_DEC_OPT_THREADS, and their pictures are output segment by segment in stream order. The output is bit
+	exact with a single decoder for streams whose segments decode independently: a CRA picture followed by RASL
+	pictures continues the previous segment, AVC streams need IDR pictures. The pictures of a segment are output once
+	the whole segment has been decoded, so the delay and the memory grow with the GOP length; decode() blocks while the
+	given number of segments is decoded or waits for output. Pictures are output on the thread calling decode() and
+	flush(). FFMPEG_VID_DEC_OPT_DECODE_MODE, FFMPEG_VID_DEC_OPT_QUALITY, FFMPEG_VID_DEC_OPT_MEMORY_LIMIT,
+	FFMPEG_VID_DEC_OPT_MEMORY_BUDGET and FFMPEG_VID_DEC_OPT_ASYNC do not apply, FFMPEG_VID_DEC_OPT_DUAL_LAYER is not supported. Requires libavcodec 57.48.101.
+*/
+#define FFMPEG_VID_DEC_OPT_GOP_PARALLEL "gop_parallel"
+
+/*!
+	FFMPEG_VID_DEC_OPT_HASH
+	@brief per picture hash for bit exact verification.\n
+	Every plane of a decoded picture is hashed as output by libavcodec, before the output format conversion, with the 64
+	bit XXH3 hash over its visible rows: the padding of the stride is excluded and samples of more than 8 bits are hashed
+	as the 16 bit little endian words of the pixel format. The hash of a plane equals the XXH3 hash of a raw dump of the
+	plane. The hash uses the instruction set of FFMPEG_VID_DEC_OPT_SIMD, all instruction sets give the same hash.
+	@li "off"       (default) no hashing.
+	@li "on"        the hashes are passed in ffmpeg_vid_dec_picture_info_t::plane_hash.
+*/
+#define FFMPEG_VID_DEC_OPT_HASH "hash"
+
+/*!
+	FFMPEG_VID_DEC_OPT_HASH_LOG
+	@brief path of a text file the plane hashes of every decoded picture are written to, implies FFMPEG_VID_DEC_OPT_HASH
+	"on". Defaults to "", no log.\n
+	The file is created by dvpd_input_dec_if_t::init. After a comment line starting with '#', every picture adds a line
+	in output order: the index of the picture, its timestamp, width x height, the pixel format of libavcodec and the
+	hash of every plane as 16 hexadecimal digits. FFmpegVidDecHashCompare compares two logs.
+*/
+#define FFMPEG_VID_DEC_OPT_HASH_LOG "hash_log"
+
+/*
+ * Read-only properties, available with dvpd_input_dec_if_t::get_option besides the options FFMPEG_VID_DEC_OPT_DECODE_MODE,
+ * FFMPEG_VID_DEC_OPT_QUALITY and FFMPEG_VID_DEC_OPT_THREADS, which return the value in effect.
+ */
+
+/*!
+	FFMPEG_VID_DEC_INFO_LATENCY_FRAMES
+	@brief number of access units the decoder currently holds before it outputs the picture of an access unit: the
+	reorder delay of the stream plus one per additional frame thread. "0" until the decoder is opened.\n
+*/
+#define FFMPEG_VID_DEC_INFO_LATENCY_FRAMES "latency_frames"
+
+/*!
+	FFMPEG_VID_DEC_INFO_SPEED
+	@brief decoding speed in percent of real time, the pictures decoded per second of time spent in the decoder (without
+	the picture callbacks) over the frame rate of the stream, measured over about a second of the stream. "0" while
+	unknown. FFMPEG_VID_DEC_OPT_THREADS returns the thread count in effect.\n
+*/
+#define FFMPEG_VID_DEC_INFO_SPEED "speed"
+
+/*!
+	FFMPEG_VID_DEC_INFO_MEMORY_FRAMES, FFMPEG_VID_DEC_INFO_MEMORY_PACKETS, FFMPEG_VID_DEC_INFO_MEMORY_THREADS
+	@brief bytes of frame buffers (estimated without the frame pool), packet buffers and (estimated) thread contexts
+	accounted to the instance. The sum is
+	reported as dvpd_input_dec_stats_t::memory_bytes.\n
+*/
+#define FFMPEG_VID_DEC_INFO_MEMORY_FRAMES "memory_frames"
+#define FFMPEG_VID_DEC_INFO_MEMORY_PACKETS "memory_packets"
+#define FFMPEG_VID_DEC_INFO_MEMORY_THREADS "memory_threads"
+
+/*!
+	FFMPEG_VID_DEC_INFO_MEMORY_PROCESS, FFMPEG_VID_DEC_INFO_MEMORY_PROCESS_PEAK
+	@brief bytes accounted by all instances sharing the memory budget of the process (see FFMPEG_VID_DEC_OPT_MEMORY_BUDGET)
+	and the maximum since the first of them was initialized. "0" without such instances.\n
+*/
+#define FFMPEG_VID_DEC_INFO_MEMORY_PROCESS "memory_process"
+#define FFMPEG_VID_DEC_INFO_MEMORY_PROCESS_PEAK "memory_process_peak"
+
+/*
+ * Per picture metadata, passed as dvpd_input_dec_picture_t::app_specific_data of every decoded picture.
+ */
+
+#define FFMPEG_VID_DEC_PICTURE_INFO_RPU                 0x1 /**< @details rpu and rpu_size are valid */
+#define FFMPEG_VID_DEC_PICTURE_INFO_MASTERING_DISPLAY   0x2 /**< @details display_primaries ... min_display_mastering_luminance are valid */
+#define FFMPEG_VID_DEC_PICTURE_INFO_CONTENT_LIGHT       0x4 /**< @details max_content_light_level and max_pic_average_light_level are valid */
+#define FFMPEG_VID_DEC_PICTURE_INFO_HASH                0x8 /**< @details hash_planes and plane_hash are valid */
+
+/*!
+	ffmpeg_vid_dec_picture_info_t
+	@brief metadata of a decoded picture that would otherwise have to be parsed from the bitstream again.\n
+	The HDR values use the units of the SEI messages (H.265 D.3.28 and D.3.35), the colour description uses the code
+	points of the VUI (H.273), 2 meaning unspecified. The Dolby Vision RPU is only available with FFmpeg 5.0 and later.
+	A new sequence parameter set may change the size, bit depth or chroma format at a key picture. The decoder continues
+	without reinitialization and flags the first picture of the new format with format_change.
+*/
+	typedef struct
+	{
+		uint32_t size;                          /**< @details size of the structure, fields beyond size are not present */
+		uint32_t flags;                         /**< @details combination of FFMPEG_VID_DEC_PICTURE_INFO_* */
+
+		const uint8_t *rpu;                     /**< @details payload of the Dolby Vision RPU NAL unit of the access unit, with emulation prevention bytes */
+		uint32_t rpu_size;                      /**< @details length of rpu */
+
+		uint16_t display_primaries[ 3 ][ 2 ];   /**< @details x and y of the red, green and blue primaries of the mastering display in units of 0.00002 */
+		uint16_t white_point[ 2 ];              /**< @details x and y of the white point of the mastering display in units of 0.00002 */
+		uint32_t max_display_mastering_luminance; /**< @details in units of 0.0001 cd/m2 */
+		uint32_t min_display_mastering_luminance; /**< @details in units of 0.0001 cd/m2 */
+		uint16_t max_content_light_level;       /**< @details MaxCLL in cd/m2 */
+		uint16_t max_pic_average_light_level;   /**< @details MaxFALL in cd/m2 */
+
+		int32_t profile;                        /**< @details profile_idc of the active sequence parameter set, -1 if unknown */
+		int32_t level;                          /**< @details level_idc of the active sequence parameter set, -1 if unknown */
+		int32_t coded_width;                    /**< @details width of the decoded picture before cropping */
+		int32_t coded_height;                   /**< @details height of the decoded picture before cropping */
+		int32_t sar_width;                      /**< @details sample aspect ratio, 0 if unknown */
+		int32_t sar_height;                     /**< @details sample aspect ratio, 0 if unknown */
+		uint8_t colour_primaries;               /**< @details colour_primaries of the VUI */
+		uint8_t transfer_characteristics;       /**< @details transfer_characteristics of the VUI */
+		uint8_t matrix_coeffs;                  /**< @details matrix_coeffs of the VUI */
+		uint8_t video_full_range_flag;          /**< @details video_full_range_flag of the VUI */
+		int8_t chroma_sample_loc_type;          /**< @details chroma_sample_loc_type of the VUI, -1 if not present */
+		uint8_t key_picture;                    /**< @details 1 for a key (IRAP or IDR) picture */
+		uint8_t format_change;                  /**< @details 1 for the first picture after a change of the picture size or pixel format within the stream */
+		uint32_t format_generation;             /**< @details number of format changes before the picture, pictures of one generation share size and format */
+		uint32_t hash_planes;                   /**< @details number of planes of the decoded picture */
+		uint64_t plane_hash[ 4 ];               /**< @details hash of every plane of the decoded picture, see FFMPEG_VID_DEC_OPT_HASH */
+	} ffmpeg_vid_dec_picture_info_t;
+
+#endif // __FFMPEG_VID_DEC_PLUGIN_H_
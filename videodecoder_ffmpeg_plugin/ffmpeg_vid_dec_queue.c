@@ -0,0 +1,183 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_queue.h"
+
+bool work_queue_init( work_queue_t* queue, int32_t capacity )
+{
+	memset( queue, 0, sizeof( work_queue_t ) );
+
+	if( capacity < 1 )
+	{
+		return false;
+	}
+
+	queue->items = ( void** )malloc( sizeof( void* ) * capacity );
+	if( queue->items == NULL )
+	{
+		return false;
+	}
+
+	queue->capacity = capacity;
+
+	vid_dec_mutex_init( &queue->mutex );
+	vid_dec_cond_init( &queue->not_full );
+	vid_dec_cond_init( &queue->not_empty );
+
+	return true;
+}
+
+void work_queue_uninit( work_queue_t* queue )
+{
+	if( queue->items == NULL )
+	{
+		return;
+	}
+
+	vid_dec_cond_destroy( &queue->not_empty );
+	vid_dec_cond_destroy( &queue->not_full );
+	vid_dec_mutex_destroy( &queue->mutex );
+
+	free( queue->items );
+	queue->items = NULL;
+}
+
+void work_queue_push( work_queue_t* queue, void* item )
+{
+	int64_t tail = vid_dec_atomic_load64( &queue->tail );
+
+	if( tail - vid_dec_atomic_load64( &queue->head ) >= queue->capacity )
+	{
+		vid_dec_mutex_lock( &queue->mutex );
+		// the flag is raised before the re-check, so the consumer either sees it or the producer sees the free slot
+		vid_dec_atomic_store32( &queue->producer_waiting, 1 );
+		while( tail - vid_dec_atomic_load64( &queue->head ) >= queue->capacity )
+		{
+			vid_dec_cond_wait( &queue->not_full, &queue->mutex );
+		}
+		vid_dec_atomic_store32( &queue->producer_waiting, 0 );
+		vid_dec_mutex_unlock( &queue->mutex );
+	}
+
+	queue->items[ tail % queue->capacity ] = item;
+	vid_dec_atomic_store64( &queue->tail, tail + 1 );
+
+	if( vid_dec_atomic_load32( &queue->consumer_waiting ) != 0 )
+	{
+		vid_dec_mutex_lock( &queue->mutex );
+		vid_dec_cond_signal( &queue->not_empty );
+		vid_dec_mutex_unlock( &queue->mutex );
+	}
+}
+
+void work_queue_push_n( work_queue_t* queue, void** items, int32_t count )
+{
+	int64_t tail = vid_dec_atomic_load64( &queue->tail );
+
+	while( count > 0 )
+	{
+		int64_t free_slots = queue->capacity - ( tail - vid_dec_atomic_load64( &queue->head ) );
+
+		if( free_slots <= 0 )
+		{
+			vid_dec_mutex_lock( &queue->mutex );
+			vid_dec_atomic_store32( &queue->producer_waiting, 1 );
+			while( tail - vid_dec_atomic_load64( &queue->head ) >= queue->capacity )
+			{
+				vid_dec_cond_wait( &queue->not_full, &queue->mutex );
+			}
+			vid_dec_atomic_store32( &queue->producer_waiting, 0 );
+			vid_dec_mutex_unlock( &queue->mutex );
+			continue;
+		}
+
+		if( free_slots > count )
+		{
+			free_slots = count;
+		}
+
+		for( int64_t i = 0; i < free_slots; i++ )
+		{
+			queue->items[ ( tail + i ) % queue->capacity ] = items[ i ];
+		}
+
+		tail += free_slots;
+		items += free_slots;
+		count -= ( int32_t )free_slots;
+		vid_dec_atomic_store64( &queue->tail, tail );
+
+		if( vid_dec_atomic_load32( &queue->consumer_waiting ) != 0 )
+		{
+			vid_dec_mutex_lock( &queue->mutex );
+			vid_dec_cond_signal( &queue->not_empty );
+			vid_dec_mutex_unlock( &queue->mutex );
+		}
+	}
+}
+
+void* work_queue_pop( work_queue_t* queue )
+{
+	int64_t head = vid_dec_atomic_load64( &queue->head );
+	void* item;
+
+	if( vid_dec_atomic_load64( &queue->tail ) == head )
+	{
+		vid_dec_mutex_lock( &queue->mutex );
+		vid_dec_atomic_store32( &queue->consumer_waiting, 1 );
+		while( vid_dec_atomic_load64( &queue->tail ) == head )
+		{
+			vid_dec_cond_wait( &queue->not_empty, &queue->mutex );
+		}
+		vid_dec_atomic_store32( &queue->consumer_waiting, 0 );
+		vid_dec_mutex_unlock( &queue->mutex );
+	}
+
+	item = queue->items[ head % queue->capacity ];
+	vid_dec_atomic_store64( &queue->head, head + 1 );
+
+	if( vid_dec_atomic_load32( &queue->producer_waiting ) != 0 )
+	{
+		vid_dec_mutex_lock( &queue->mutex );
+		vid_dec_cond_signal( &queue->not_full );
+		vid_dec_mutex_unlock( &queue->mutex );
+	}
+
+	return item;
+}
+
+int32_t work_queue_size( work_queue_t* queue )
+{
+	return ( int32_t )( vid_dec_atomic_load64( &queue->tail ) - vid_dec_atomic_load64( &queue->head ) );
+}
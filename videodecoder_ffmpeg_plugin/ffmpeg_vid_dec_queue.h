@@ -0,0 +1,89 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief bounded single producer, single consumer work queue of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_queue.h
+*
+* Items are passed through a lock-free ring buffer. The mutex and condition variables are only used
+* to put the producer to sleep while the queue is full and the consumer while it is empty.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_QUEUE_H_
+#define __FFMPEG_VID_DEC_QUEUE_H_
+
+#include "ffmpeg_vid_dec_thread.h"
+
+typedef struct
+{
+	void **items;
+	int64_t capacity;
+
+	volatile int64_t head;
+	volatile int64_t tail;
+	volatile int32_t producer_waiting;
+	volatile int32_t consumer_waiting;
+
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t not_full;
+	vid_dec_cond_t not_empty;
+} work_queue_t;
+
+bool work_queue_init( work_queue_t* queue, int32_t capacity );
+void work_queue_uninit( work_queue_t* queue );
+
+/*!
+	work_queue_push
+	@brief appends an item, blocks while the queue is full.\n
+*/
+void work_queue_push( work_queue_t* queue, void* item );
+
+/*!
+	work_queue_push_n
+	@brief appends count items in order, publishing as many at once as there are free slots. Blocks while the queue is full.\n
+*/
+void work_queue_push_n( work_queue_t* queue, void** items, int32_t count );
+
+/*!
+	work_queue_pop
+	@brief removes the oldest item, blocks while the queue is empty.\n
+*/
+void* work_queue_pop( work_queue_t* queue );
+
+/*!
+	work_queue_size
+	@brief returns the number of queued items.\n
+*/
+int32_t work_queue_size( work_queue_t* queue );
+
+#endif // __FFMPEG_VID_DEC_QUEUE_H_
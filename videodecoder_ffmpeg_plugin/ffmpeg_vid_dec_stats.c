@@ -0,0 +1,116 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_stats.h"
+
+void dec_stats_reset( dec_stats_t* stats )
+{
+	memset( ( void* )stats, 0, sizeof( dec_stats_t ) );
+}
+
+void dec_stats_add_time( volatile int64_t* total, volatile int64_t* histogram, int64_t time_us )
+{
+	int32_t bucket = 0;
+
+	if( time_us < 0 )
+	{
+		time_us = 0;
+	}
+
+	dec_stats_add( total, time_us );
+
+	while( time_us > 0 && bucket < DVPD_INPUT_DEC_LATENCY_BUCKETS - 1 )
+	{
+		time_us >>= 1;
+		bucket++;
+	}
+
+	dec_stats_add( &histogram[ bucket ], 1 );
+}
+
+static void read_counters( volatile int64_t* counters, int64_t* out, int32_t count )
+{
+	for( int32_t i = 0; i < count; i++ )
+	{
+		out[ i ] = vid_dec_atomic_load64( &counters[ i ] );
+	}
+}
+
+bool dec_stats_read( dec_stats_t* stats, dvpd_input_dec_stats_t* out )
+{
+	dvpd_input_dec_stats_t snapshot;
+	uint32_t size = out->size;
+
+	// older callers may pass a shorter structure, but it has to hold at least the first counter
+	if( size < offsetof( dvpd_input_dec_stats_t, packets_in ) + sizeof( int64_t ) )
+	{
+		return false;
+	}
+
+	memset( &snapshot, 0, sizeof( snapshot ) );
+
+	snapshot.packets_in = vid_dec_atomic_load64( &stats->packets_in );
+	snapshot.bytes_in = vid_dec_atomic_load64( &stats->bytes_in );
+	snapshot.packets_discarded = vid_dec_atomic_load64( &stats->packets_discarded );
+	snapshot.packets_decoded = vid_dec_atomic_load64( &stats->packets_decoded );
+	snapshot.bytes_decoded = vid_dec_atomic_load64( &stats->bytes_decoded );
+	snapshot.send_errors = vid_dec_atomic_load64( &stats->send_errors );
+	snapshot.receive_errors = vid_dec_atomic_load64( &stats->receive_errors );
+	snapshot.frames_decoded = vid_dec_atomic_load64( &stats->frames_decoded );
+	snapshot.frames_out = vid_dec_atomic_load64( &stats->frames_out );
+	read_counters( stats->frames_dropped, snapshot.frames_dropped, DVPD_INPUT_DEC_DROP_COUNT );
+	snapshot.decode_time_us = vid_dec_atomic_load64( &stats->decode_time_us );
+	snapshot.callback_time_us = vid_dec_atomic_load64( &stats->callback_time_us );
+	read_counters( stats->decode_latency, snapshot.decode_latency, DVPD_INPUT_DEC_LATENCY_BUCKETS );
+	read_counters( stats->callback_latency, snapshot.callback_latency, DVPD_INPUT_DEC_LATENCY_BUCKETS );
+	snapshot.frames_skipped = vid_dec_atomic_load64( &stats->frames_skipped );
+	snapshot.memory_bytes = vid_dec_atomic_load64( &stats->memory_frames ) + vid_dec_atomic_load64( &stats->memory_packets ) +
+		vid_dec_atomic_load64( &stats->memory_threads );
+	snapshot.memory_peak_bytes = vid_dec_atomic_load64( &stats->memory_peak_bytes );
+	snapshot.resyncs = vid_dec_atomic_load64( &stats->resyncs );
+	snapshot.resync_packets_dropped = vid_dec_atomic_load64( &stats->resync_packets_dropped );
+	snapshot.resync_time_us = vid_dec_atomic_load64( &stats->resync_time_us );
+	snapshot.format_changes = vid_dec_atomic_load64( &stats->format_changes );
+
+	if( size > sizeof( dvpd_input_dec_stats_t ) )
+	{
+		size = sizeof( dvpd_input_dec_stats_t );
+	}
+
+	snapshot.size = size;
+	memcpy( out, &snapshot, size );
+
+	return true;
+}
@@ -0,0 +1,98 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief per instance performance counters of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_stats.h
+*
+* Counters are updated with atomic additions by the threads decoding and delivering pictures, and read by
+* get_stats from any thread without stopping the decoder.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_STATS_H_
+#define __FFMPEG_VID_DEC_STATS_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+typedef struct
+{
+	volatile int64_t packets_in;
+	volatile int64_t bytes_in;
+	volatile int64_t packets_discarded;
+	volatile int64_t packets_decoded;
+	volatile int64_t bytes_decoded;
+	volatile int64_t send_errors;
+	volatile int64_t receive_errors;
+	volatile int64_t frames_decoded;
+	volatile int64_t frames_out;
+	volatile int64_t frames_dropped[ DVPD_INPUT_DEC_DROP_COUNT ];
+	volatile int64_t decode_time_us;
+	volatile int64_t callback_time_us;
+	volatile int64_t decode_latency[ DVPD_INPUT_DEC_LATENCY_BUCKETS ];
+	volatile int64_t callback_latency[ DVPD_INPUT_DEC_LATENCY_BUCKETS ];
+	volatile int64_t frames_skipped;
+	volatile int64_t memory_frames;
+	volatile int64_t memory_packets;
+	volatile int64_t memory_threads;
+	volatile int64_t memory_peak_bytes;
+	volatile int64_t resyncs;
+	volatile int64_t resync_packets_dropped;
+	volatile int64_t resync_time_us;
+	volatile int64_t format_changes;
+} dec_stats_t;
+
+static inline void dec_stats_add( volatile int64_t* counter, int64_t value )
+{
+	vid_dec_atomic_add64( counter, value );
+}
+
+/*!
+	dec_stats_reset
+	@brief sets all counters to zero. Must not race with updates of the counters.\n
+*/
+void dec_stats_reset( dec_stats_t* stats );
+
+/*!
+	dec_stats_add_time
+	@brief adds a duration to a total and the matching bucket of its latency histogram.\n
+*/
+void dec_stats_add_time( volatile int64_t* total, volatile int64_t* histogram, int64_t time_us );
+
+/*!
+	dec_stats_read
+	@brief copies the counters to the members of out within out->size. Returns false if size is too small.\n
+*/
+bool dec_stats_read( dec_stats_t* stats, dvpd_input_dec_stats_t* out );
+
+#endif // __FFMPEG_VID_DEC_STATS_H_
@@ -0,0 +1,170 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief portable threading primitives used by the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_thread.h
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_THREAD_H_
+#define __FFMPEG_VID_DEC_THREAD_H_
+
+#include <stdint.h>
+#include "dvpd_vid_dec_plugin.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define inline __inline
+#endif
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+#if defined(_WIN32)
+typedef CRITICAL_SECTION vid_dec_mutex_t;
+
+static inline void vid_dec_mutex_init( vid_dec_mutex_t* mutex ) { InitializeCriticalSection( mutex ); }
+static inline void vid_dec_mutex_destroy( vid_dec_mutex_t* mutex ) { DeleteCriticalSection( mutex ); }
+static inline void vid_dec_mutex_lock( vid_dec_mutex_t* mutex ) { EnterCriticalSection( mutex ); }
+static inline void vid_dec_mutex_unlock( vid_dec_mutex_t* mutex ) { LeaveCriticalSection( mutex ); }
+
+typedef CONDITION_VARIABLE vid_dec_cond_t;
+
+static inline void vid_dec_cond_init( vid_dec_cond_t* cond ) { InitializeConditionVariable( cond ); }
+static inline void vid_dec_cond_destroy( vid_dec_cond_t* cond ) { ( void )cond; }
+static inline void vid_dec_cond_wait( vid_dec_cond_t* cond, vid_dec_mutex_t* mutex ) { SleepConditionVariableCS( cond, mutex, INFINITE ); }
+static inline bool vid_dec_cond_timedwait( vid_dec_cond_t* cond, vid_dec_mutex_t* mutex, int32_t timeout_ms ) { return SleepConditionVariableCS( cond, mutex, ( DWORD )timeout_ms ) != 0; }
+static inline void vid_dec_cond_signal( vid_dec_cond_t* cond ) { WakeConditionVariable( cond ); }
+static inline void vid_dec_cond_broadcast( vid_dec_cond_t* cond ) { WakeAllConditionVariable( cond ); }
+
+typedef HANDLE vid_dec_thread_t;
+typedef LPTHREAD_START_ROUTINE vid_dec_thread_func_t;
+#define VID_DEC_THREAD_FUNC( name, arg ) DWORD WINAPI name( LPVOID arg )
+#define VID_DEC_THREAD_EXIT 0
+
+static inline bool vid_dec_thread_create( vid_dec_thread_t* thread, vid_dec_thread_func_t func, void* arg ) { *thread = CreateThread( NULL, 0, func, arg, 0, NULL ); return *thread != NULL; }
+static inline void vid_dec_thread_join( vid_dec_thread_t thread ) { WaitForSingleObject( thread, INFINITE ); CloseHandle( thread ); }
+static inline void vid_dec_thread_yield( void ) { SwitchToThread( ); }
+
+static inline int64_t vid_dec_atomic_add64( volatile int64_t* value, int64_t add ) { return InterlockedExchangeAdd64( ( volatile LONG64* )value, add ) + add; }
+static inline int64_t vid_dec_atomic_load64( volatile int64_t* value ) { return InterlockedCompareExchange64( ( volatile LONG64* )value, 0, 0 ); }
+static inline void vid_dec_atomic_store64( volatile int64_t* value, int64_t store ) { InterlockedExchange64( ( volatile LONG64* )value, store ); }
+static inline int32_t vid_dec_atomic_add32( volatile int32_t* value, int32_t add ) { return InterlockedExchangeAdd( ( volatile LONG* )value, add ) + add; }
+static inline int32_t vid_dec_atomic_load32( volatile int32_t* value ) { return InterlockedCompareExchange( ( volatile LONG* )value, 0, 0 ); }
+static inline void vid_dec_atomic_store32( volatile int32_t* value, int32_t store ) { InterlockedExchange( ( volatile LONG* )value, store ); }
+static inline bool vid_dec_atomic_cas64( volatile int64_t* value, int64_t expected, int64_t desired ) { return InterlockedCompareExchange64( ( volatile LONG64* )value, desired, expected ) == expected; }
+static inline bool vid_dec_atomic_cas32( volatile int32_t* value, int32_t expected, int32_t desired ) { return InterlockedCompareExchange( ( volatile LONG* )value, desired, expected ) == expected; }
+#else
+typedef pthread_mutex_t vid_dec_mutex_t;
+
+static inline void vid_dec_mutex_init( vid_dec_mutex_t* mutex ) { pthread_mutex_init( mutex, NULL ); }
+static inline void vid_dec_mutex_destroy( vid_dec_mutex_t* mutex ) { pthread_mutex_destroy( mutex ); }
+static inline void vid_dec_mutex_lock( vid_dec_mutex_t* mutex ) { pthread_mutex_lock( mutex ); }
+static inline void vid_dec_mutex_unlock( vid_dec_mutex_t* mutex ) { pthread_mutex_unlock( mutex ); }
+
+typedef pthread_cond_t vid_dec_cond_t;
+
+static inline void vid_dec_cond_init( vid_dec_cond_t* cond ) { pthread_cond_init( cond, NULL ); }
+static inline void vid_dec_cond_destroy( vid_dec_cond_t* cond ) { pthread_cond_destroy( cond ); }
+static inline void vid_dec_cond_wait( vid_dec_cond_t* cond, vid_dec_mutex_t* mutex ) { pthread_cond_wait( cond, mutex ); }
+static inline void vid_dec_cond_signal( vid_dec_cond_t* cond ) { pthread_cond_signal( cond ); }
+static inline void vid_dec_cond_broadcast( vid_dec_cond_t* cond ) { pthread_cond_broadcast( cond ); }
+
+static inline bool vid_dec_cond_timedwait( vid_dec_cond_t* cond, vid_dec_mutex_t* mutex, int32_t timeout_ms )
+{
+	struct timespec deadline;
+
+	clock_gettime( CLOCK_REALTIME, &deadline );
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += ( long )( timeout_ms % 1000 ) * 1000000;
+	if( deadline.tv_nsec >= 1000000000 )
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	return pthread_cond_timedwait( cond, mutex, &deadline ) == 0;
+}
+
+typedef pthread_t vid_dec_thread_t;
+typedef void* ( *vid_dec_thread_func_t )( void* );
+#define VID_DEC_THREAD_FUNC( name, arg ) void* name( void* arg )
+#define VID_DEC_THREAD_EXIT NULL
+
+static inline bool vid_dec_thread_create( vid_dec_thread_t* thread, vid_dec_thread_func_t func, void* arg ) { return pthread_create( thread, NULL, func, arg ) == 0; }
+static inline void vid_dec_thread_join( vid_dec_thread_t thread ) { pthread_join( thread, NULL ); }
+static inline void vid_dec_thread_yield( void ) { sched_yield( ); }
+
+static inline int64_t vid_dec_atomic_add64( volatile int64_t* value, int64_t add ) { return __atomic_add_fetch( value, add, __ATOMIC_SEQ_CST ); }
+static inline int64_t vid_dec_atomic_load64( volatile int64_t* value ) { return __atomic_load_n( value, __ATOMIC_SEQ_CST ); }
+static inline void vid_dec_atomic_store64( volatile int64_t* value, int64_t store ) { __atomic_store_n( value, store, __ATOMIC_SEQ_CST ); }
+static inline int32_t vid_dec_atomic_add32( volatile int32_t* value, int32_t add ) { return __atomic_add_fetch( value, add, __ATOMIC_SEQ_CST ); }
+static inline int32_t vid_dec_atomic_load32( volatile int32_t* value ) { return __atomic_load_n( value, __ATOMIC_SEQ_CST ); }
+static inline void vid_dec_atomic_store32( volatile int32_t* value, int32_t store ) { __atomic_store_n( value, store, __ATOMIC_SEQ_CST ); }
+static inline bool vid_dec_atomic_cas64( volatile int64_t* value, int64_t expected, int64_t desired ) { return __atomic_compare_exchange_n( value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ); }
+static inline bool vid_dec_atomic_cas32( volatile int32_t* value, int32_t expected, int32_t desired ) { return __atomic_compare_exchange_n( value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ); }
+#endif
+
+static inline void vid_dec_atomic_max64( volatile int64_t* value, int64_t candidate )
+{
+	int64_t current = vid_dec_atomic_load64( value );
+
+	while( candidate > current && vid_dec_atomic_cas64( value, current, candidate ) == false )
+	{
+		current = vid_dec_atomic_load64( value );
+	}
+}
+
+/*
+ * statically initialized lock for short critical sections on process wide state
+ */
+typedef volatile int32_t vid_dec_spinlock_t;
+#define VID_DEC_SPINLOCK_INIT 0
+
+static inline void vid_dec_spin_lock( vid_dec_spinlock_t* lock )
+{
+	while( vid_dec_atomic_cas32( lock, 0, 1 ) == false )
+	{
+		vid_dec_thread_yield( );
+	}
+}
+
+static inline void vid_dec_spin_unlock( vid_dec_spinlock_t* lock )
+{
+	vid_dec_atomic_store32( lock, 0 );
+}
+
+#endif // __FFMPEG_VID_DEC_THREAD_H_
@@ -0,0 +1,338 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ffmpeg_vid_dec_thread_pool.h"
+#include "ffmpeg_vid_dec_thread.h"
+
+typedef struct batch_s_
+{
+	struct batch_s_ *next;
+
+	thread_pool_job_func_t func;
+	void *arg;
+	int *ret;
+	int32_t count;
+	volatile int32_t next_job;
+	int32_t slots;
+	int32_t participants;               /**< @details threads that joined the batch, the next slot */
+	int32_t active;                     /**< @details threads still working on the batch */
+} batch_t;
+
+typedef struct
+{
+	thread_pool_t *pool;
+	vid_dec_thread_t thread;
+} pool_worker_t;
+
+struct thread_pool_s_
+{
+	vid_dec_mutex_t mutex;
+	vid_dec_cond_t work;
+	vid_dec_cond_t left;
+	batch_t *batches;                   /**< @details running batches */
+	bool stop;
+
+	pool_worker_t *workers;
+	int32_t worker_count;
+};
+
+typedef struct
+{
+	AVCodecContext *av_codec_ctx;
+	int( *func )( AVCodecContext* c2, void* arg );
+	int( *func2 )( AVCodecContext* c2, void* arg, int jobnr, int threadnr );
+	uint8_t *arg;
+	int size;
+} codec_batch_t;
+
+static vid_dec_spinlock_t shared_lock = VID_DEC_SPINLOCK_INIT;
+static thread_pool_t *shared_pool = NULL;
+static int32_t shared_users = 0;
+
+static void run_jobs( batch_t* batch, int32_t slot )
+{
+	int32_t job;
+
+	while( ( job = vid_dec_atomic_add32( &batch->next_job, 1 ) - 1 ) < batch->count )
+	{
+		int result = batch->func( batch->arg, job, slot );
+
+		if( batch->ret != NULL )
+		{
+			batch->ret[ job ] = result;
+		}
+	}
+}
+
+/*
+ * returns the batch with jobs left and a free slot that has the fewest participants. Called with the mutex held.
+ */
+static batch_t* find_batch( thread_pool_t* pool )
+{
+	batch_t* found = NULL;
+
+	for( batch_t* batch = pool->batches; batch != NULL; batch = batch->next )
+	{
+		if( batch->participants < batch->slots && vid_dec_atomic_load32( &batch->next_job ) < batch->count &&
+			( found == NULL || batch->participants < found->participants ) )
+		{
+			found = batch;
+		}
+	}
+
+	return found;
+}
+
+static VID_DEC_THREAD_FUNC( pool_worker, arg )
+{
+	thread_pool_t* pool = ( ( pool_worker_t* )arg )->pool;
+
+	vid_dec_mutex_lock( &pool->mutex );
+
+	while( pool->stop == false )
+	{
+		batch_t* batch = find_batch( pool );
+		int32_t slot;
+
+		if( batch == NULL )
+		{
+			vid_dec_cond_wait( &pool->work, &pool->mutex );
+			continue;
+		}
+
+		slot = batch->participants++;
+		batch->active++;
+		vid_dec_mutex_unlock( &pool->mutex );
+
+		run_jobs( batch, slot );
+
+		vid_dec_mutex_lock( &pool->mutex );
+		if( --batch->active == 0 )
+		{
+			vid_dec_cond_broadcast( &pool->left );
+		}
+	}
+
+	vid_dec_mutex_unlock( &pool->mutex );
+
+	return VID_DEC_THREAD_EXIT;
+}
+
+thread_pool_t* thread_pool_create( int32_t threads )
+{
+	thread_pool_t* pool;
+
+	pool = ( thread_pool_t* )malloc( sizeof( thread_pool_t ) );
+	if( pool == NULL )
+	{
+		return NULL;
+	}
+
+	memset( pool, 0, sizeof( thread_pool_t ) );
+
+	vid_dec_mutex_init( &pool->mutex );
+	vid_dec_cond_init( &pool->work );
+	vid_dec_cond_init( &pool->left );
+
+	pool->workers = ( pool_worker_t* )calloc( threads > 0 ? threads : 1, sizeof( pool_worker_t ) );
+	if( pool->workers == NULL )
+	{
+		thread_pool_release( &pool );
+		return NULL;
+	}
+
+	for( ; pool->worker_count < threads; pool->worker_count++ )
+	{
+		pool_worker_t* worker = &pool->workers[ pool->worker_count ];
+
+		worker->pool = pool;
+		if( vid_dec_thread_create( &worker->thread, pool_worker, worker ) == false )
+		{
+			thread_pool_release( &pool );
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+void thread_pool_release( thread_pool_t** pool )
+{
+	if( pool == NULL || *pool == NULL )
+	{
+		return;
+	}
+
+	vid_dec_mutex_lock( &( *pool )->mutex );
+	( *pool )->stop = true;
+	vid_dec_cond_broadcast( &( *pool )->work );
+	vid_dec_mutex_unlock( &( *pool )->mutex );
+
+	for( int32_t i = 0; i < ( *pool )->worker_count; i++ )
+	{
+		vid_dec_thread_join( ( *pool )->workers[ i ].thread );
+	}
+
+	vid_dec_cond_destroy( &( *pool )->left );
+	vid_dec_cond_destroy( &( *pool )->work );
+	vid_dec_mutex_destroy( &( *pool )->mutex );
+	free( ( *pool )->workers );
+	free( *pool );
+	*pool = NULL;
+}
+
+void thread_pool_run( thread_pool_t* pool, thread_pool_job_func_t func, void* arg, int* ret, int32_t count, int32_t slots )
+{
+	batch_t batch;
+
+	memset( &batch, 0, sizeof( batch_t ) );
+	batch.func = func;
+	batch.arg = arg;
+	batch.ret = ret;
+	batch.count = count;
+	batch.slots = slots;
+	batch.participants = 1;
+	batch.active = 1;
+
+	// a single job or slot is not worth waking a worker
+	if( pool == NULL || pool->worker_count == 0 || count < 2 || slots < 2 )
+	{
+		run_jobs( &batch, 0 );
+		return;
+	}
+
+	vid_dec_mutex_lock( &pool->mutex );
+	batch.next = pool->batches;
+	pool->batches = &batch;
+	vid_dec_cond_broadcast( &pool->work );
+	vid_dec_mutex_unlock( &pool->mutex );
+
+	run_jobs( &batch, 0 );
+
+	// all jobs have started, the workers still running some must leave the batch before it goes out of scope
+	vid_dec_mutex_lock( &pool->mutex );
+	for( batch_t** link = &pool->batches; *link != NULL; link = &( *link )->next )
+	{
+		if( *link == &batch )
+		{
+			*link = batch.next;
+			break;
+		}
+	}
+
+	batch.active--;
+	while( batch.active > 0 )
+	{
+		vid_dec_cond_wait( &pool->left, &pool->mutex );
+	}
+	vid_dec_mutex_unlock( &pool->mutex );
+}
+
+thread_pool_t* thread_pool_share( int32_t threads )
+{
+	thread_pool_t* pool;
+
+	vid_dec_spin_lock( &shared_lock );
+
+	if( shared_pool == NULL )
+	{
+		shared_pool = thread_pool_create( threads );
+	}
+
+	pool = shared_pool;
+	if( pool != NULL )
+	{
+		shared_users++;
+	}
+
+	vid_dec_spin_unlock( &shared_lock );
+
+	return pool;
+}
+
+void thread_pool_unshare( thread_pool_t** pool )
+{
+	thread_pool_t* unused = NULL;
+
+	if( pool == NULL || *pool == NULL )
+	{
+		return;
+	}
+
+	vid_dec_spin_lock( &shared_lock );
+
+	if( --shared_users == 0 )
+	{
+		unused = shared_pool;
+		shared_pool = NULL;
+	}
+
+	vid_dec_spin_unlock( &shared_lock );
+
+	// joining the workers happens outside of the lock
+	thread_pool_release( &unused );
+	*pool = NULL;
+}
+
+static int run_codec_job( void* arg, int32_t job, int32_t slot )
+{
+	codec_batch_t* batch = ( codec_batch_t* )arg;
+
+	if( batch->func2 != NULL )
+	{
+		return batch->func2( batch->av_codec_ctx, batch->arg, job, slot );
+	}
+
+	return batch->func( batch->av_codec_ctx, batch->arg + ( size_t )job * batch->size );
+}
+
+int thread_pool_execute( AVCodecContext* av_codec_ctx, int( *func )( AVCodecContext* c2, void* arg ), void* arg, int* ret, int count, int size )
+{
+	codec_batch_t batch = { av_codec_ctx, func, NULL, ( uint8_t* )arg, size };
+
+	// the codec keeps per thread state for thread_count threads
+	thread_pool_run( shared_pool, run_codec_job, &batch, ret, count, av_codec_ctx->thread_count );
+
+	return 0;
+}
+
+int thread_pool_execute2( AVCodecContext* av_codec_ctx, int( *func )( AVCodecContext* c2, void* arg, int jobnr, int threadnr ), void* arg, int* ret, int count )
+{
+	codec_batch_t batch = { av_codec_ctx, NULL, func, ( uint8_t* )arg, 0 };
+
+	thread_pool_run( shared_pool, run_codec_job, &batch, ret, count, av_codec_ctx->thread_count );
+
+	return 0;
+}
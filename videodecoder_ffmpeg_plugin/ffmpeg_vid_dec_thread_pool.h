@@ -0,0 +1,100 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+* @brief worker pool shared by the decoder instances of the FFmpeg video decoder plugin.
+* @file ffmpeg_vid_dec_thread_pool.h
+*
+* Slice threading of libavcodec splits the decoding of a picture into batches of jobs (slices, wavefront rows) and
+* runs them through the execute and execute2 callbacks of the codec context. Replacing these callbacks runs the
+* batches of all instances on one pool. The calling thread works on its own batch, idle workers of the pool steal the
+* remaining jobs of the batch with the fewest participants, so every busy instance gets an even share of the pool.
+* Jobs of a batch are started in order, which keeps dependencies on earlier jobs (wavefront rows) deadlock free, and
+* no more threads participate in a batch than the codec context has slice threads.
+*
+*/
+
+#ifndef __FFMPEG_VID_DEC_THREAD_POOL_H_
+#define __FFMPEG_VID_DEC_THREAD_POOL_H_
+
+#include "dvpd_vid_dec_plugin.h"
+#include <libavcodec/avcodec.h>
+
+typedef struct thread_pool_s_ thread_pool_t;
+
+/*!
+	thread_pool_job_func_t
+	@brief runs job number job of a batch. slot is unique among the threads working on the batch at the same time,
+	0 for the calling thread.\n
+*/
+typedef int( *thread_pool_job_func_t )( void* arg, int32_t job, int32_t slot );
+
+/*!
+	thread_pool_create
+	@brief creates a pool of the given number of worker threads.\n
+*/
+thread_pool_t* thread_pool_create( int32_t threads );
+
+/*!
+	thread_pool_release
+	@brief stops the workers and frees the pool. No batch may be running.\n
+*/
+void thread_pool_release( thread_pool_t** pool );
+
+/*!
+	thread_pool_run
+	@brief runs count jobs on the calling thread and up to slots - 1 workers of the pool. Returns after all jobs have
+	finished. ret receives the result of every job if not NULL.\n
+*/
+void thread_pool_run( thread_pool_t* pool, thread_pool_job_func_t func, void* arg, int* ret, int32_t count, int32_t slots );
+
+/*!
+	thread_pool_share
+	@brief returns the process wide pool, which is created with the given number of workers by its first user.\n
+*/
+thread_pool_t* thread_pool_share( int32_t threads );
+
+/*!
+	thread_pool_unshare
+	@brief releases the process wide pool, which is freed after its last user released it.\n
+*/
+void thread_pool_unshare( thread_pool_t** pool );
+
+/*!
+	thread_pool_execute, thread_pool_execute2
+	@brief AVCodecContext::execute and execute2 callbacks running the batches on the process wide pool. Only valid
+	while the instance of the context holds the process wide pool.\n
+*/
+int thread_pool_execute( AVCodecContext* av_codec_ctx, int( *func )( AVCodecContext* c2, void* arg ), void* arg, int* ret, int count, int size );
+int thread_pool_execute2( AVCodecContext* av_codec_ctx, int( *func )( AVCodecContext* c2, void* arg, int jobnr, int threadnr ), void* arg, int* ret, int count );
+
+#endif // __FFMPEG_VID_DEC_THREAD_POOL_H_
@@ -0,0 +1,270 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Dolby Laboratories
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares two hash logs written with FFMPEG_VID_DEC_OPT_HASH_LOG, e.g. of a reference build and of a deployed build
+ * decoding the same stream.
+ *
+ * usage: FFmpegVidDecHashCompare reference_log test_log [max_reports]
+ *
+ * Pictures are compared in output order. Every picture whose size, pixel format or plane hashes differ is reported
+ * (at most max_reports, default 10), followed by a summary. The exit code is 0 if the logs match, 1 if they differ and
+ * 2 if a log cannot be read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_PLANES 4
+#define MAX_LINE 512
+#define MAX_FORMAT 32
+
+#define FORMAT_MISMATCH ( 1u << MAX_PLANES )
+
+typedef struct
+{
+	long long index;
+	long long pts;
+	int width;
+	int height;
+	char format[ MAX_FORMAT ];
+	int planes;
+	unsigned long long hash[ MAX_PLANES ];
+} hash_entry_t;
+
+typedef struct
+{
+	hash_entry_t *entries;
+	size_t count;
+	size_t capacity;
+} hash_log_t;
+
+static bool parse_entry( const char* line, hash_entry_t* entry )
+{
+	int consumed = 0;
+
+	memset( entry, 0, sizeof( hash_entry_t ) );
+
+	if( sscanf( line, "%lld %lld %dx%d %31s%n", &entry->index, &entry->pts, &entry->width, &entry->height, entry->format, &consumed ) != 5 )
+	{
+		return false;
+	}
+	line += consumed;
+
+	while( entry->planes < MAX_PLANES && sscanf( line, " %llx%n", &entry->hash[ entry->planes ], &consumed ) == 1 )
+	{
+		entry->planes++;
+		line += consumed;
+	}
+
+	return entry->planes > 0;
+}
+
+static bool read_log( const char* path, hash_log_t* log )
+{
+	char line[ MAX_LINE ];
+	FILE* file;
+	long line_number = 0;
+
+	file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		fprintf( stderr, "cannot open %s\n", path );
+		return false;
+	}
+
+	while( fgets( line, sizeof( line ), file ) != NULL )
+	{
+		line_number++;
+
+		if( line[ 0 ] == '#' || line[ 0 ] == '\n' || line[ 0 ] == '\r' )
+		{
+			continue;
+		}
+
+		if( log->count == log->capacity )
+		{
+			size_t capacity = log->capacity > 0 ? log->capacity * 2 : 1024;
+			hash_entry_t* entries = ( hash_entry_t* )realloc( log->entries, capacity * sizeof( hash_entry_t ) );
+
+			if( entries == NULL )
+			{
+				fprintf( stderr, "out of memory\n" );
+				fclose( file );
+				return false;
+			}
+			log->entries = entries;
+			log->capacity = capacity;
+		}
+
+		if( parse_entry( line, &log->entries[ log->count ] ) == false )
+		{
+			fprintf( stderr, "%s:%ld: invalid line\n", path, line_number );
+			fclose( file );
+			return false;
+		}
+		log->count++;
+	}
+
+	fclose( file );
+
+	return true;
+}
+
+/*
+ * returns a bit per plane whose hash differs, FORMAT_MISMATCH if size or format differ.
+ */
+static uint32_t compare_entry( const hash_entry_t* reference, const hash_entry_t* test )
+{
+	uint32_t planes = 0;
+
+	if( reference->width != test->width || reference->height != test->height || strcmp( reference->format, test->format ) != 0 ||
+		reference->planes != test->planes )
+	{
+		return FORMAT_MISMATCH;
+	}
+
+	for( int i = 0; i < reference->planes; i++ )
+	{
+		if( reference->hash[ i ] != test->hash[ i ] )
+		{
+			planes |= 1u << i;
+		}
+	}
+
+	return planes;
+}
+
+int main( int argc, char* argv[] )
+{
+	hash_log_t reference = { NULL, 0, 0 };
+	hash_log_t test = { NULL, 0, 0 };
+	long max_reports = 10;
+	long mismatches = 0;
+	long format_mismatches = 0;
+	long plane_mismatches[ MAX_PLANES ] = { 0 };
+	size_t count;
+	int result;
+
+	if( argc < 3 || argc > 4 )
+	{
+		fprintf( stderr, "usage: %s reference_log test_log [max_reports]\n", argv[ 0 ] );
+		return 2;
+	}
+
+	if( argc == 4 )
+	{
+		max_reports = atol( argv[ 3 ] );
+	}
+
+	if( read_log( argv[ 1 ], &reference ) == false || read_log( argv[ 2 ], &test ) == false )
+	{
+		free( reference.entries );
+		free( test.entries );
+		return 2;
+	}
+
+	count = reference.count < test.count ? reference.count : test.count;
+
+	for( size_t i = 0; i < count; i++ )
+	{
+		const hash_entry_t* r = &reference.entries[ i ];
+		const hash_entry_t* t = &test.entries[ i ];
+		uint32_t planes = compare_entry( r, t );
+
+		if( planes == 0 )
+		{
+			continue;
+		}
+
+		if( mismatches < max_reports )
+		{
+			if( planes == FORMAT_MISMATCH )
+			{
+				printf( "picture %lld (pts %lld): %dx%d %s, expected %dx%d %s\n", t->index, t->pts, t->width, t->height, t->format,
+					r->width, r->height, r->format );
+			}
+			else
+			{
+				printf( "picture %lld (pts %lld): planes", t->index, t->pts );
+				for( int p = 0; p < r->planes; p++ )
+				{
+					if( ( planes & ( 1u << p ) ) != 0 )
+					{
+						printf( " %d (%016llx, expected %016llx)", p, t->hash[ p ], r->hash[ p ] );
+					}
+				}
+				printf( " differ\n" );
+			}
+		}
+
+		if( planes == FORMAT_MISMATCH )
+		{
+			format_mismatches++;
+		}
+		for( int p = 0; p < MAX_PLANES; p++ )
+		{
+			if( ( planes & ( 1u << p ) ) != 0 )
+			{
+				plane_mismatches[ p ]++;
+			}
+		}
+		mismatches++;
+	}
+
+	if( mismatches > max_reports )
+	{
+		printf( "... %ld more\n", mismatches - max_reports );
+	}
+
+	printf( "%zu pictures compared, %ld differ (%ld in size or format, planes %ld/%ld/%ld/%ld)", count, mismatches, format_mismatches,
+		plane_mismatches[ 0 ], plane_mismatches[ 1 ], plane_mismatches[ 2 ], plane_mismatches[ 3 ] );
+	if( reference.count > count )
+	{
+		printf( ", %zu only in the reference log", reference.count - count );
+	}
+	if( test.count > count )
+	{
+		printf( ", %zu only in the test log", test.count - count );
+	}
+	printf( "\n" );
+
+	result = ( mismatches == 0 && reference.count == test.count ) ? 0 : 1;
+
+	free( reference.entries );
+	free( test.entries );
+
+	return result;
+}